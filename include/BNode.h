@@ -1,23 +1,135 @@
-
 #ifndef BNODE_H
 #define BNODE_H
 
+#include "FixedVector.h"
+#include "NodeArena.h"
+#include "PackedArray.h"
+#include "PageFile.h"
+#include "SlottedKeys.h"
+#include <atomic>
 #include <cstddef>
-#include <memory>
+#include <cstdint>
+#include <string>
 #include <vector>
 
+// 向上对齐
+constexpr size_t alignUp(size_t n, size_t align) {
+  return (n + align - 1) / align * align;
+}
+
+// 节点类型标记
+enum class NodeKind : uint8_t { Inter, Leaf };
+
+// 节点布局
+// Compact：key紧随节点头存放，槽位只按8字节对齐，最省内存
+// CacheAligned：槽位从缓存行起点开始，版本锁和节点头(元数据)占开头的缓存行，
+// key从下一条缓存行起连续存放，value/children另起一条缓存行(冷数据，
+// 只在命中或选出子节点后读一个)；节点内二分只触及key所在的行，
+// 收缩后的SIMD计数窗口也不跨行
+enum class NodeLayout : uint8_t { Compact, CacheAligned };
+
+constexpr size_t CACHE_LINE = 64;
+
+// 节点内一块区域(key、value或children)的起点：offset为前面内容的结束位置，
+// CacheAligned时按槽位内的绝对位置(节点之前还有版本锁)对齐到缓存行
+constexpr size_t regionOffset(size_t offset, size_t align, NodeLayout layout) {
+  return layout == NodeLayout::CacheAligned
+             ? alignUp(NodeArena::LATCH_BYTES + offset, CACHE_LINE) -
+                   NodeArena::LATCH_BYTES
+             : alignUp(offset, align);
+}
+
+// 节点内key的存储：定长key逐个内联存放(FixedVector)，
+// std::string按槽位页布局存放(SlottedKeys)，keyBytes为单个key的最大字节数
+template <typename keyType> struct KeyStorage {
+  using type = FixedVector<keyType>;
+  static constexpr size_t align = alignof(keyType);
+  static size_t bytes(size_t capacity, size_t) {
+    return capacity * sizeof(keyType);
+  }
+  static type make(void *storage, size_t capacity, size_t) {
+    return type(storage, capacity);
+  }
+};
+
+// 整数key的压缩存储(PackedKey，见PackedArray.h)：内部节点按最宽的差值预留，
+// 叶子的key/value另行共用一块字节区(见LeafNode)
+template <typename T> struct KeyStorage<PackedKey<T>> {
+  using type = PackedArray<PackedKey<T>>;
+  static constexpr size_t align = alignof(T);
+  static size_t bytes(size_t capacity, size_t) { return capacity * sizeof(T); }
+  static type make(void *storage, size_t capacity, size_t) {
+    return type(storage, capacity * sizeof(T), capacity);
+  }
+};
+
+template <> struct KeyStorage<std::string> {
+  using type = SlottedKeys;
+  static constexpr size_t align = alignof(uint32_t);
+  static size_t bytes(size_t capacity, size_t keyBytes) {
+    return SlottedKeys::storageBytes(capacity, keyBytes);
+  }
+  static type make(void *storage, size_t capacity, size_t keyBytes) {
+    return type(storage, capacity, keyBytes);
+  }
+};
+
 // 定义模板点类
+// 节点构造在arena槽位中，keys/values/children的元素紧随节点对象内联存放
+// 不含虚函数：按kind标记分派，再static_cast到具体类型
+//
+// B-link：同层节点由next从左到右串成链表(叶子层即叶链表)，
+// 每个节点记录上界highKey(等于父节点中右侧的分隔key)：节点内的key都不大于
+// 它，右侧节点的key都不小于它(一串等值key被分裂分开时两侧都有等于它的key)，
+// 读者落到刚分裂、父节点尚未更新的节点时，key超出highKey就沿next右移
+// 叶子另有prev指向左兄弟，供反向扫描使用(只作提示，读者需确认左兄弟的next
+// 指回自己)
+//
+// 持久化：page记录节点最近一次写入数据文件的页，dirty表示此后节点内容
+// 被修改过；增量检查点重写dirty的节点及子节点换了页的内部节点
+// 懒加载时尚未读入的子节点是占位节点(loaded为false，只有page、链接和上界，
+// 按叶子构造)，第一次访问时在原槽位上读入内容
 template <typename keyType, typename valueType> class Node {
 public:
+  // 节点类型
+  const NodeKind kind;
+  // 是否有上界(每层最右的节点没有)
+  bool hasHighKey = false;
+  // 内容需要重新写出(新节点尚未写出过)
+  std::atomic<bool> dirty{true};
+  // 内容已读入(只有懒加载的占位节点为false)
+  std::atomic<bool> loaded{true};
   // 指向父节点
-  std::shared_ptr<Node> parent;
+  NodeHandle parent = NULL_HANDLE;
+  // 右兄弟
+  NodeHandle next = NULL_HANDLE;
+  // 最近一次写入的页(NULL_PAGE表示尚未写出)
+  PageId page = NULL_PAGE;
   // 关键字
-  std::vector<keyType> keys;
+  typename KeyStorage<keyType>::type keys;
+  // 上界(不含)
+  keyType highKey{};
+
+  // 落到最后一个能容纳key的节点时是否应当右移(key不小于上界)
+  bool beyondHighKey(const keyType &key) const {
+    return hasHighKey && !(key < highKey);
+  }
 
-  virtual ~Node() = default;
+  // 落到第一个可能含有key的节点时是否应当右移(key大于上界)
+  bool aboveHighKey(const keyType &key) const {
+    return hasHighKey && highKey < key;
+  }
 
   // 是否为叶子节点
-  virtual bool isLeafNode() const = 0;
+  bool isLeafNode() const { return kind == NodeKind::Leaf; }
+
+protected:
+  Node(NodeKind kind, void *keyStorage, size_t keyCapacity, size_t keyBytes)
+      : kind(kind),
+        keys(KeyStorage<keyType>::make(keyStorage, keyCapacity, keyBytes)) {}
+
+  // 只能通过具体类型析构
+  ~Node() = default;
 };
 
 // 定义内部节点类
@@ -25,10 +137,51 @@ template <typename keyType, typename valueType>
 class InterNode : public Node<keyType, valueType> {
 
 public:
-  // 存储指向子节点的指针
-  std::vector<std::shared_ptr<Node<keyType, valueType>>> children;
+  // 存储子节点句柄
+  FixedVector<NodeHandle> children;
+
+  // 槽位布局：[InterNode][keys x keyCapacity][children x (keyCapacity + 1)]
+  // (各区域的起点见NodeLayout)
+  static size_t keysOffset(NodeLayout layout) {
+    return regionOffset(sizeof(InterNode), KeyStorage<keyType>::align,
+                        layout);
+  }
+  static size_t childrenOffset(size_t keyCapacity, size_t keyBytes,
+                               NodeLayout layout) {
+    return regionOffset(keysOffset(layout) +
+                            KeyStorage<keyType>::bytes(keyCapacity, keyBytes),
+                        alignof(NodeHandle), layout);
+  }
+  static size_t slotSize(size_t keyCapacity, size_t keyBytes,
+                         NodeLayout layout) {
+    return childrenOffset(keyCapacity, keyBytes, layout) +
+           (keyCapacity + 1) * sizeof(NodeHandle);
+  }
 
-  bool isLeafNode() const override { return false; }
+  // 必须在槽位起始地址上构造
+  InterNode(size_t keyCapacity, size_t keyBytes, NodeLayout layout)
+      : Node<keyType, valueType>(
+            NodeKind::Inter,
+            reinterpret_cast<char *>(this) + keysOffset(layout), keyCapacity,
+            keyBytes),
+        children(reinterpret_cast<char *>(this) +
+                     childrenOffset(keyCapacity, keyBytes, layout),
+                 keyCapacity + 1) {}
+};
+
+// 叶子内value的存储：一般逐个内联存放；压缩叶子的value也按差值压缩，
+// 与key共用字节区
+template <typename keyType, typename valueType> struct ValueStorage {
+  using type = FixedVector<valueType>;
+  static type make(void *storage, size_t capacity) {
+    return type(storage, capacity);
+  }
+};
+
+template <typename T, typename valueType>
+struct ValueStorage<PackedKey<T>, valueType> {
+  using type = PackedArray<valueType>;
+  static type make(void *storage, size_t) { return type(storage, 0, 0); }
 };
 
 // 定义叶子结点类
@@ -36,12 +189,60 @@ template <typename keyType, typename valueType>
 class LeafNode : public Node<keyType, valueType> {
 
 public:
-  std::vector<valueType> values;
+  typename ValueStorage<keyType, valueType>::type values;
+  // 左兄弟(叶链表反向)
+  NodeHandle prev = NULL_HANDLE;
+
+  // 压缩叶子：key和value共用 keyCapacity * (key + value大小) 字节，
+  // 按字节用量装填，最多容纳的键值对个数由字节区决定
+  static constexpr bool packed = isPackedKey<keyType>;
 
-  // 指向下一个叶子结点
-  std::shared_ptr<LeafNode> next;
+  // 槽位布局：[LeafNode][keys x keyCapacity][values x keyCapacity]
+  // 压缩叶子为 [LeafNode][key差值 ->  ...  <- value差值]
+  // (各区域的起点见NodeLayout)
+  static size_t keysOffset(NodeLayout layout) {
+    return regionOffset(sizeof(LeafNode), KeyStorage<keyType>::align, layout);
+  }
+  static size_t valuesOffset(size_t keyCapacity, size_t keyBytes,
+                             NodeLayout layout) {
+    if constexpr (packed) {
+      return keysOffset(layout);
+    } else {
+      return regionOffset(keysOffset(layout) + KeyStorage<keyType>::bytes(
+                                                   keyCapacity, keyBytes),
+                          alignof(valueType), layout);
+    }
+  }
+  static size_t areaBytes(size_t keyCapacity) {
+    return keyCapacity * (sizeof(keyType) + sizeof(valueType));
+  }
+  static size_t slotSize(size_t keyCapacity, size_t keyBytes,
+                         NodeLayout layout) {
+    if constexpr (packed) {
+      return keysOffset(layout) + areaBytes(keyCapacity);
+    } else {
+      return valuesOffset(keyCapacity, keyBytes, layout) +
+             keyCapacity * sizeof(valueType);
+    }
+  }
 
-  bool isLeafNode() const override { return true; }
+  // 必须在槽位起始地址上构造
+  LeafNode(size_t keyCapacity, size_t keyBytes, NodeLayout layout)
+      : Node<keyType, valueType>(
+            NodeKind::Leaf,
+            reinterpret_cast<char *>(this) + keysOffset(layout), keyCapacity,
+            keyBytes),
+        values(ValueStorage<keyType, valueType>::make(
+            reinterpret_cast<char *>(this) +
+                valuesOffset(keyCapacity, keyBytes, layout),
+            keyCapacity)) {
+    if constexpr (packed) {
+      KeyStorage<keyType>::type::share(
+          this->keys, values,
+          reinterpret_cast<char *>(this) + keysOffset(layout),
+          areaBytes(keyCapacity));
+    }
+  }
 };
 
-#endif
\ No newline at end of file
+#endif
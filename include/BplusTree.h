@@ -3,111 +3,729 @@
 #define BPLUSTREE_H
 
 #include "BNode.h"
+#include "BufferPool.h"
+#include "EpochManager.h"
+#include "LearnedIndex.h"
+#include "NodeSearch.h"
+#include "Trace.h"
+#include "WriteAheadLog.h"
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
-#include <fstream>
+#include <cstdio>
 #include <iostream>
 #include <memory>
 #include <mutex>
+#include <new>
 #include <shared_mutex>
 #include <stdexcept>
 #include <string.h>
-#include <unordered_map>
+#include <sys/mman.h>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
 // 定义b+树类(key支持int/string，value为uint64_t)
-template <typename keyType = int, typename valueType = uint64_t>
+// fanout为0时阶数由构造函数在运行时给出；非0时阶数在编译期固定
+// (BplusTree<K, V, 64>)，节点内查找按固定容量展开
+template <typename keyType = int, typename valueType = uint64_t,
+          size_t fanout = 0>
 class BplusTree {
 private:
-  // 读写锁控制
+  // 节点槽位中紧随版本锁存放，对齐要求不能超过8字节
+  static_assert(alignof(keyType) <= 8 && alignof(valueType) <= 8,
+                "key/value alignment must not exceed 8 bytes");
+  static_assert(fanout == 0 || fanout >= 2, "fanout must be at least 2");
+
+  // 并发控制(optimistic lock coupling)：
+  // 读者不加锁，沿途记录节点版本并在使用读到的数据前校验，失败则从根重试
+  // 只改动一个叶子的写操作(不分裂、不下溢)只锁该叶子
+  // 分裂/合并/借调属于结构修改，由smoMutex串行化，并给每个被修改的节点加写锁
+  // key/value可平凡复制时读到撕裂的数据也无害，才能乐观读取；
+  // 否则(如std::string)读者持有rw_mutex共享锁，写者持有独占锁
+  static constexpr bool optimisticReads =
+      std::is_trivially_copyable_v<keyType> &&
+      std::is_trivially_copyable_v<valueType>;
+
+  // 节点内key的存储(见BNode.h)：std::string按槽位页布局紧密存放
+  using KeyArray = typename KeyStorage<keyType>::type;
+  static constexpr bool slottedKeys = std::is_same_v<keyType, std::string>;
+
+  // 压缩叶子(key为PackedKey，见PackedArray.h)：叶子的key/value按差值压缩，
+  // 按字节用量分裂/合并；内部节点的key同样压缩，仍按key个数分裂/合并
+  static constexpr bool packedLeaves = isPackedKey<keyType>;
+  static_assert(!packedLeaves || (std::is_integral_v<valueType> &&
+                                  !std::is_same_v<valueType, bool>),
+                "compressed leaves require integer values");
+
+  // 学习索引(见LearnedIndex.h)只用于整数key(含PackedKey)
+  static constexpr bool learnedKeys =
+      (std::is_integral_v<keyType> && !std::is_same_v<keyType, bool>) ||
+      packedLeaves;
+
+  // 可以写入数据文件/日志的类型：key可平凡复制或为std::string，
+  // value可平凡复制
+  static constexpr bool pagedStorage =
+      (std::is_trivially_copyable_v<keyType> || slottedKeys) &&
+      std::is_trivially_copyable_v<valueType>;
+
+  // 读写锁控制(仅用于不能乐观读取的类型)
   std::shared_mutex rw_mutex;
 
-  // 根节点
-  std::shared_ptr<Node<keyType, valueType>> root;
+  // 结构修改互斥锁
+  std::mutex smoMutex;
+
+  // 结构修改期间已加写锁的节点和待归还的节点(受smoMutex保护)
+  std::vector<NodeHandle> smoLatched;
+  std::vector<NodeHandle> smoRetired;
+
+  // 已废弃、等待无锁读者离开的节点(受smoMutex保护，见EpochManager.h)，
+  // 攒够RECLAIM_BATCH个后推进epoch，把宽限期已过的槽位归还arena
+  RetireList<NodeHandle> retiredNodes;
+  static constexpr size_t RECLAIM_BATCH = 64;
 
   // 每个节点的最大和最小键数(关键字)
   size_t maxKeys, minKeys;
 
-  // 元数据结构
+  // 单个key的最大字节数(std::string，节点按此预留字节区；定长key为其大小)
+  size_t maxKeyBytes;
+  static constexpr size_t DEFAULT_MAX_KEY_BYTES = 64;
+
+  // 叶子槽位按多少个键值对预留(压缩叶子的字节区按未压缩的键值对折算)
+  size_t leafCapacity;
+
+  // B-link模式：分裂向上传播时，每个节点改完立即解锁
+  // (读者可经右链接找到分裂出的节点)；关闭时整个结构修改期间持有全部写锁
+  bool blinkMode;
+
+  // 节点布局(见BNode.h)：CacheAligned时槽位按缓存行对齐
+  NodeLayout layout;
+
+  // 节点存储(所有节点都分配在arena的定长槽位中)
+  NodeArena arena;
+
+  // 批量查找时每个节点预取的字节数(槽位开头，覆盖版本锁、节点头和key)
+  size_t prefetchBytes;
+
+  // 根节点
+  std::atomic<NodeHandle> root;
+
+  // 预写日志(未开启时为空)：修改先作用到树上，再在walMutex内追加记录，
+  // 日志顺序因此与修改顺序一致；等待落盘在walMutex之外进行(组提交)
+  // 加锁顺序：walMutex -> rw_mutex -> smoMutex
+  std::unique_ptr<WriteAheadLog> wal;
+  std::mutex walMutex;
+  // 最后一条已作用到树上的日志记录序号(受walMutex保护)，随序列化写入文件头，
+  // 恢复时跳过序号不大于它的记录
+  uint64_t walSequence = 0;
+
+  // 增量检查点状态(受smoMutex保护)：节点的page指向storageFile中的页，
+  // 与其他文件无关；写入失败时清空storageFile，下次完整写出
+  std::string storageFile;
+  uint64_t checkpointSequence = 0;
+  // 已提交的文件头不再引用、可以分配的页
+  std::vector<PageId> freePages;
+  // 本次检查点之前被替换或释放的节点页，检查点提交后才能复用
+  std::vector<PageId> stalePages;
+
+  // 懒加载：占位节点从打开的数据文件按需读入(受smoMutex保护)，
+  // 全部读入后关闭文件；lazyPending供读者不加锁地判断是否还有占位节点
+  struct LazySource {
+    PageFile file;
+    BufferPool pool;
+    PageId pageCount;             // 文件头记录的页数
+    std::vector<bool> usedPages;  // 已被引用的页(同一页被引用两次说明损坏)
+    size_t stubs = 0;             // 尚未读入的占位节点数
+    size_t loads = 0;             // 已读入的节点数
+    bool warmed = false;          // 预热是否已开始
+    keyType warmKey{};            // 预热下一批的起点
+
+    LazySource(const std::string &path, size_t pageBytes)
+        : file(path, pageBytes, false), pool(file, POOL_PAGES) {}
+  };
+  std::unique_ptr<LazySource> lazy;
+  std::atomic<bool> lazyPending{false};
+  // 后台预热线程
+  std::thread warmer;
+  std::atomic<bool> stopWarming{false};
+
+  // 学习索引：叶子层的每次分裂/借调/合并在smoMutex内同步更新，
+  // 读者乐观读取；懒加载期间停用，全部读入后重建
+  LearnedIndex learned;
+  bool learnedEnabled = false; // 是否已启用(受smoMutex保护)
+
+  // 日志记录：[序号 u64][操作 u8][key(Clear无)][value(Insert/Modify)]
+  enum class WalOp : uint8_t { Insert = 1, Remove = 2, Modify = 3, Clear = 4 };
+
+  // 结构修改守卫：持有smoMutex，退出时释放期间加的所有节点写锁
+  class SmoGuard {
+  private:
+    BplusTree &tree;
+    std::lock_guard<std::mutex> lock;
+
+  public:
+    explicit SmoGuard(BplusTree &tree) : tree(tree), lock(tree.smoMutex) {}
+    ~SmoGuard() { tree.smoUnlatchAll(); }
+  };
+
+  // 数据文件由定长页组成：开头两页是文件头(MetaData)的两个槽位，
+  // 每个节点占一页，内部节点用页号引用子节点；读写都经过有界的BufferPool
+  // 检查点轮流写两个槽位，加载时取校验通过且序号最大的文件头
+  static constexpr uint64_t FILE_MAGIC = 0x3145455254504221ULL; // "!BPTREE1"
+  static constexpr uint32_t FILE_VERSION = 4;
+  static constexpr PageId HEADER_PAGES = 2;
+  // 最小页大小(节点较小时多个字段共用一页也不值得再拆分)
+  static constexpr size_t MIN_PAGE_SIZE = 512;
+  // 序列化/反序列化使用的页帧数
+  static constexpr size_t POOL_PAGES = 256;
+  // 后台预热每次持有smoMutex时读入的节点数
+  static constexpr size_t WARM_BATCH = 64;
+
+  // 文件头页
   struct MetaData {
-    size_t maxKeys;      // 每个节点的最大键数
-    size_t minKeys;      // 每个节点的最小键数
-    uint64_t rootOffset; // 根节点在文件中的偏移
-    int treeHeight;      // 树的高度
+    uint64_t magic;     // 文件标识
+    uint32_t version;   // 格式版本
+    uint32_t pageSize;  // 页大小
+    uint64_t maxKeys;   // 每个节点的最大键数
+    uint64_t minKeys;   // 每个节点的最小键数
+    uint32_t keySize;   // key的(最大)字节数
+    uint32_t valueSize; // value的字节数
+    PageId rootPage;      // 根节点所在页(空树为NULL_PAGE)
+    int32_t treeHeight;   // 树的高度
+    uint64_t pageCount;   // 文件页数(含文件头页)
+    uint64_t walSequence; // 已包含的最后一条日志记录序号
+    uint64_t checkpoint;  // 检查点序号(决定所在槽位)
+    uint32_t checksum;    // 整个文件头的CRC32(计算时本字段为0)
+    uint32_t leafFormat;  // 叶子格式(0为未压缩，1为差值压缩)
+  };
+
+  // 节点页：[NodePage][key区]
+  //         [values x keyCount(叶子) | children x (keyCount + 1)(内部节点)]
+  // key区：定长key为keys x keyCount；std::string为
+  // [offsets x (keyCount + 1)][key字节](与SlottedKeys的内存布局相同)；
+  // PackedKey为[压缩头][差值 x keyCount]，叶子的value区也是这样
+  // 其后各部分的位置由key区的字节数keyBytes决定
+  struct NodePage {
+    uint8_t isLeaf;
+    uint8_t reserved[3];
+    uint32_t keyCount;
+  };
+  static size_t pageKeysOffset() {
+    return alignUp(sizeof(NodePage), KeyStorage<keyType>::align);
+  }
+  static size_t pageValuesOffset(size_t keyBytes) {
+    return alignUp(pageKeysOffset() + keyBytes, alignof(valueType));
+  }
+  static size_t pageChildrenOffset(size_t keyBytes) {
+    return alignUp(pageKeysOffset() + keyBytes, alignof(PageId));
+  }
+
+  // 写出key区，返回其字节数
+  static size_t storeKeys(char *bytes, const KeyArray &keys) {
+    if constexpr (slottedKeys || packedLeaves) {
+      keys.store(bytes + pageKeysOffset());
+      return keys.storedBytes();
+    } else {
+      std::memcpy(bytes + pageKeysOffset(), keys.data(),
+                  keys.size() * sizeof(keyType));
+      return keys.size() * sizeof(keyType);
+    }
+  }
+
+  // 写出叶子的value区
+  static void storeValues(char *bytes, size_t keyBytes,
+                          const LeafNode<keyType, valueType> *leaf) {
+    if constexpr (packedLeaves) {
+      leaf->values.store(bytes + pageValuesOffset(keyBytes));
+    } else {
+      std::memcpy(bytes + pageValuesOffset(keyBytes), leaf->values.data(),
+                  leaf->values.size() * sizeof(valueType));
+    }
+  }
+
+  // 检查节点页并求key区的字节数keyBytes：key区或其后的values/children
+  // 超出页大小pageBytes时返回false(压缩叶子还要放得下叶子的字节区)
+  bool checkNodePage(const char *bytes, bool isLeaf, size_t count,
+                     size_t pageBytes, size_t &keyBytes) const {
+    if (count > (isLeaf ? leafKeyLimit() : maxKeys)) {
+      return false;
+    }
+    if constexpr (slottedKeys) {
+      keyBytes = SlottedKeys::measure(bytes + pageKeysOffset(), count,
+                                      pageBytes - pageKeysOffset(),
+                                      maxKeyBytes);
+      if (keyBytes == 0) {
+        return false;
+      }
+    } else if constexpr (packedLeaves) {
+      size_t keyWidth, valueWidth;
+      keyBytes = KeyArray::measure(bytes + pageKeysOffset(), count,
+                                   pageBytes - pageKeysOffset(), keyWidth);
+      if (keyBytes == 0 || !isLeaf) {
+        return keyBytes != 0 &&
+               pageChildrenOffset(keyBytes) + (count + 1) * sizeof(PageId) <=
+                   pageBytes;
+      }
+      size_t valuesOffset = pageValuesOffset(keyBytes);
+      return valuesOffset <= pageBytes &&
+             PackedArray<valueType>::measure(bytes + valuesOffset, count,
+                                             pageBytes - valuesOffset,
+                                             valueWidth) != 0 &&
+             count * (keyWidth + valueWidth) <=
+                 LeafNode<keyType, valueType>::areaBytes(leafCapacity);
+    } else {
+      keyBytes = count * sizeof(keyType);
+    }
+    size_t end = isLeaf
+                     ? pageValuesOffset(keyBytes) + count * sizeof(valueType)
+                     : pageChildrenOffset(keyBytes) +
+                           (count + 1) * sizeof(PageId);
+    return end <= pageBytes;
+  }
+
+  // 读入已检查过的key区(count个key，keyBytes字节)
+  static void loadKeys(KeyArray &keys, const char *bytes, size_t count,
+                       size_t keyBytes) {
+    if constexpr (slottedKeys) {
+      keys.load(bytes + pageKeysOffset(), count, keyBytes);
+    } else if constexpr (packedLeaves) {
+      keys.load(bytes + pageKeysOffset(), count);
+    } else {
+      keys.resize(count);
+      std::memcpy(keys.data(), bytes + pageKeysOffset(), keyBytes);
+    }
+  }
+
+  // 只读快照：第0块是快照头，节点块按层从根到叶依次存放，同层按key顺序，
+  // 叶子因此连续排列在文件末尾(叶链表即块号加一)；块内格式与节点页相同，
+  // 子节点用块号引用，与映射地址无关
+  static constexpr uint64_t SNAPSHOT_MAGIC = 0x31504e5354504221ULL; // 快照标识
+  static constexpr uint32_t SNAPSHOT_VERSION = 1;
+  // 写快照时每次写出的字节数
+  static constexpr size_t SNAPSHOT_BATCH_BYTES = 1 << 20;
+
+  // 快照头
+  struct SnapshotHeader {
+    uint64_t magic;     // 快照标识
+    uint32_t version;   // 格式版本
+    uint32_t blockSize; // 块大小
+    uint64_t maxKeys;   // 每个节点的最大键数
+    uint32_t keySize;   // key的字节数
+    uint32_t valueSize; // value的字节数
+    PageId rootBlock;   // 根节点块(空树为NULL_PAGE)
+    PageId firstLeaf;   // 第一个叶子块
+    PageId blockCount;  // 总块数(含快照头)
+    uint32_t reserved;
+    uint64_t keyCount; // 键值对总数
+  };
+
+  // 读入已检查过的value区
+  static void loadValues(LeafNode<keyType, valueType> *leaf, const char *bytes,
+                         size_t count, size_t keyBytes) {
+    if constexpr (packedLeaves) {
+      leaf->values.load(bytes + pageValuesOffset(keyBytes), count);
+    } else {
+      leaf->values.resize(count);
+      std::memcpy(leaf->values.data(), bytes + pageValuesOffset(keyBytes),
+                  count * sizeof(valueType));
+    }
+  }
+
+  // 页大小：容纳最满节点的最小的2的幂
+  // 压缩节点的key区多一个压缩头；压缩叶子按字节装填，页大小仍按同样度数的
+  // 未压缩叶子选取，叶子的字节区再由页大小决定(见leafSlotCapacity)
+  static size_t nodePageSize(size_t maxKeys, size_t maxKeyBytes) {
+    size_t keyBytes = KeyStorage<keyType>::bytes(maxKeys, maxKeyBytes);
+    size_t header = packedLeaves ? PackedArray<int>::HEADER_BYTES : 0;
+    size_t bytes = std::max({sizeof(MetaData), sizeof(SnapshotHeader),
+                             pageValuesOffset(keyBytes) +
+                                 maxKeys * sizeof(valueType),
+                             pageChildrenOffset(keyBytes + header) +
+                                 (maxKeys + 1) * sizeof(PageId)});
+    size_t pageSize = MIN_PAGE_SIZE;
+    while (pageSize < bytes) {
+      pageSize <<= 1;
+    }
+    return pageSize;
+  }
+
+  // 叶子槽位的键值对个数(节点允许暂时多出一个key，分裂前容纳maxKeys + 1个)
+  // 压缩叶子的字节区取一页除去页头、两个压缩头和对齐后的大小，
+  // 写出时总能放进一页
+  static size_t leafSlotCapacity(size_t maxKeys, size_t maxKeyBytes) {
+    if constexpr (packedLeaves) {
+      size_t overhead = pageKeysOffset() +
+                        2 * PackedArray<int>::HEADER_BYTES +
+                        alignof(valueType);
+      return (nodePageSize(maxKeys, maxKeyBytes) - overhead) /
+             (sizeof(keyType) + sizeof(valueType));
+    } else {
+      return maxKeys + 1;
+    }
+  }
+
+  // 槽位大小
+  static size_t nodeSlotSize(size_t maxKeys, size_t maxKeyBytes,
+                             NodeLayout layout) {
+    return std::max(LeafNode<keyType, valueType>::slotSize(
+                        leafSlotCapacity(maxKeys, maxKeyBytes), maxKeyBytes,
+                        layout),
+                    InterNode<keyType, valueType>::slotSize(
+                        maxKeys + 1, maxKeyBytes, layout));
+  }
+
+  // 叶子最多的键值对个数(压缩叶子每个key/value至少占1字节)
+  size_t leafKeyLimit() const {
+    if constexpr (packedLeaves) {
+      return LeafNode<keyType, valueType>::areaBytes(leafCapacity) / 2;
+    } else {
+      return maxKeys;
+    }
+  }
+
+  // 叶子的装填判断：未压缩叶子按key个数，压缩叶子按字节用量
+  // 再放入一个键值对后是否放得下
+  bool leafRoom(const LeafNode<keyType, valueType> *leaf, const keyType &key,
+                const valueType &value) const {
+    size_t n = leaf->keys.size() + 1;
+    if constexpr (packedLeaves) {
+      return n <= leaf->keys.capacity() &&
+             leaf->keys.bytesWith(key, n) + leaf->values.bytesWith(value, n) <=
+                 leaf->keys.areaSize();
+    } else {
+      (void)key;
+      (void)value;
+      return n <= maxKeys;
+    }
+  }
+
+  // 只剩count个键值对时是否下溢(压缩叶子按当前宽度不足字节区的1/4)
+  bool leafUnderflow(const LeafNode<keyType, valueType> *leaf,
+                     size_t count) const {
+    if constexpr (packedLeaves) {
+      size_t width = leaf->keys.elementWidth() + leaf->values.elementWidth();
+      return count * width < leaf->keys.areaSize() / 4;
+    } else {
+      (void)leaf;
+      return count < minKeys;
+    }
+  }
+
+  // 兄弟能否借出一个key给node(压缩叶子借出后不能下溢，node也要放得下)
+  bool canLend(NodeHandle sibling, NodeHandle node, bool fromLeft) const {
+    if constexpr (packedLeaves) {
+      if (getNode(node)->isLeafNode()) {
+        auto from = getLeaf(sibling);
+        size_t n = from->keys.size();
+        if (n < 2 || leafUnderflow(from, n - 1)) {
+          return false;
+        }
+        size_t i = fromLeft ? n - 1 : 0;
+        return leafRoom(getLeaf(node), from->keys.get(i),
+                        from->values.get(i));
+      }
+    }
+    (void)node;
+    (void)fromLeft;
+    return getNode(sibling)->keys.size() > minKeys;
+  }
+
+  // from能否整个并入into(只有压缩叶子可能放不下)
+  bool canMerge(NodeHandle into, NodeHandle from) const {
+    if constexpr (packedLeaves) {
+      if (getNode(into)->isLeafNode()) {
+        auto intoLeaf = getLeaf(into);
+        auto fromLeaf = getLeaf(from);
+        return intoLeaf->keys.size() + fromLeaf->keys.size() <=
+                   intoLeaf->keys.capacity() &&
+               intoLeaf->keys.bytesWith(fromLeaf->keys) +
+                       intoLeaf->values.bytesWith(fromLeaf->values) <=
+                   intoLeaf->keys.areaSize();
+      }
+    }
+    (void)into;
+    (void)from;
+    return true;
+  }
+
+  // 句柄解析(调用方已按kind判断过类型，直接static_cast)
+  Node<keyType, valueType> *getNode(NodeHandle handle) const {
+    return static_cast<Node<keyType, valueType> *>(arena.get(handle));
+  }
+  LeafNode<keyType, valueType> *getLeaf(NodeHandle handle) const {
+    return static_cast<LeafNode<keyType, valueType> *>(arena.get(handle));
+  }
+  InterNode<keyType, valueType> *getInter(NodeHandle handle) const {
+    return static_cast<InterNode<keyType, valueType> *>(arena.get(handle));
+  }
+
+  // 节点版本锁
+  VersionLatch &latchOf(NodeHandle handle) const {
+    return arena.latch(handle);
+  }
+
+  // 读/写操作的守卫：登记epoch(操作期间读到的节点槽位不会被复用)，
+  // 不能乐观读取的类型另外持有树级锁
+  template <typename Lock> struct OpGuard {
+    Lock lock;
+    EpochGuard pin;
   };
+  OpGuard<std::shared_lock<std::shared_mutex>> readGuard() {
+    if constexpr (optimisticReads) {
+      return {};
+    } else {
+      return {std::shared_lock<std::shared_mutex>(rw_mutex), {}};
+    }
+  }
+  OpGuard<std::unique_lock<std::shared_mutex>> writeGuard() {
+    if constexpr (optimisticReads) {
+      return {};
+    } else {
+      return {std::unique_lock<std::shared_mutex>(rw_mutex), {}};
+    }
+  }
+
+  // 未加锁读取时计数可能是撕裂的，截断到容量以内保证不越界
+  template <typename Vec> static size_t safeSize(const Vec &vec) {
+    return std::min(vec.size(), vec.capacity());
+  }
+
+  // 节点内定位：在前count个key中查找(定长key的内核按keyType在编译期选择，
+  // 见NodeSearch.h；std::string在槽位页上做memcmp二分；PackedKey在差值数组
+  // 上按差值宽度选择内核)
+  // 编译期阶数下，节点的key数组容量(maxKeys + 1)即为fanout
+  static size_t lowerIndex(const KeyArray &keys, size_t count,
+                           const keyType &key) {
+    if constexpr (slottedKeys || packedLeaves) {
+      return keys.lowerBound(count, key);
+    } else if constexpr (fanout != 0) {
+      return fixedNodeRank<fanout, false>(keys.data(), count, key);
+    } else {
+      return nodeLowerBound(keys.data(), count, key);
+    }
+  }
+  static size_t upperIndex(const KeyArray &keys, size_t count,
+                           const keyType &key) {
+    if constexpr (slottedKeys || packedLeaves) {
+      return keys.upperBound(count, key);
+    } else if constexpr (fanout != 0) {
+      return fixedNodeRank<fanout, true>(keys.data(), count, key);
+    } else {
+      return nodeUpperBound(keys.data(), count, key);
+    }
+  }
+  static size_t lowerIndex(const KeyArray &keys, const keyType &key) {
+    return lowerIndex(keys, keys.size(), key);
+  }
+  static size_t upperIndex(const KeyArray &keys, const keyType &key) {
+    return upperIndex(keys, keys.size(), key);
+  }
+
+  // key超过maxKeyBytes时抛出异常(定长key总是放得下)
+  void checkKeyLength(const keyType &key) const {
+    if constexpr (slottedKeys) {
+      if (key.size() > maxKeyBytes) {
+        throw std::runtime_error("Key longer than maxKeyBytes (" +
+                                 std::to_string(maxKeyBytes) + ")");
+      }
+    }
+  }
+
+  // 相邻叶子之间的分隔key(后缀截断)：std::string取右叶子最小key的最短前缀，
+  // 只要仍大于左叶子最大key就能分开两个叶子，内部节点因此存得更短、比较
+  // 更快；等值key跨叶子时无法截断，与定长key一样取右叶子最小key
+  template <typename Left, typename Right>
+  static keyType separatorKey(const Left &leftLast, const Right &rightFirst) {
+    if constexpr (slottedKeys) {
+      KeyView left = leftLast;
+      KeyView right = rightFirst;
+      if (!(left < right)) {
+        return std::string(right);
+      }
+      std::string separator(commonPrefix(left, right) + 1, '\0');
+      right.copy(&separator[0], 0, separator.size());
+      return separator;
+    } else {
+      (void)leftLast;
+      return rightFirst;
+    }
+  }
+
+  // 按kind析构节点
+  void destroyNode(NodeHandle handle) {
+    if (getNode(handle)->isLeafNode()) {
+      getLeaf(handle)->~LeafNode();
+    } else {
+      getInter(handle)->~InterNode();
+    }
+  }
 
-  // 序列化节点
-  struct SerializedNode {
-    bool isLeaf;
-    size_t keyCount;
-    std::vector<keyType> keys;      // key数组
-    std::vector<valueType> values;  // value数组(仅叶子节点)
-    std::vector<uint64_t> children; // 子节点偏移(仅内部节点)
-    uint64_t nextOffset;            // 下一个叶子节点偏移(仅叶子节点)
+  // 分配/释放节点
+  NodeHandle allocLeaf();
+  NodeHandle allocInter();
+  void freeNode(NodeHandle handle);
+
+  // 结构修改中给节点加写锁(同一节点只加一次)
+  void smoLatch(NodeHandle handle);
+
+  // 提前解锁结构修改中已改完的节点(B-link模式)
+  void smoUnlatch(NodeHandle handle);
+
+  // 结构修改结束：解锁全部节点，废弃被释放的节点并让其退休
+  void smoUnlatchAll();
+
+  // 已废弃的节点退休，宽限期过后槽位归还arena(调用方持有smoMutex)
+  void retireNode(NodeHandle handle);
+
+  // 分裂后把新节点挂到左节点右侧，维护右链接和上界
+  void linkSplit(NodeHandle left, NodeHandle right, const keyType &separator);
+
+  // 合并后接管被合并节点的右链接和上界(叶子还要更新右兄弟的反向链接)
+  void inheritLink(NodeHandle into, NodeHandle from);
+
+  // 按层重建右链接、上界和叶子的反向链接(反序列化后使用)
+  void rebuildLinks(NodeHandle root);
+
+  // 批量构建辅助：把total个元素均匀分给若干节点，每个节点不超过perNode个，
+  // 多于一个节点时每个不少于minPerNode个
+  static std::vector<size_t> evenSplit(size_t total, size_t perNode,
+                                       size_t minPerNode);
+
+  // 压缩叶子的分组：按顺序分成若干段，每段放得下一个叶子；append时左侧
+  // 叶子尽量装满(顺序追加)，否则按个数均分(给之后的插入留出空间)
+  std::vector<size_t> packedSizes(const std::vector<keyType> &keys,
+                                  const std::vector<valueType> &values,
+                                  bool append) const;
+
+  // 把叶子(调用方已加写锁)的内容换成已排序的keys/values，放不下时分成
+  // 若干个叶子挂到右侧并插入父节点，父节点溢出时照常向上分裂
+  void spreadLeaf(NodeHandle targetLeaf, const std::vector<keyType> &keys,
+                  const std::vector<valueType> &values, bool append);
+  // 压缩叶子改写value后放不下时的慢速路径
+  bool modifySpread(const keyType &key, const valueType &newValue);
+
+  // 连接同一层的节点：右链接指向下一个节点，上界为下一个节点子树的最小key
+  void linkLevel(const std::vector<NodeHandle> &level,
+                 const std::vector<keyType> &lowKeys);
+
+  // 释放整棵树(析构时使用，要求没有并发访问)
+  void clearTree();
+
+  // 逐个废弃并归还整棵树的节点(可与乐观读者并发)
+  void discardTree();
+
+  // 释放尚未发布的子树(加载失败时使用，没有读者能看到，直接归还槽位)
+  void releaseUnpublished(NodeHandle handle);
+
+  // 下降的目标：一串等值key可能跨过多个叶子，查找/修改/删除要落到第一个
+  // 含有key的叶子(First)；插入落到任何能容纳key的叶子都可以，与反向扫描的
+  // 起点一样取最后一个(Last)
+  enum class Seek : uint8_t { First, Last };
+
+  // 乐观下降到key所在的叶子，返回叶子及其版本号；校验失败返回false
+  bool descendOptimistic(const keyType &key, NodeHandle &leaf,
+                         uint64_t &version, Seek seek) const;
+
+  // 下降中是否沿右链接右移：key超出上界(本节点已分裂而父节点还没更新)；
+  // 找第一个等值key时key等于上界不算超出，但叶子中已没有不小于它的key时
+  // 剩下的等值key只在右侧
+  bool pastHighKey(NodeHandle handle, const keyType &key, Seek seek) const;
+
+  // 沿右链接移到右兄弟并取得其版本；校验失败返回false，右侧尚未读入
+  // (懒加载)时读入后同样返回false，由调用方重新下降
+  bool moveRight(NodeHandle &node, uint64_t &version) const;
+
+  // 快速路径：只锁一个叶子完成操作，需要分裂/合并时返回NeedSmo
+  enum class LeafOp : uint8_t { Done, NotFound, NeedSmo };
+  LeafOp tryInsertInLeaf(const keyType &key, const valueType &value);
+  LeafOp tryRemoveInLeaf(const keyType &key);
+
+  // 修改操作本身(不写日志)；公开接口在开启日志时额外追加记录
+  void applyInsert(const keyType &key, const valueType &value);
+  bool applyRemove(const keyType &key);
+  bool applyModify(const keyType &key, const valueType &newValue);
+  template <typename Iterator>
+  void applyBulkLoad(Iterator begin, Iterator end, double fillFactor);
+  template <typename Iterator>
+  void applySortedBatch(Iterator begin, Iterator end);
+
+  // 追加一条日志记录(调用方持有walMutex)，返回提交位置
+  uint64_t logRecord(WalOp op, const keyType &key, const valueType &value);
+
+  // 重放一条日志记录(序号不大于walSequence的跳过)
+  void replayRecord(const char *payload, size_t length);
+
+  // 批量查找：每组查询同步下降，每一轮每个查询前进一层，
+  // 并预取下一层要访问的节点，让同组查询的缓存缺失相互重叠
+  static constexpr size_t PROBE_GROUP = 16;
+  static constexpr size_t PREFETCH_LIMIT = 512;
+  enum class ProbeStage : uint8_t { Start, Child, Node, Value, Done };
+  struct Probe {
+    ProbeStage stage = ProbeStage::Start;
+    NodeHandle node = NULL_HANDLE;   // 当前节点
+    uint64_t version = 0;            // 当前节点版本
+    NodeHandle parent = NULL_HANDLE; // 选中子节点时的父节点
+    uint64_t parentVersion = 0;      // 父节点版本
+    size_t index = 0;                // 叶子中命中的下标
   };
+  void probeStep(Probe &probe, const keyType &key, valueType &result) const;
+  void multiSearchGroup(const keyType *keys, size_t count,
+                        valueType *out) const;
 
   // 叶链表头节点
   //  std::shared_ptr<LeafNode<keyType, valueType>> head;
 
-  // 寻找叶子结点
-  std::shared_ptr<LeafNode<keyType, valueType>>
-  findLeaf(std::shared_ptr<Node<keyType, valueType>> currentNode,
-           const keyType &key) const;
+  // 寻找叶子结点(调用方持有smoMutex，沿途读入占位节点)
+  NodeHandle findLeaf(NodeHandle currentNode, const keyType &key, Seek seek);
+
+  // 结构修改中找到第一个含有key的叶子并加写锁(没有该key时为key应在的叶子)
+  NodeHandle latchFirstLeaf(const keyType &key);
 
   // 插入叶子结点
-  void insertInLeaf(std::shared_ptr<LeafNode<keyType, valueType>> targetLeaf,
-                    const keyType &key, const valueType &value);
+  void insertInLeaf(NodeHandle targetLeaf, const keyType &key,
+                    const valueType &value);
 
   // 分裂叶子
-  void splitLeaf(std::shared_ptr<LeafNode<keyType, valueType>> leafNode);
+  void splitLeaf(NodeHandle leafNode);
 
   // 分裂内部
-  void splitInter(std::shared_ptr<InterNode<keyType, valueType>> interNode);
+  void splitInter(NodeHandle interNode);
 
   // 分裂根结点
-  void splitRoot(std::shared_ptr<Node<keyType, valueType>> root);
+  void splitRoot(NodeHandle root);
 
-  // 分裂后更新父亲指针
-  void
-  updateParentPointers(std::shared_ptr<InterNode<keyType, valueType>> parent,
-                       std::shared_ptr<Node<keyType, valueType>> newNode,
-                       const keyType &key);
+  // 自底向上分裂超出容量的节点(直到根)
+  void splitOverflow(NodeHandle node);
+
+  // 分裂后更新父亲指针：newNode是left分裂出的右侧节点
+  void updateParentPointers(NodeHandle parent, NodeHandle left,
+                            NodeHandle newNode, const keyType &key);
 
   // 删除后调整操作
-  bool adjust(std::shared_ptr<Node<keyType, valueType>> node,
-              std::shared_ptr<InterNode<keyType, valueType>> parent);
+  bool adjust(NodeHandle node, NodeHandle parent);
 
   // 得到左兄弟
-  std::shared_ptr<Node<keyType, valueType>>
-  getLeftSibling(std::shared_ptr<Node<keyType, valueType>> node);
+  NodeHandle getLeftSibling(NodeHandle node);
 
   // 得到右兄弟
-  std::shared_ptr<Node<keyType, valueType>>
-  getRightSibling(std::shared_ptr<Node<keyType, valueType>> node);
+  NodeHandle getRightSibling(NodeHandle node);
 
   // 从左兄弟借
-  void borrowFromL(std::shared_ptr<Node<keyType, valueType>> node,
-                   std::shared_ptr<Node<keyType, valueType>> leftSibling,
-                   std::shared_ptr<InterNode<keyType, valueType>> parent);
+  void borrowFromL(NodeHandle node, NodeHandle leftSibling, NodeHandle parent);
 
   // 从右兄弟借
-  void borrowFromR(std::shared_ptr<Node<keyType, valueType>> node,
-                   std::shared_ptr<Node<keyType, valueType>> rightSibling,
-                   std::shared_ptr<InterNode<keyType, valueType>> parent);
+  void borrowFromR(NodeHandle node, NodeHandle rightSibling,
+                   NodeHandle parent);
 
   // 与左兄弟合并
-  void mergeWithL(std::shared_ptr<Node<keyType, valueType>> node,
-                  std::shared_ptr<Node<keyType, valueType>> leftSibling,
-                  std::shared_ptr<InterNode<keyType, valueType>> parent);
+  void mergeWithL(NodeHandle node, NodeHandle leftSibling, NodeHandle parent);
 
   // 与右兄弟合并
-  void mergeWithR(std::shared_ptr<Node<keyType, valueType>> node,
-                  std::shared_ptr<Node<keyType, valueType>> rightSibling,
-                  std::shared_ptr<InterNode<keyType, valueType>> parent);
+  void mergeWithR(NodeHandle node, NodeHandle rightSibling, NodeHandle parent);
 
   // 合并后递归调整父节点
-  void adjustFather(std::shared_ptr<InterNode<keyType, valueType>> currentNode);
+  void adjustFather(NodeHandle currentNode);
 
   // 分裂函数
   /*void split(std::shared_ptr<Node<keyType, valueType>> node, const keyType
@@ -117,38 +735,166 @@ private:
   //  void merge(std::shared_ptr<Node<keyType, valueType>> node);
 
   // 打印单点
-  void printNode(const std::shared_ptr<Node<keyType, valueType>> &node,
-                 int depth) const;
+  void printNode(NodeHandle node, int depth) const;
 
   // 递归辅助函数
-  size_t countNodeHelper(const std::shared_ptr<Node<keyType, valueType>> &node);
+  size_t countNodeHelper(NodeHandle node);
+  void printSubtree(NodeHandle node, const int level);
+  int subtreeHeight(NodeHandle node) const;
 
   // 持久化辅助函数
-  void saveNodeToFile(
-      const std::shared_ptr<Node<keyType, valueType>> &node,
-      std::ofstream &outFile,
-      std::unordered_map<std::shared_ptr<Node<keyType, valueType>>, uint64_t>
-          &nodeOffsetMap,
-      uint64_t &currentOffset) const;
-
-  void loadNodeFromFile(
-      std::ifstream &inFile, uint64_t offset,
-      std::unordered_map<uint64_t, std::shared_ptr<Node<keyType, valueType>>>
-          &offsetNodeMap) const;
+  // 把节点写入清零的页(内部节点的子节点页号由childPages给出)
+  void writeNodePage(char *bytes, NodeHandle node,
+                     const PageId *childPages) const;
+
+  // 子节点先于父节点写出，返回节点所在页
+  PageId saveNodeToFile(NodeHandle node, PageFile &file, BufferPool &pool);
+
+  // depth为节点所在层(根为1)，超过文件头记录的树高说明文件损坏；
+  // usedPages记录已加载的页，同一页被引用两次也说明文件损坏
+  NodeHandle loadNodeFromFile(BufferPool &pool, PageId page, int depth,
+                              const MetaData &metaData,
+                              std::vector<bool> &usedPages);
+
+  // 文件头：按当前树填写，写入/读取序号对应的槽位
+  MetaData makeHeader(PageId rootPage, PageId pageCount);
+  static void writeHeader(BufferPool &pool, MetaData &metaData,
+                          uint64_t sequence);
+  static bool readHeader(BufferPool &pool, PageId slot, MetaData &metaData);
+
+  // 增量检查点辅助函数(调用方持有smoMutex)
+  PageId allocatePage(PageFile &file);
+  PageId checkpointNode(NodeHandle node, PageFile &file, BufferPool &pool,
+                        size_t &written);
+
+  // 完整写出整棵树，返回写出的节点页数(调用方持有walMutex、读锁和smoMutex)
+  size_t serializeLocked(const std::string &filename);
+
+  // 修改节点内容后标记，下次检查点重写(调用方持有节点写锁)
+  void markDirty(NodeHandle handle) {
+    getNode(handle)->dirty.store(true, std::memory_order_relaxed);
+  }
+
+  // 打开数据文件：取有效的文件头并检查与构造参数一致
+  MetaData readMetaData(BufferPool &pool, const PageFile &file,
+                        const std::string &filename);
+
+  // 懒加载辅助函数(调用方持有smoMutex)
+  // 为page建立占位节点
+  NodeHandle makeStub(PageId page, NodeHandle parent);
+  // 读入占位节点的内容；内部节点的子节点建成占位节点，
+  // 并与已在内存中的同层邻居互相链接
+  void loadStub(NodeHandle handle);
+  void ensureLoaded(NodeHandle handle) {
+    if (!getNode(handle)->loaded.load(std::memory_order_relaxed)) {
+      loadStub(handle);
+    }
+  }
+  // 同层的左/右邻居，沿父节点向上查找；load为false时经过未读入的节点
+  // 即返回NULL_HANDLE，否则沿途读入
+  NodeHandle neighbor(NodeHandle node, bool right, bool load);
+  // 读入全部占位节点
+  void loadAll();
+  // 全部读入后：未被引用的页可供检查点复用，关闭数据文件
+  void finishLazy();
+  // 预热：按key顺序读入至多budget个占位节点，全部读入后返回false
+  bool warmStep(size_t budget);
+  // 停止并等待后台预热线程(不能持有smoMutex)
+  void stopWarmer();
+
+  // 读者进入节点：取得版本；遇到占位节点时读入它并返回false(调用方重试)
+  bool readNode(NodeHandle handle, uint64_t &version) const;
+  // 游标遇到空的左/右链接：可能是邻居尚未读入，读入后返回true(调用方用
+  // relatchLeaf沿补上的链接继续)；确实没有邻居时返回false
+  bool resolveNeighbor(NodeHandle handle, uint64_t version, bool right) const;
+  // 邻居读入后重新进入叶子：补链接会推进叶子版本，键数不变时只有链接变化，
+  // 更新version并返回true；否则返回false(重新定位)
+  bool relatchLeaf(NodeHandle handle, size_t count, uint64_t &version) const;
+
+  // 学习索引的key：整数映射为保序的无符号数
+  static uint64_t learnedKey(const keyType &key) {
+    if constexpr (learnedKeys) {
+      return static_cast<uint64_t>(PackedCodec<keyType>::toRaw(key));
+    } else {
+      (void)key;
+      return 0;
+    }
+  }
+  // 沿叶链表重建学习索引(调用方持有smoMutex且没有占位节点)
+  void rebuildLearned();
+  // 由学习索引直接定位叶子并取得其版本；未启用或校验失败时返回false，
+  // 由调用方从根逐层下降
+  bool routeLeaf(const keyType &key, NodeHandle &leaf, uint64_t &version,
+                 Seek seek) const;
+  // 只取出叶子句柄和学习索引的版本，读叶子前后需再校验该版本(批量查找中
+  // 先预取叶子)
+  bool routeHandle(const keyType &key, NodeHandle &leaf, uint64_t &routeVersion,
+                   Seek seek) const;
+
+  // 检查阶数：编译期阶数下只能等于fanout
+  static size_t checkedOrder(size_t m) {
+    if (m < 2) {
+      throw std::runtime_error("Order must be at least 2");
+    }
+    if (fanout != 0 && m != fanout) {
+      throw std::runtime_error("Order must equal the compile-time fanout (" +
+                               std::to_string(fanout) + ")");
+    }
+    return m;
+  }
 
 public:
-  explicit BplusTree(size_t m)
-      : root(nullptr), maxKeys(m - 1), minKeys((m + 1) / 2 - 1) {}
+  // maxKeyBytes只对std::string key有效：单个key的最大字节数，
+  // 节点按key个数乘以它预留字节区
+  // 编译期阶数可省略m(BplusTree<K, V, 64> tree;)
+  // layout为CacheAligned时节点内每块区域都从缓存行起点开始(多占对齐空白)
+  explicit BplusTree(size_t m = fanout, bool blinkMode = true,
+                     size_t maxKeyBytes = DEFAULT_MAX_KEY_BYTES,
+                     NodeLayout layout = NodeLayout::Compact)
+      : maxKeys(checkedOrder(m) - 1), minKeys((m + 1) / 2 - 1),
+        maxKeyBytes(slottedKeys ? maxKeyBytes : sizeof(keyType)),
+        leafCapacity(leafSlotCapacity(m - 1, this->maxKeyBytes)),
+        blinkMode(blinkMode), layout(layout),
+        arena(nodeSlotSize(m - 1, this->maxKeyBytes, layout),
+              layout == NodeLayout::CacheAligned ? CACHE_LINE
+                                                 : NodeArena::SLOT_ALIGN),
+        prefetchBytes(std::min<size_t>(arena.slotSize(), PREFETCH_LIMIT)),
+        root(NULL_HANDLE) {}
+
+  ~BplusTree() {
+    stopWarmer();
+    clearTree();
+  }
+
+  BplusTree(const BplusTree &) = delete;
+  BplusTree &operator=(const BplusTree &) = delete;
 
   // 插入操作
   void insert(const keyType &key, const valueType &value);
 
+  // 批量构建：由按key非降序排列的键值对区间自底向上构建整棵树(替换原有内容)
+  // 不分裂、不逐key下降、不逐key加锁；fillFactor为节点装填比例(0, 1]，
+  // 预留空位可以减少之后插入时的分裂
+  template <typename Iterator>
+  void bulkLoad(Iterator begin, Iterator end, double fillFactor = 1.0);
+
+  // 批量插入：先按key排序(sorted为true时要求输入已按key非降序排列)，
+  // 每个目标叶子只下降一次，落在该叶子的key一次归并，溢出时一次分成若干叶子；
+  // 整批只加一次锁，效果与逐个insert相同(等值key同样保留)
+  template <typename Iterator>
+  void insertBatch(Iterator begin, Iterator end, bool sorted = false);
+
   // 删除操作
   bool remove(const keyType &key);
 
   // 搜索单个键
   valueType search(const keyType &key);
 
+  // 批量搜索：out[i]为keys[i]对应的值(不存在时为默认值，与search一致)
+  // 多个查询按层交错推进并预取子节点，树大于缓存时吞吐远高于逐个search
+  void multiSearch(const std::vector<keyType> &keys,
+                   std::vector<valueType> &out);
+
   // 更改单个键
   bool modify(const keyType &key, const valueType &newValue);
 
@@ -156,330 +902,1332 @@ public:
   std::vector<std::pair<keyType, valueType>>
   rangeSearch(const keyType &startKey, const keyType &endKey);
 
+  // 正向游标：沿叶链表按key升序流式读取，结果直接写入调用方的变量/缓冲区
+  // 每次调用只在读取期间乐观校验所在叶子(不能乐观读取的类型期间持有共享锁)，
+  // 两次调用之间树可以被修改：叶子变化后从上次返回的key之后重新定位
+  // (与上次返回的key相等的重复key此时会被跳过)
+  class Cursor {
+  private:
+    BplusTree &tree;
+    NodeHandle leaf = NULL_HANDLE; // 当前叶子(空表示需要重新定位)
+    uint64_t version = 0;          // 当前叶子版本
+    size_t pos = 0;                // 下一个要返回的下标
+    bool finished = true;          // 已到末尾或越过上界
+    bool hasLast = false;          // 是否已返回过键值对
+    keyType seekKey{};             // 起始key
+    keyType lastKey{};             // 上次返回的key
+    bool bounded = false;          // 是否有上界
+    keyType endKey{};              // 上界(含)
+
+    // 定位到起始key或上次返回的key之后
+    void locate();
+
+  public:
+    explicit Cursor(BplusTree &tree) : tree(tree) {}
+
+    // 定位到第一个 >= key 的位置(无上界)
+    void seek(const keyType &key);
+
+    // 定位到第一个 >= key 的位置，只返回 <= endKey 的键值对
+    void seek(const keyType &key, const keyType &endKey);
+
+    // 读取下一个键值对，已结束时返回false
+    bool next(keyType &key, valueType &value);
+
+    // 最多读取n个键值对写入keys/values，返回实际个数(0表示已结束)
+    size_t nextN(keyType *keys, valueType *values, size_t n);
+  };
+
+  // 反向范围查找：按key降序返回[startKey, endKey]内的键值对
+  std::vector<std::pair<keyType, valueType>>
+  reverseRangeSearch(const keyType &startKey, const keyType &endKey);
+
+  // 反向游标：沿叶子的prev按key降序流式读取(如"X之前最近的N个")
+  // 左移时确认左兄弟仍以next指回当前叶子，否则从上次返回的key之前重新定位，
+  // 其余约定与Cursor相同
+  class ReverseCursor {
+  private:
+    BplusTree &tree;
+    NodeHandle leaf = NULL_HANDLE; // 当前叶子(空表示需要重新定位)
+    uint64_t version = 0;          // 当前叶子版本
+    size_t pos = 0;                // 下标pos之前的键值对尚未返回
+    bool finished = true;          // 已到开头或越过下界
+    bool hasLast = false;          // 是否已返回过键值对
+    keyType seekKey{};             // 起始key
+    keyType lastKey{};             // 上次返回的key
+    bool bounded = false;          // 是否有下界
+    keyType lowKey{};              // 下界(含)
+
+    // 定位到起始key或上次返回的key之前
+    void locate();
+
+  public:
+    explicit ReverseCursor(BplusTree &tree) : tree(tree) {}
+
+    // 定位到最后一个 <= key 的位置(无下界)
+    void seek(const keyType &key);
+
+    // 定位到最后一个 <= key 的位置，只返回 >= lowKey 的键值对
+    void seek(const keyType &key, const keyType &lowKey);
+
+    // 读取前一个键值对，已结束时返回false
+    bool next(keyType &key, valueType &value);
+
+    // 最多读取n个键值对(降序)写入keys/values，返回实际个数(0表示已结束)
+    size_t nextN(keyType *keys, valueType *values, size_t n);
+  };
+
   // 中序遍历
   void inorderTraversal();
 
   // 打印b+树
-  void printBplusTree(std::shared_ptr<Node<keyType, valueType>> node,
-                      const int level);
+  void printBplusTree(NodeHandle node, const int level);
 
   // 获取树的高度
-  int getTreeHeight(std::shared_ptr<Node<keyType, valueType>> node);
+  int getTreeHeight(NodeHandle node);
 
   // 统计节点数量
   size_t countNode();
 
-  // 持久化接口
-  // 序列化
-  void serialize(const std::string &filename);
+  // 节点存储占用的字节数
+  size_t memoryUsage() const { return arena.reservedBytes(); }
+
+  // 节点分配统计：合并/删除释放的节点退休，宽限期过后进入arena的空闲链表，
+  // 之后的分裂优先复用这些槽位(命中)，空闲链表为空时才取用新槽位(未命中)
+  struct NodeAllocStats {
+    uint64_t hits;       // 复用已释放槽位的分配
+    uint64_t misses;     // 取用新槽位的分配
+    uint64_t releases;   // 归还arena的节点
+    size_t liveNodes;    // 占用槽位的节点数(含退休的)
+    size_t freeSlots;    // 空闲链表中的槽位数
+    size_t retiredNodes; // 已退休、等待宽限期结束的节点数
+
+    double hitRate() const {
+      uint64_t total = hits + misses;
+      return total == 0 ? 0.0 : static_cast<double>(hits) / total;
+    }
+  };
+  NodeAllocStats allocStats();
 
-  // 反序列化
-  void deserialize(const std::string &filename);
+  // 学习索引(只用于整数key)：沿叶链表为各叶子的下界拟合分段线性模型，
+  // 每段的预测误差不超过maxError个叶子；之后的查找由模型直接定位叶子，
+  // 不再逐层经过内部节点。叶子的分裂/借调/合并同步更新模型，内部节点照常
+  // 维护。懒加载打开的树先读入全部节点
+  void enableLearnedIndex(size_t maxError = LearnedIndex::DEFAULT_MAX_ERROR);
+  void disableLearnedIndex();
 
-  // 获取root
-  inline std::shared_ptr<Node<keyType, valueType>> getRoot() {
-    std::shared_lock<std::shared_mutex> read_lock(rw_mutex);
-    return root;
-  }
-};
+  // 学习索引的段数(未启用时为0)
+  size_t learnedSegments() const { return learned.segmentCount(); }
 
-// 寻找叶子结点
-template <typename keyType, typename valueType>
-inline std::shared_ptr<LeafNode<keyType, valueType>>
-BplusTree<keyType, valueType>::findLeaf(
-    std::shared_ptr<Node<keyType, valueType>> currentNode,
-    const keyType &key) const {
+  // 持久化接口
+  // 序列化(完整写出)
+  void serialize(const std::string &filename);
 
-  // 判断是否为叶子结点
-  if (currentNode->isLeafNode()) {
-    return std::dynamic_pointer_cast<LeafNode<keyType, valueType>>(currentNode);
-  }
+  // 增量检查点：只写出上次serialize/checkpoint/deserialize以来修改过的节点，
+  // 新页不覆盖旧页，最后写入另一个文件头槽位完成提交，中途崩溃时
+  // 文件仍是上一个检查点；filename不是当前数据文件时退化为serialize
+  // 返回写出的节点页数
+  size_t checkpoint(const std::string &filename);
 
-  // 内部节点需要遍历
-  else {
-    std::shared_ptr<InterNode<keyType, valueType>> interNode =
-        std::dynamic_pointer_cast<InterNode<keyType, valueType>>(currentNode);
+  // 反序列化
+  void deserialize(const std::string &filename);
 
-    // key有序排列
-    for (size_t i = 0; i < interNode->keys.size(); ++i) {
-      if (key < interNode->keys[i]) {
-        return findLeaf(interNode->children[i], key);
-      }
+  // 懒加载打开：只读入文件头和根节点，其余节点在第一次访问时读入，
+  // 打开耗时与树的大小无关；warmInBackground为true时由后台线程按key顺序
+  // 读入其余节点。全部读入之前数据文件保持打开，
+  // serialize/saveSnapshot等遍历整棵树的操作会先读入全部节点
+  void deserializeLazy(const std::string &filename,
+                       bool warmInBackground = false);
+
+  // 是否已读入全部节点
+  bool fullyLoaded() const { return !lazyPending.load(); }
+
+  // 写出只读快照(先写临时文件，刷盘后改名，已打开的快照不受影响)
+  void saveSnapshot(const std::string &filename);
+
+  // 预写日志
+  // 打开(或创建)日志，先把比当前树新的记录重放到树上，返回重放的记录数；
+  // 之后insert/remove/modify/bulkLoad/insertBatch返回前其日志记录已落盘，
+  // 并发写者共享fsync。恢复流程：deserialize最近的文件，再openWal
+  // serialize成功后清空日志。打开/关闭不能与写操作并发
+  size_t openWal(const std::string &path);
+  void closeWal();
+
+  // 日志的fsync次数(未开启时为0)
+  uint64_t walSyncs() { return wal ? wal->syncs() : 0; }
+
+  // 只读快照：mmap映射saveSnapshot写出的文件，不做反序列化，原地查找
+  // 打开只读取快照头，节点由操作系统按需换入；多个进程打开同一快照时
+  // 共享页缓存。快照与树实例无关，任意度数写出的快照都可以打开
+  class Snapshot {
+  private:
+    const char *base = nullptr; // 映射起始地址
+    size_t length = 0;          // 映射长度
+    SnapshotHeader header{};
+
+    const char *block(PageId id) const {
+      return base + static_cast<size_t>(id) * header.blockSize;
     }
 
-    // 大于所有key
-    return findLeaf(interNode->children[interNode->children.size() - 1], key);
-  }
+    // 下降到key所在的叶子块(空快照返回NULL_PAGE)
+    PageId findLeaf(const keyType &key) const;
 
-  // 异常情况
-  return nullptr;
-}
+  public:
+    explicit Snapshot(const std::string &filename);
+    ~Snapshot();
 
-// 插入叶子结点
-template <typename keyType, typename valueType>
-inline void BplusTree<keyType, valueType>::insertInLeaf(
-    std::shared_ptr<LeafNode<keyType, valueType>> targetLeaf,
-    const keyType &key, const valueType &value) {
+    Snapshot(const Snapshot &) = delete;
+    Snapshot &operator=(const Snapshot &) = delete;
 
-  // 查找插入位置
-  // std::cout << "keys.size(): " << targetLeaf->keys.size()
-  //          << ", values.size(): " << targetLeaf->values.size() << "\n";
-  auto it =
-      std::lower_bound(targetLeaf->keys.begin(), targetLeaf->keys.end(), key);
-  size_t pos = std::distance(targetLeaf->keys.begin(), it);
-  // std::cout << "Insert position: " << pos << "\n";
+    // 键值对总数
+    size_t size() const { return header.keyCount; }
 
-  // 插入新的键值对
-  targetLeaf->keys.insert(it, key);
-  targetLeaf->values.insert(targetLeaf->values.begin() + pos, value);
-}
+    // 查找，不存在时返回默认构造值(与BplusTree::search一致)
+    valueType search(const keyType &key) const;
 
-// 分裂叶子
-template <typename keyType, typename valueType>
-inline void BplusTree<keyType, valueType>::splitLeaf(
-    std::shared_ptr<LeafNode<keyType, valueType>> leafNode) {
+    // 范围查找：沿连续的叶子块顺序读取，到endKey即停止
+    std::vector<std::pair<keyType, valueType>>
+    rangeSearch(const keyType &startKey, const keyType &endKey) const;
+  };
 
-  size_t midIndex = leafNode->keys.size() / 2;
+  // 冻结的只读树：freeze()沿叶链表线性遍历一次生成，与原树无关
+  // 叶子层：全部键值对按key顺序存入连续的keys/values数组，每BLOCK个为一块；
+  // 内部层：各块的最小key按Eytzinger(层序)排列在一个数组中，位置k的左右
+  // 孩子为2k、2k+1，下降只做下标运算、不追指针，并预取几层之后的位置；
+  // 选出块后在块内查找。范围查找在keys/values上顺序读取
+  class Frozen {
+  private:
+    // 每块的key数：整数key为一条缓存行
+    static constexpr size_t BLOCK =
+        simdSearchable<keyType> ? searchWindow<keyType>() : 16;
+
+    std::vector<keyType> keys;
+    std::vector<valueType> values;
+    std::vector<keyType> index;  // 各块最小key(Eytzinger顺序，从下标1开始)
+    std::vector<size_t> blockOf; // index[k]对应的块号
+
+    // 按中序把第i块起的最小key填入以k为根的子树，返回下一个块号
+    size_t fillIndex(size_t k, size_t i);
+
+    // 第一个 >= key 的下标
+    size_t lowerBound(const keyType &key) const;
+
+    friend class BplusTree;
+
+  public:
+    // 键值对总数
+    size_t size() const { return keys.size(); }
+
+    // 占用的字节数(keys/values/索引数组)
+    size_t memoryUsage() const {
+      return keys.capacity() * sizeof(keyType) +
+             values.capacity() * sizeof(valueType) +
+             index.capacity() * sizeof(keyType) +
+             blockOf.capacity() * sizeof(size_t);
+    }
 
-  // 将后半部分移入新的叶子结点,前半部分保留
-  auto newLeaf = std::make_shared<LeafNode<keyType, valueType>>();
-  newLeaf->keys = std::vector<keyType>(leafNode->keys.begin() + midIndex,
-                                       leafNode->keys.end());
-  newLeaf->values = std::vector<valueType>(leafNode->values.begin() + midIndex,
-                                           leafNode->values.end());
-  leafNode->keys.resize(midIndex);
-  leafNode->values.resize(midIndex);
+    // 查找，不存在时返回默认构造值(与BplusTree::search一致)
+    valueType search(const keyType &key) const;
 
-  // 更新相应的指针结构
-  newLeaf->parent = leafNode->parent;
-  newLeaf->next = leafNode->next;
-  leafNode->next = newLeaf;
+    // 范围查找 [startKey, endKey]
+    std::vector<std::pair<keyType, valueType>>
+    rangeSearch(const keyType &startKey, const keyType &endKey) const;
+  };
 
-  // 将新节点插入父节点
-  std::shared_ptr<InterNode<keyType, valueType>> parent =
-      std::dynamic_pointer_cast<InterNode<keyType, valueType>>(
-          leafNode->parent);
-  updateParentPointers(parent, newLeaf, newLeaf->keys.front());
-}
+  // 冻结：沿叶链表复制出只读的Frozen(之后原树的修改不影响它)
+  Frozen freeze();
 
-// 分裂内部
-template <typename keyType, typename valueType>
-inline void BplusTree<keyType, valueType>::splitInter(
-    std::shared_ptr<InterNode<keyType, valueType>> interNode) {
+  // 获取root
+  inline NodeHandle getRoot() {
+    auto read_lock = readGuard();
+    return root;
+  }
+};
 
-  size_t midIndex = interNode->keys.size() / 2;
-  keyType midKey = interNode->keys[midIndex];
+// 分配叶子结点
+template <typename keyType, typename valueType, size_t fanout>
+inline NodeHandle BplusTree<keyType, valueType, fanout>::allocLeaf() {
+  NodeHandle handle = arena.allocate();
+  new (arena.get(handle))
+      LeafNode<keyType, valueType>(leafCapacity, maxKeyBytes, layout);
+  return handle;
+}
 
-  // 分开存储
-  auto newInter = std::make_shared<InterNode<keyType, valueType>>();
-  newInter->keys = std::vector<keyType>(interNode->keys.begin() + midIndex + 1,
-                                        interNode->keys.end());
-  newInter->children = std::vector<std::shared_ptr<Node<keyType, valueType>>>(
-      interNode->children.begin() + midIndex + 1, interNode->children.end());
-  interNode->keys.resize(midIndex);
-  interNode->children.resize(midIndex + 1);
-  newInter->parent = interNode->parent;
+// 分配内部节点
+template <typename keyType, typename valueType, size_t fanout>
+inline NodeHandle BplusTree<keyType, valueType, fanout>::allocInter() {
+  NodeHandle handle = arena.allocate();
+  new (arena.get(handle))
+      InterNode<keyType, valueType>(maxKeys + 1, maxKeyBytes, layout);
+  return handle;
+}
 
-  // 更新子节点的父指针
-  for (auto &child : newInter->children) {
-    child->parent = newInter;
+// 析构节点，结构修改结束时再废弃并退休
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::freeNode(NodeHandle handle) {
+  smoLatch(handle);
+  if (getNode(handle)->page != NULL_PAGE) {
+    stalePages.push_back(getNode(handle)->page);
   }
+  destroyNode(handle);
+  smoRetired.push_back(handle);
+}
 
-  // 更新父指针结构
-  std::shared_ptr<InterNode<keyType, valueType>> parent =
-      std::dynamic_pointer_cast<InterNode<keyType, valueType>>(
-          interNode->parent);
-  updateParentPointers(parent, newInter, midKey);
+// 结构修改中给节点加写锁
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::smoLatch(NodeHandle handle) {
+  if (std::find(smoLatched.begin(), smoLatched.end(), handle) !=
+      smoLatched.end()) {
+    return;
+  }
+  latchOf(handle).lock();
+  smoLatched.push_back(handle);
+  // 结构修改只改动加了写锁的节点
+  markDirty(handle);
 }
 
-// 分裂根结点
-template <typename keyType, typename valueType>
-inline void BplusTree<keyType, valueType>::splitRoot(
-    std::shared_ptr<Node<keyType, valueType>> root) {
+// 提前解锁
+template <typename keyType, typename valueType, size_t fanout>
+inline void
+BplusTree<keyType, valueType, fanout>::smoUnlatch(NodeHandle handle) {
+  auto it = std::find(smoLatched.begin(), smoLatched.end(), handle);
+  if (it != smoLatched.end()) {
+    smoLatched.erase(it);
+    latchOf(handle).unlock();
+  }
+}
 
-  // 根节点为叶子结点
-  if (root->isLeafNode()) {
+// 结构修改结束
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::smoUnlatchAll() {
+  for (NodeHandle handle : smoLatched) {
+    if (std::find(smoRetired.begin(), smoRetired.end(), handle) !=
+        smoRetired.end()) {
+      latchOf(handle).unlockObsolete();
+    } else {
+      latchOf(handle).unlock();
+    }
+  }
+  // 废弃标记已对读者可见后槽位才能退休
+  for (NodeHandle handle : smoRetired) {
+    retireNode(handle);
+  }
+  smoLatched.clear();
+  smoRetired.clear();
+}
 
-    auto leafRoot =
-        std::dynamic_pointer_cast<LeafNode<keyType, valueType>>(root);
-    size_t midIndex = leafRoot->keys.size() / 2;
+// 节点退休：仍在读它的无锁读者离开后槽位才归还arena
+template <typename keyType, typename valueType, size_t fanout>
+inline void
+BplusTree<keyType, valueType, fanout>::retireNode(NodeHandle handle) {
+  retiredNodes.retire(handle);
+  if (retiredNodes.size() >= RECLAIM_BATCH) {
+    retiredNodes.reclaim([this](NodeHandle slot) { arena.release(slot); });
+  }
+}
 
-    // 创建一个新的叶子节点
-    auto newLeaf = std::make_shared<LeafNode<keyType, valueType>>();
-    newLeaf->keys = std::vector<keyType>(leafRoot->keys.begin() + midIndex,
-                                         leafRoot->keys.end());
-    newLeaf->values = std::vector<valueType>(
-        leafRoot->values.begin() + midIndex, leafRoot->values.end());
-    leafRoot->keys.resize(midIndex);
-    leafRoot->values.resize(midIndex);
+// 释放整棵树
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::clearTree() {
+
+  // 元素需要析构时逐个析构节点，否则直接整体归还chunk
+  if constexpr (!std::is_trivially_destructible_v<keyType> ||
+                !std::is_trivially_destructible_v<valueType>) {
+    if (root != NULL_HANDLE) {
+      std::vector<NodeHandle> stack = {root};
+      while (!stack.empty()) {
+        NodeHandle handle = stack.back();
+        stack.pop_back();
+        if (!getNode(handle)->isLeafNode()) {
+          for (NodeHandle child : getInter(handle)->children) {
+            stack.push_back(child);
+          }
+        }
+        destroyNode(handle);
+      }
+    }
+  }
 
-    // 更新叶子节点的指针
-    newLeaf->next = leafRoot->next;
-    leafRoot->next = newLeaf;
-    newLeaf->parent = nullptr;
-    leafRoot->parent = nullptr;
+  retiredNodes.clear();
+  arena.clear();
+  root = NULL_HANDLE;
+}
 
-    // 创建新的根节点
-    auto newRoot = std::make_shared<InterNode<keyType, valueType>>();
-    newRoot->keys.push_back(newLeaf->keys.front());
-    newRoot->children.push_back(leafRoot);
-    newRoot->children.push_back(newLeaf);
+// 分裂后链接新节点：新节点继承原上界和右兄弟，左节点以分隔key为上界
+// 新节点先填好，再由(已加锁的)左节点指向它
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::linkSplit(
+    NodeHandle left, NodeHandle right, const keyType &separator) {
+  auto leftNode = getNode(left);
+  auto rightNode = getNode(right);
+  rightNode->hasHighKey = leftNode->hasHighKey;
+  rightNode->highKey = leftNode->highKey;
+  rightNode->next = leftNode->next;
+  leftNode->hasHighKey = true;
+  leftNode->highKey = separator;
+  leftNode->next = right;
+
+  // 叶子同时维护反向链接和学习索引
+  if (rightNode->isLeafNode()) {
+    getLeaf(right)->prev = left;
+    if (rightNode->next != NULL_HANDLE) {
+      getLeaf(rightNode->next)->prev = right;
+    }
+    learned.insert(left, learnedKey(separator), right);
+  }
+}
 
-    // 更新子节点的父指针
-    leafRoot->parent = newRoot;
-    newLeaf->parent = newRoot;
+// 合并后接管右链接和上界
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::inheritLink(
+    NodeHandle into, NodeHandle from) {
+  auto intoNode = getNode(into);
+  auto fromNode = getNode(from);
+  // 被合并叶子的下界即into原来的上界
+  if (intoNode->isLeafNode()) {
+    learned.erase(learnedKey(intoNode->highKey), from);
+  }
+  intoNode->hasHighKey = fromNode->hasHighKey;
+  intoNode->highKey = fromNode->highKey;
+  intoNode->next = fromNode->next;
 
-    // 更新树的根节点
-    this->root = newRoot;
+  if (intoNode->isLeafNode() && intoNode->next != NULL_HANDLE) {
+    getLeaf(intoNode->next)->prev = into;
   }
-  // 根节点为内部节点
-  else {
+}
 
-    auto interRoot =
-        std::dynamic_pointer_cast<InterNode<keyType, valueType>>(root);
-    size_t midIndex = interRoot->keys.size() / 2;
+// 按层重建右链接和上界：子节点i的上界为父节点的keys[i]，最后一个继承父节点的
+template <typename keyType, typename valueType, size_t fanout>
+inline void
+BplusTree<keyType, valueType, fanout>::rebuildLinks(NodeHandle root) {
+  if (root == NULL_HANDLE) {
+    return;
+  }
+  getNode(root)->hasHighKey = false;
+  getNode(root)->next = NULL_HANDLE;
+
+  std::vector<NodeHandle> level = {root};
+  while (!getNode(level.front())->isLeafNode()) {
+    std::vector<NodeHandle> below;
+    for (NodeHandle handle : level) {
+      auto interNode = getInter(handle);
+      for (size_t i = 0; i < interNode->children.size(); ++i) {
+        auto child = getNode(interNode->children[i]);
+        if (i < interNode->keys.size()) {
+          child->hasHighKey = true;
+          child->highKey = interNode->keys[i];
+        } else {
+          child->hasHighKey = interNode->hasHighKey;
+          child->highKey = interNode->highKey;
+        }
+        below.push_back(interNode->children[i]);
+      }
+    }
+    for (size_t i = 0; i < below.size(); ++i) {
+      getNode(below[i])->next =
+          i + 1 < below.size() ? below[i + 1] : NULL_HANDLE;
+    }
+    level.swap(below);
+  }
 
-    // 创建一个新的内部节点
-    auto newInter = std::make_shared<InterNode<keyType, valueType>>();
+  // 叶子层的反向链接
+  for (size_t i = 0; i < level.size(); ++i) {
+    getLeaf(level[i])->prev = i > 0 ? level[i - 1] : NULL_HANDLE;
+  }
+}
 
-    // 分开存储
-    newInter->keys = std::vector<keyType>(
-        interRoot->keys.begin() + midIndex + 1, interRoot->keys.end());
-    newInter->children = std::vector<std::shared_ptr<Node<keyType, valueType>>>(
-        interRoot->children.begin() + midIndex + 1, interRoot->children.end());
+// 均匀分配
+template <typename keyType, typename valueType, size_t fanout>
+inline std::vector<size_t> BplusTree<keyType, valueType, fanout>::evenSplit(
+    size_t total, size_t perNode, size_t minPerNode) {
+  size_t count = (total + perNode - 1) / perNode;
+  if (count > 1) {
+    count = std::max<size_t>(1, std::min(count, total / minPerNode));
+  }
+  std::vector<size_t> sizes(count, total / count);
+  for (size_t i = 0; i < total % count; ++i) {
+    ++sizes[i];
+  }
+  return sizes;
+}
 
-    // 更新新内部节点父指针
-    for (auto &child : newInter->children) {
-      child->parent = newInter;
+// 压缩叶子分组
+template <typename keyType, typename valueType, size_t fanout>
+inline std::vector<size_t> BplusTree<keyType, valueType, fanout>::packedSizes(
+    const std::vector<keyType> &keys, const std::vector<valueType> &values,
+    bool append) const {
+  size_t area = LeafNode<keyType, valueType>::areaBytes(leafCapacity);
+  size_t limit = leafKeyLimit();
+  size_t total = keys.size();
+
+  // 从first起能放进一个叶子的最多个数(范围只增不减，字节数随个数单调)
+  auto greedy = [&](size_t first) {
+    PackedRange<keyType> keyRange;
+    PackedRange<valueType> valueRange;
+    size_t n = 0;
+    for (size_t i = first; i < total && n < limit; ++i, ++n) {
+      auto nextKeys = keyRange.with(keys[i]);
+      auto nextValues = valueRange.with(values[i]);
+      if (n > 0 && nextKeys.bytes(n + 1) + nextValues.bytes(n + 1) > area) {
+        break;
+      }
+      keyRange = nextKeys;
+      valueRange = nextValues;
     }
+    return n;
+  };
+  std::vector<size_t> sizes;
+  for (size_t first = 0; first < total; first += sizes.back()) {
+    sizes.push_back(greedy(first));
+  }
+  if (append || sizes.size() <= 1) {
+    return sizes;
+  }
 
-    // 创建新根结点
-    auto newRoot = std::make_shared<InterNode<keyType, valueType>>();
-
-    // 提升原节点最后一个key作为新跟节点的key
-    newRoot->keys.push_back(interRoot->keys[midIndex]);
-    interRoot->keys.resize(midIndex);
-    interRoot->children.resize(midIndex + 1);
+  // 按个数均分成同样多的叶子，放不下时再多分一个，仍放不下就按贪心的结果
+  auto fits = [&](size_t first, size_t n) {
+    PackedRange<keyType> keyRange;
+    PackedRange<valueType> valueRange;
+    for (size_t i = first; i < first + n; ++i) {
+      keyRange = keyRange.with(keys[i]);
+      valueRange = valueRange.with(values[i]);
+    }
+    return n <= limit && keyRange.bytes(n) + valueRange.bytes(n) <= area;
+  };
+  for (size_t parts = sizes.size(); parts <= std::min(sizes.size() + 1, total);
+       ++parts) {
+    std::vector<size_t> even(parts, total / parts);
+    for (size_t i = 0; i < total % parts; ++i) {
+      ++even[i];
+    }
+    bool ok = true;
+    for (size_t i = 0, first = 0; i < parts && ok; first += even[i++]) {
+      ok = fits(first, even[i]);
+    }
+    if (ok) {
+      return even;
+    }
+  }
+  return sizes;
+}
 
-    newRoot->children.push_back(interRoot);
-    newRoot->children.push_back(newInter);
+// 连接同一层
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::linkLevel(
+    const std::vector<NodeHandle> &level, const std::vector<keyType> &lowKeys) {
+  for (size_t i = 0; i < level.size(); ++i) {
+    auto node = getNode(level[i]);
+    if (i + 1 < level.size()) {
+      node->next = level[i + 1];
+      node->hasHighKey = true;
+      node->highKey = lowKeys[i + 1];
+    } else {
+      node->next = NULL_HANDLE;
+      node->hasHighKey = false;
+    }
+    if (node->isLeafNode()) {
+      getLeaf(level[i])->prev = i > 0 ? level[i - 1] : NULL_HANDLE;
+    }
+  }
+}
 
-    // 更新子节点父指针
-    interRoot->parent = newRoot;
-    newInter->parent = newRoot;
+// 重建学习索引
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::rebuildLearned() {
+  std::vector<uint64_t> lows;
+  std::vector<NodeHandle> leaves;
+  NodeHandle node = root;
+  while (node != NULL_HANDLE && !getNode(node)->isLeafNode()) {
+    node = getInter(node)->children.front();
+  }
 
-    // 更新树的根结点
-    this->root = newRoot;
+  // 第一个叶子的下界为最小值，其余为左邻居的上界
+  uint64_t low = 0;
+  while (node != NULL_HANDLE) {
+    auto currentNode = getNode(node);
+    // 叶链表不完整(还有占位节点)时不能建立
+    if (!currentNode->loaded.load(std::memory_order_relaxed) ||
+        (currentNode->hasHighKey && currentNode->next == NULL_HANDLE)) {
+      learned.disable();
+      return;
+    }
+    lows.push_back(low);
+    leaves.push_back(node);
+    low = learnedKey(currentNode->highKey);
+    node = currentNode->hasHighKey ? currentNode->next : NULL_HANDLE;
   }
+  learned.assign(lows, leaves);
+  BPLUSTREE_LOG(LogLevel::Debug, "learned.rebuild", {"leaves", leaves.size()},
+                {"segments", learned.segmentCount()});
 }
-// 分裂后更新父亲指针
-template <typename keyType, typename valueType>
-inline void BplusTree<keyType, valueType>::updateParentPointers(
-    std::shared_ptr<InterNode<keyType, valueType>> parent,
-    std::shared_ptr<Node<keyType, valueType>> newNode, const keyType &key) {
-
-  // 查找插入位置
-  auto it = std::lower_bound(parent->keys.begin(), parent->keys.end(), key);
-  auto index = std::distance(parent->keys.begin(), it);
-  parent->keys.insert(it, key);
 
-  // 更改孩子指针
-  parent->children.insert(parent->children.begin() + index + 1, newNode);
+// 释放尚未发布的子树
+template <typename keyType, typename valueType, size_t fanout>
+inline void
+BplusTree<keyType, valueType, fanout>::releaseUnpublished(NodeHandle handle) {
+  std::vector<NodeHandle> stack = {handle};
+  while (!stack.empty()) {
+    NodeHandle current = stack.back();
+    stack.pop_back();
+    if (!getNode(current)->isLeafNode()) {
+      for (NodeHandle child : getInter(current)->children) {
+        stack.push_back(child);
+      }
+    }
+    destroyNode(current);
+    arena.release(current);
+  }
+}
+
+// 逐个废弃并归还整棵树的节点
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::discardTree() {
+  // 占位节点随整棵树废弃，不再需要数据文件
+  lazy.reset();
+  lazyPending = false;
+  if (learnedEnabled) {
+    learned.assign({}, {});
+  }
+  if (root == NULL_HANDLE) {
+    return;
+  }
+  std::vector<NodeHandle> stack = {root};
+  root = NULL_HANDLE;
+  while (!stack.empty()) {
+    NodeHandle handle = stack.back();
+    stack.pop_back();
+    // 等待持有该节点写锁的快速路径完成
+    latchOf(handle).lock();
+    if (getNode(handle)->page != NULL_PAGE) {
+      stalePages.push_back(getNode(handle)->page);
+    }
+    if (!getNode(handle)->isLeafNode()) {
+      for (NodeHandle child : getInter(handle)->children) {
+        stack.push_back(child);
+      }
+    }
+    destroyNode(handle);
+    latchOf(handle).unlockObsolete();
+    retireNode(handle);
+  }
+}
+
+// 学习索引给出叶子句柄
+template <typename keyType, typename valueType, size_t fanout>
+inline bool BplusTree<keyType, valueType, fanout>::routeHandle(
+    const keyType &key, NodeHandle &leaf, uint64_t &routeVersion,
+    Seek seek) const {
+  if (!learned.active() || !learned.latch().readLock(routeVersion)) {
+    return false;
+  }
+  // 下界等于key的叶子左侧可能还有等值key：找第一个时取下界小于key的叶子；
+  // 最小的key没有更小的下界，多个叶子的下界都是它，交给从根下降
+  uint64_t low = learnedKey(key);
+  if (seek == Seek::First) {
+    if (low == 0) {
+      return false;
+    }
+    --low;
+  }
+  leaf = learned.route(low);
+  return leaf != NULL_HANDLE && learned.latch().validate(routeVersion);
+}
+
+// 学习索引定位叶子
+template <typename keyType, typename valueType, size_t fanout>
+inline bool BplusTree<keyType, valueType, fanout>::routeLeaf(
+    const keyType &key, NodeHandle &leaf, uint64_t &version, Seek seek) const {
+  NodeHandle handle;
+  uint64_t routeVersion;
+  if (!routeHandle(key, handle, routeVersion, seek)) {
+    return false;
+  }
+  // 校验通过时句柄是在用的叶子；取得其版本后再校验一次，排除其间被合并释放
+  if (!readNode(handle, version) || !learned.latch().validate(routeVersion)) {
+    return false;
+  }
+  leaf = handle;
+  return true;
+}
+
+// 是否沿右链接右移
+template <typename keyType, typename valueType, size_t fanout>
+inline bool BplusTree<keyType, valueType, fanout>::pastHighKey(
+    NodeHandle handle, const keyType &key, Seek seek) const {
+  auto node = getNode(handle);
+  if (seek == Seek::Last) {
+    return node->beyondHighKey(key);
+  }
+  if (node->aboveHighKey(key)) {
+    return true;
+  }
+  if (!node->beyondHighKey(key)) {
+    return false;
+  }
+  // key等于上界：内部节点的最右子树仍可能含有key，叶子要看是否已读完
+  if (!node->isLeafNode()) {
+    return false;
+  }
+  const auto &keys = getLeaf(handle)->keys;
+  size_t count = safeSize(keys);
+  return lowerIndex(keys, count, key) == count;
+}
+
+// 右移到右兄弟
+template <typename keyType, typename valueType, size_t fanout>
+inline bool
+BplusTree<keyType, valueType, fanout>::moveRight(NodeHandle &node,
+                                                 uint64_t &version) const {
+  NodeHandle right = getNode(node)->next;
+  if (!latchOf(node).validate(version)) {
+    return false;
+  }
+  if (right == NULL_HANDLE) {
+    if (lazyPending.load(std::memory_order_acquire)) {
+      resolveNeighbor(node, version, true);
+    }
+    return false;
+  }
+  uint64_t rightVersion;
+  if (!readNode(right, rightVersion) || !latchOf(node).validate(version)) {
+    return false;
+  }
+  node = right;
+  version = rightVersion;
+  return true;
+}
+
+// 乐观下降
+template <typename keyType, typename valueType, size_t fanout>
+inline bool BplusTree<keyType, valueType, fanout>::descendOptimistic(
+    const keyType &key, NodeHandle &leaf, uint64_t &version, Seek seek) const {
+
+  NodeHandle node = root.load(std::memory_order_acquire);
+  if (node == NULL_HANDLE) {
+    leaf = NULL_HANDLE;
+    return true;
+  }
+  // 学习索引直接给出叶子，否则从根逐层下降
+  if (!routeLeaf(key, node, version, seek) &&
+      (!latchOf(node).readLock(version) ||
+       root.load(std::memory_order_acquire) != node)) {
+    return false;
+  }
+
+  for (;;) {
+    auto currentNode = getNode(node);
+
+    // B-link：key超出上界说明本节点已分裂而父节点还没更新，沿右链接右移
+    // (找第一个等值key时，叶子中没有剩下的等值key也右移)
+    if (pastHighKey(node, key, seek)) {
+      if (!moveRight(node, version)) {
+        return false;
+      }
+      continue;
+    }
+
+    if (currentNode->isLeafNode()) {
+      break;
+    }
+    // 找第一个等值key时等于分隔key的走左侧子树
+    auto interNode = getInter(node);
+    size_t count = safeSize(interNode->keys);
+    NodeHandle child =
+        interNode->children[seek == Seek::First
+                                ? lowerIndex(interNode->keys, count, key)
+                                : upperIndex(interNode->keys, count, key)];
+
+    // 读到的子节点句柄在当前节点版本未变时才可信
+    if (!latchOf(node).validate(version)) {
+      return false;
+    }
+    uint64_t childVersion;
+    if (!readNode(child, childVersion)) {
+      return false;
+    }
+    // 再次校验，排除子节点在两次读取之间被释放并复用
+    if (!latchOf(node).validate(version)) {
+      return false;
+    }
+    node = child;
+    version = childVersion;
+  }
+
+  leaf = node;
+  return true;
+}
+
+// 快速插入：叶子未满时只锁叶子
+template <typename keyType, typename valueType, size_t fanout>
+inline typename BplusTree<keyType, valueType, fanout>::LeafOp
+BplusTree<keyType, valueType, fanout>::tryInsertInLeaf(const keyType &key,
+                                                       const valueType &value) {
+  for (;;) {
+    NodeHandle targetLeaf;
+    uint64_t version;
+    if (!descendOptimistic(key, targetLeaf, version, Seek::Last)) {
+      continue;
+    }
+    if (targetLeaf == NULL_HANDLE) {
+      return LeafOp::NeedSmo; // 空树需要创建根节点
+    }
+
+    // 压缩叶子按字节用量判断(读到的可能是撕裂的，升级锁时一并校验)
+    bool full = !leafRoom(getLeaf(targetLeaf), key, value);
+    if (full) {
+      if (!latchOf(targetLeaf).validate(version)) {
+        continue;
+      }
+      return LeafOp::NeedSmo;
+    }
+
+    // 版本未变说明读到的大小可信，且叶子仍覆盖key
+    if (!latchOf(targetLeaf).tryUpgrade(version)) {
+      continue;
+    }
+    insertInLeaf(targetLeaf, key, value);
+    markDirty(targetLeaf);
+    latchOf(targetLeaf).unlock();
+    return LeafOp::Done;
+  }
+}
+
+// 快速删除：删除后不下溢时只锁叶子
+template <typename keyType, typename valueType, size_t fanout>
+inline typename BplusTree<keyType, valueType, fanout>::LeafOp
+BplusTree<keyType, valueType, fanout>::tryRemoveInLeaf(const keyType &key) {
+  for (;;) {
+    NodeHandle targetLeaf;
+    uint64_t version;
+    if (!descendOptimistic(key, targetLeaf, version, Seek::First)) {
+      continue;
+    }
+    if (targetLeaf == NULL_HANDLE) {
+      return LeafOp::NotFound;
+    }
+    if (!latchOf(targetLeaf).tryUpgrade(version)) {
+      continue;
+    }
+
+    auto leafNode = getLeaf(targetLeaf);
+    size_t index = lowerIndex(leafNode->keys, key);
+    if (index == leafNode->keys.size() || !(leafNode->keys[index] == key)) {
+      latchOf(targetLeaf).unlock();
+      return LeafOp::NotFound;
+    }
+
+    // 持有叶子写锁时它是否为根不会改变(换根的结构修改必然锁住它)
+    size_t remaining = leafNode->keys.size() - 1;
+    bool isRoot = root.load(std::memory_order_acquire) == targetLeaf;
+    if (isRoot ? remaining == 0 : leafUnderflow(leafNode, remaining)) {
+      latchOf(targetLeaf).unlock();
+      return LeafOp::NeedSmo;
+    }
+
+    leafNode->keys.erase(leafNode->keys.begin() + index);
+    leafNode->values.erase(leafNode->values.begin() + index);
+    markDirty(targetLeaf);
+    latchOf(targetLeaf).unlock();
+    return LeafOp::Done;
+  }
+}
+
+// 批量查找中推进一个查询：每次调用最多访问一个新的(已预取的)节点
+// 任何校验失败都让该查询从根重新开始
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::probeStep(
+    Probe &probe, const keyType &key, valueType &result) const {
+
+  // 读取上一轮已预取的value
+  if (probe.stage == ProbeStage::Value) {
+    valueType value = getLeaf(probe.node)->values[probe.index];
+    if (latchOf(probe.node).validate(probe.version)) {
+      result = value;
+      probe.stage = ProbeStage::Done;
+      return;
+    }
+    probe.stage = ProbeStage::Start;
+  }
+
+  // 从根开始(根节点通常在缓存中，直接继续处理)
+  if (probe.stage == ProbeStage::Start) {
+    NodeHandle rootNode = root.load(std::memory_order_acquire);
+    if (rootNode == NULL_HANDLE) {
+      result = valueType{};
+      probe.stage = ProbeStage::Done;
+      return;
+    }
+    // 学习索引直接给出叶子：预取后下一轮进入(parent为空表示
+    // 由学习索引的版本校验)；否则从根开始
+    if (routeHandle(key, probe.node, probe.parentVersion, Seek::First)) {
+      probe.parent = NULL_HANDLE;
+      probe.stage = ProbeStage::Child;
+      arena.prefetch(probe.node, prefetchBytes);
+      return;
+    }
+    if (!latchOf(rootNode).readLock(probe.version) ||
+        root.load(std::memory_order_acquire) != rootNode) {
+      return;
+    }
+    probe.node = rootNode;
+    probe.stage = ProbeStage::Node;
+  }
+
+  // 进入上一轮选中并预取的子节点：读到其版本后再校验父节点
+  if (probe.stage == ProbeStage::Child) {
+    if (!readNode(probe.node, probe.version) ||
+        !(probe.parent == NULL_HANDLE
+              ? learned.latch().validate(probe.parentVersion)
+              : latchOf(probe.parent).validate(probe.parentVersion))) {
+      probe.stage = ProbeStage::Start;
+      return;
+    }
+    probe.stage = ProbeStage::Node;
+  }
+
+  if (probe.stage != ProbeStage::Node) {
+    return;
+  }
+  auto currentNode = getNode(probe.node);
+
+  // B-link：超出上界时沿右链接右移(少见，不预取)
+  while (pastHighKey(probe.node, key, Seek::First)) {
+    if (!moveRight(probe.node, probe.version)) {
+      probe.stage = ProbeStage::Start;
+      return;
+    }
+    currentNode = getNode(probe.node);
+  }
+
+  // 叶子：定位key，命中时预取value，下一轮读取
+  if (currentNode->isLeafNode()) {
+    auto leafNode = getLeaf(probe.node);
+    size_t count = safeSize(leafNode->keys);
+    size_t i = lowerIndex(leafNode->keys, count, key);
+    bool found = i < count && leafNode->keys[i] == key;
+    if (!latchOf(probe.node).validate(probe.version)) {
+      probe.stage = ProbeStage::Start;
+      return;
+    }
+    if (!found) {
+      result = valueType{};
+      probe.stage = ProbeStage::Done;
+      return;
+    }
+    probe.index = i;
+    probe.stage = ProbeStage::Value;
+#if defined(__GNUC__) || defined(__clang__)
+    if constexpr (packedLeaves) {
+      __builtin_prefetch(leafNode->values.address(i), 0, 3);
+    } else {
+      __builtin_prefetch(leafNode->values.data() + i, 0, 3);
+    }
+#endif
+    return;
+  }
+
+  // 内部节点：选出子节点并预取，下一轮进入
+  auto interNode = getInter(probe.node);
+  NodeHandle child = interNode->children[lowerIndex(
+      interNode->keys, safeSize(interNode->keys), key)];
+  if (!latchOf(probe.node).validate(probe.version)) {
+    probe.stage = ProbeStage::Start;
+    return;
+  }
+  probe.parent = probe.node;
+  probe.parentVersion = probe.version;
+  probe.node = child;
+  probe.stage = ProbeStage::Child;
+  arena.prefetch(child, prefetchBytes);
+}
+
+// 一组查询轮流推进，直到全部完成
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::multiSearchGroup(
+    const keyType *keys, size_t count, valueType *out) const {
+
+  Probe probes[PROBE_GROUP];
+  size_t remaining = count;
+  while (remaining > 0) {
+    remaining = 0;
+    for (size_t i = 0; i < count; ++i) {
+      if (probes[i].stage != ProbeStage::Done) {
+        probeStep(probes[i], keys[i], out[i]);
+        remaining += probes[i].stage != ProbeStage::Done;
+      }
+    }
+  }
+}
+
+// 寻找叶子结点
+template <typename keyType, typename valueType, size_t fanout>
+inline NodeHandle BplusTree<keyType, valueType, fanout>::findLeaf(
+    NodeHandle currentNode, const keyType &key, Seek seek) {
+
+  // 逐层下降，直到叶子结点
+  ensureLoaded(currentNode);
+  while (!getNode(currentNode)->isLeafNode()) {
+    auto interNode = getInter(currentNode);
+
+    // key有序排列，第一个大于key的位置即为子节点下标(大于所有key时为最后一个)；
+    // 找第一个等值key时取第一个不小于key的位置
+    size_t index = seek == Seek::First ? lowerIndex(interNode->keys, key)
+                                       : upperIndex(interNode->keys, key);
+    currentNode = interNode->children[index];
+    ensureLoaded(currentNode);
+  }
+
+  return currentNode;
+}
+
+// 结构修改中定位第一个含有key的叶子
+template <typename keyType, typename valueType, size_t fanout>
+inline NodeHandle
+BplusTree<keyType, valueType, fanout>::latchFirstLeaf(const keyType &key) {
+  NodeHandle targetLeaf = findLeaf(root, key, Seek::First);
+  smoLatch(targetLeaf);
+
+  // 快速路径可能同时修改叶子，加锁后再判断等值key是否只剩在右侧叶子
+  auto leafNode = getLeaf(targetLeaf);
+  if (leafNode->hasHighKey && !(key < leafNode->highKey) &&
+      lowerIndex(leafNode->keys, key) == leafNode->keys.size()) {
+    targetLeaf = neighbor(targetLeaf, true, true);
+    smoLatch(targetLeaf);
+  }
+  return targetLeaf;
+}
+
+// 插入叶子结点
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::insertInLeaf(
+    NodeHandle targetLeaf, const keyType &key, const valueType &value) {
+
+  auto leafNode = getLeaf(targetLeaf);
+
+  // 查找插入位置
+  // std::cout << "keys.size(): " << targetLeaf->keys.size()
+  //          << ", values.size(): " << targetLeaf->values.size() << "\n";
+  auto it = leafNode->keys.begin() + lowerIndex(leafNode->keys, key);
+  size_t pos = std::distance(leafNode->keys.begin(), it);
+  // std::cout << "Insert position: " << pos << "\n";
+
+  // 插入新的键值对
+  leafNode->keys.insert(it, key);
+  leafNode->values.insert(leafNode->values.begin() + pos, value);
+}
+
+// 分裂叶子
+template <typename keyType, typename valueType, size_t fanout>
+inline void
+BplusTree<keyType, valueType, fanout>::splitLeaf(NodeHandle leafNode) {
+
+  smoLatch(leafNode);
+  auto currentLeaf = getLeaf(leafNode);
+  size_t midIndex = currentLeaf->keys.size() / 2;
+
+  // 将后半部分移入新的叶子结点,前半部分保留
+  NodeHandle newLeaf = allocLeaf();
+  auto newLeafNode = getLeaf(newLeaf);
+  newLeafNode->keys.assign(currentLeaf->keys.begin() + midIndex,
+                           currentLeaf->keys.end());
+  newLeafNode->values.assign(currentLeaf->values.begin() + midIndex,
+                             currentLeaf->values.end());
+  currentLeaf->keys.resize(midIndex);
+  currentLeaf->values.resize(midIndex);
+
+  // 更新相应的指针结构
+  keyType separator =
+      separatorKey(currentLeaf->keys.back(), newLeafNode->keys.front());
+  newLeafNode->parent = currentLeaf->parent;
+  linkSplit(leafNode, newLeaf, separator);
+
+  // B-link：新叶子已可经右链接到达，先放开本叶子再去改父节点
+  // (此后两个叶子都可能被快速路径修改，只能使用已保存的分隔key)
+  if (blinkMode) {
+    smoUnlatch(leafNode);
+  }
+
+  // 将新节点插入父节点
+  updateParentPointers(currentLeaf->parent, leafNode, newLeaf, separator);
+}
+
+// 分裂内部
+template <typename keyType, typename valueType, size_t fanout>
+inline void
+BplusTree<keyType, valueType, fanout>::splitInter(NodeHandle interNode) {
+
+  smoLatch(interNode);
+  auto currentInter = getInter(interNode);
+  size_t midIndex = currentInter->keys.size() / 2;
+  keyType midKey = currentInter->keys[midIndex];
+
+  // 分开存储
+  NodeHandle newInter = allocInter();
+  auto newInterNode = getInter(newInter);
+  newInterNode->keys.assign(currentInter->keys.begin() + midIndex + 1,
+                            currentInter->keys.end());
+  newInterNode->children.assign(currentInter->children.begin() + midIndex + 1,
+                                currentInter->children.end());
+  currentInter->keys.resize(midIndex);
+  currentInter->children.resize(midIndex + 1);
+  newInterNode->parent = currentInter->parent;
+
+  // 更新子节点的父指针
+  for (auto child : newInterNode->children) {
+    getNode(child)->parent = newInter;
+  }
+  linkSplit(interNode, newInter, midKey);
+
+  if (blinkMode) {
+    smoUnlatch(interNode);
+  }
+
+  // 更新父指针结构
+  updateParentPointers(currentInter->parent, interNode, newInter, midKey);
+}
+
+// 分裂根结点
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::splitRoot(NodeHandle root) {
+
+  smoLatch(root);
+
+  // 根节点为叶子结点
+  if (getNode(root)->isLeafNode()) {
+
+    auto leafRoot = getLeaf(root);
+    size_t midIndex = leafRoot->keys.size() / 2;
+
+    // 创建一个新的叶子节点
+    NodeHandle newLeaf = allocLeaf();
+    auto newLeafNode = getLeaf(newLeaf);
+    newLeafNode->keys.assign(leafRoot->keys.begin() + midIndex,
+                             leafRoot->keys.end());
+    newLeafNode->values.assign(leafRoot->values.begin() + midIndex,
+                               leafRoot->values.end());
+    leafRoot->keys.resize(midIndex);
+    leafRoot->values.resize(midIndex);
+
+    // 更新叶子节点的指针
+    keyType separator =
+        separatorKey(leafRoot->keys.back(), newLeafNode->keys.front());
+    linkSplit(root, newLeaf, separator);
+
+    // 创建新的根节点
+    NodeHandle newRoot = allocInter();
+    auto newRootNode = getInter(newRoot);
+    newRootNode->keys.push_back(separator);
+    newRootNode->children.push_back(root);
+    newRootNode->children.push_back(newLeaf);
+
+    // 更新子节点的父指针
+    leafRoot->parent = newRoot;
+    newLeafNode->parent = newRoot;
+
+    // 更新树的根节点
+    this->root = newRoot;
+  }
+  // 根节点为内部节点
+  else {
+
+    auto interRoot = getInter(root);
+    size_t midIndex = interRoot->keys.size() / 2;
+
+    // 创建一个新的内部节点
+    NodeHandle newInter = allocInter();
+    auto newInterNode = getInter(newInter);
+
+    // 分开存储
+    newInterNode->keys.assign(interRoot->keys.begin() + midIndex + 1,
+                              interRoot->keys.end());
+    newInterNode->children.assign(interRoot->children.begin() + midIndex + 1,
+                                  interRoot->children.end());
+
+    // 更新新内部节点父指针
+    for (auto child : newInterNode->children) {
+      getNode(child)->parent = newInter;
+    }
+
+    // 创建新根结点
+    NodeHandle newRoot = allocInter();
+    auto newRootNode = getInter(newRoot);
+
+    // 提升原节点最后一个key作为新跟节点的key
+    newRootNode->keys.push_back(interRoot->keys[midIndex]);
+    linkSplit(root, newInter, interRoot->keys[midIndex]);
+    interRoot->keys.resize(midIndex);
+    interRoot->children.resize(midIndex + 1);
+
+    newRootNode->children.push_back(root);
+    newRootNode->children.push_back(newInter);
+
+    // 更新子节点父指针
+    interRoot->parent = newRoot;
+    newInterNode->parent = newRoot;
+
+    // 更新树的根结点
+    this->root = newRoot;
+  }
+}
+// 自底向上分裂
+template <typename keyType, typename valueType, size_t fanout>
+inline void
+BplusTree<keyType, valueType, fanout>::splitOverflow(NodeHandle node) {
+
+  // 可能需要分裂
+  while (node != NULL_HANDLE && getNode(node)->keys.size() > maxKeys) {
+
+    // 根节点
+    if (node == root) {
+      splitRoot(node);
+    } else {
+      // 叶子节点
+      if (getNode(node)->isLeafNode()) {
+        splitLeaf(node);
+      } else {
+        // 内部节点
+        splitInter(node);
+      }
+      node = getNode(node)->parent;
+    }
+  }
+}
+
+// 分裂后更新父亲指针
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::updateParentPointers(
+    NodeHandle parent, NodeHandle left, NodeHandle newNode,
+    const keyType &key) {
+
+  smoLatch(parent);
+  auto parentNode = getInter(parent);
+
+  // 插入位置紧跟在分裂的节点之后(有重复key时分隔key可能与左右的相等，
+  // 不能按key查找)
+  auto index = std::distance(
+      parentNode->children.begin(),
+      std::find(parentNode->children.begin(), parentNode->children.end(),
+                left));
+  parentNode->keys.insert(parentNode->keys.begin() + index, key);
+
+  // 更改孩子指针
+  parentNode->children.insert(parentNode->children.begin() + index + 1,
+                              newNode);
 }
 
 // 删除后调整操作(改为通用)
-template <typename keyType, typename valueType>
-inline bool BplusTree<keyType, valueType>::adjust(
-    std::shared_ptr<Node<keyType, valueType>> node,
-    std::shared_ptr<InterNode<keyType, valueType>> parent) {
+template <typename keyType, typename valueType, size_t fanout>
+inline bool BplusTree<keyType, valueType, fanout>::adjust(NodeHandle node,
+                                                          NodeHandle parent) {
 
   auto leftSibling = getLeftSibling(node);
   auto rightSibling = getRightSibling(node);
 
+  // 兄弟可能是懒加载的占位节点，借调/合并前先读入
+  if (leftSibling != NULL_HANDLE) {
+    ensureLoaded(leftSibling);
+  }
+  if (rightSibling != NULL_HANDLE) {
+    ensureLoaded(rightSibling);
+  }
+
+  // 借调/合并会修改本节点、兄弟和父节点，兄弟的大小也要在锁内读取
+  smoLatch(node);
+  smoLatch(parent);
+  if (leftSibling != NULL_HANDLE) {
+    smoLatch(leftSibling);
+  }
+  if (rightSibling != NULL_HANDLE) {
+    smoLatch(rightSibling);
+  }
+
   // 左兄弟借出
-  if (leftSibling && leftSibling->keys.size() > minKeys) {
+  if (leftSibling != NULL_HANDLE && canLend(leftSibling, node, true)) {
     borrowFromL(node, leftSibling, parent);
     // std::cout << "Borrowed from left sibling.\n" << std::endl;
     return true;
   }
 
   // 右兄弟借出
-  if (rightSibling && rightSibling->keys.size() > minKeys) {
+  if (rightSibling != NULL_HANDLE && canLend(rightSibling, node, false)) {
     borrowFromR(node, rightSibling, parent);
     // std::cout << "Borrowed from right sibling.\n" << std::endl;
     return true;
   }
 
   // 左兄弟合并
-  if (leftSibling) {
+  if (leftSibling != NULL_HANDLE && canMerge(leftSibling, node)) {
     mergeWithL(node, leftSibling, parent);
     // std::cout << "Merged with left sibling.\n" << std::endl;
     return true;
   }
 
   // 右兄弟合并
-  if (rightSibling) {
+  if (rightSibling != NULL_HANDLE && canMerge(node, rightSibling)) {
     mergeWithR(node, rightSibling, parent);
     // std::cout << "Merged with right sibling.\n" << std::endl;
     return true;
   }
 
+  // 压缩叶子的兄弟既借不出也并不进来(字节区放不下)，本叶子保持不满
+  if (leftSibling != NULL_HANDLE || rightSibling != NULL_HANDLE) {
+    return true;
+  }
+
   // 一般不会执行
   return false;
 }
 
 // 找左兄弟
-template <typename keyType, typename valueType>
-inline std::shared_ptr<Node<keyType, valueType>>
-BplusTree<keyType, valueType>::getLeftSibling(
-    std::shared_ptr<Node<keyType, valueType>> node) {
+template <typename keyType, typename valueType, size_t fanout>
+inline NodeHandle
+BplusTree<keyType, valueType, fanout>::getLeftSibling(NodeHandle node) {
 
-  if (node->parent) {
-    auto parent =
-        std::dynamic_pointer_cast<InterNode<keyType, valueType>>(node->parent);
+  NodeHandle parent = getNode(node)->parent;
+  if (parent != NULL_HANDLE) {
+    auto parentNode = getInter(parent);
 
     // 找当前节点的位置
-    auto it = std::find(parent->children.begin(), parent->children.end(), node);
+    auto it = std::find(parentNode->children.begin(),
+                        parentNode->children.end(), node);
 
-    if (it != parent->children.begin()) {
+    if (it != parentNode->children.begin()) {
       return *(it - 1);
     }
   }
-  return std::shared_ptr<Node<keyType, valueType>>();
+  return NULL_HANDLE;
 }
 
 // 找右兄弟
-template <typename keyType, typename valueType>
-inline std::shared_ptr<Node<keyType, valueType>>
-BplusTree<keyType, valueType>::getRightSibling(
-    std::shared_ptr<Node<keyType, valueType>> node) {
-  if (node->parent) {
-    auto parent =
-        std::dynamic_pointer_cast<InterNode<keyType, valueType>>(node->parent);
+template <typename keyType, typename valueType, size_t fanout>
+inline NodeHandle
+BplusTree<keyType, valueType, fanout>::getRightSibling(NodeHandle node) {
+  NodeHandle parent = getNode(node)->parent;
+  if (parent != NULL_HANDLE) {
+    auto parentNode = getInter(parent);
 
     // 找当前节点的位置
-    auto it = std::find(parent->children.begin(), parent->children.end(), node);
+    auto it = std::find(parentNode->children.begin(),
+                        parentNode->children.end(), node);
 
-    if (it != parent->children.end() - 1) {
+    if (it != parentNode->children.end() - 1) {
       return *(it + 1);
     }
   }
-  return std::shared_ptr<Node<keyType, valueType>>();
+  return NULL_HANDLE;
 }
 
 // 从左兄弟借(已修改子指针)
-template <typename keyType, typename valueType>
-inline void BplusTree<keyType, valueType>::borrowFromL(
-    std::shared_ptr<Node<keyType, valueType>> node,
-    std::shared_ptr<Node<keyType, valueType>> leftSibling,
-    std::shared_ptr<InterNode<keyType, valueType>> parent) {
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::borrowFromL(
+    NodeHandle node, NodeHandle leftSibling, NodeHandle parent) {
+
+  auto parentNode = getInter(parent);
 
   // 判断node类型
-  if (node->isLeafNode()) { // 叶子结点
-    auto currentNode =
-        std::dynamic_pointer_cast<LeafNode<keyType, valueType>>(node);
-    auto currentLeft =
-        std::dynamic_pointer_cast<LeafNode<keyType, valueType>>(leftSibling);
+  if (getNode(node)->isLeafNode()) { // 叶子结点
+    auto currentNode = getLeaf(node);
+    auto currentLeft = getLeaf(leftSibling);
 
     // 移入当前节点
     currentNode->keys.insert(currentNode->keys.begin(),
@@ -492,48 +2240,42 @@ inline void BplusTree<keyType, valueType>::borrowFromL(
     currentLeft->values.pop_back();
 
     // 父节点指针更新
-    auto childIt = std::find(parent->children.begin(), parent->children.end(),
-                             currentNode);
-    if (childIt != parent->children.end()) {
-      size_t i = std::distance(parent->children.begin(), childIt);
-      parent->keys[i - 1] = currentNode->keys.front();
+    auto childIt = std::find(parentNode->children.begin(),
+                             parentNode->children.end(), node);
+    if (childIt != parentNode->children.end()) {
+      size_t i = std::distance(parentNode->children.begin(), childIt);
+      parentNode->keys[i - 1] =
+          separatorKey(currentLeft->keys.back(), currentNode->keys.front());
+      learned.update(learnedKey(currentLeft->highKey), node,
+                     learnedKey(parentNode->keys[i - 1]));
+      currentLeft->highKey = parentNode->keys[i - 1];
     }
   } else { // 内部节点
-    auto currentNode =
-        std::dynamic_pointer_cast<InterNode<keyType, valueType>>(node);
-    auto currentLeft =
-        std::dynamic_pointer_cast<InterNode<keyType, valueType>>(leftSibling);
+    auto currentNode = getInter(node);
+    auto currentLeft = getInter(leftSibling);
 
     // 移入当前节点
 
     // 更新子节点父指针
     auto newChild = currentLeft->children.back();
-    newChild->parent = currentNode;
+    getNode(newChild)->parent = node;
 
     // currentNode->keys.insert(currentNode->keys.begin(),
     //                        currentLeft->keys.back());
 
-    // 父节点指针更新
-    auto childIt = std::find(parent->children.begin(), parent->children.end(),
-                             currentNode);
-    if (childIt != parent->children.end()) {
-      size_t i = std::distance(parent->children.begin(), childIt);
-
-      parent->keys[i - 1] = currentLeft->keys.back();
-    }
-
-    // 更新当前节点
-    // 遍历获得右边最小值
-    auto current = currentNode; // InterNode
-    auto tempNode =
-        std::dynamic_pointer_cast<Node<keyType, valueType>>(current); // Node
-    while (!tempNode->isLeafNode()) {
-      current =
-          std::dynamic_pointer_cast<InterNode<keyType, valueType>>(tempNode);
-      tempNode = std::dynamic_pointer_cast<Node<keyType, valueType>>(
-          current->children.front());
+    // 父节点指针更新：原分隔key下移到当前节点，左兄弟最后一个key上移
+    // (借来的子树上界恰为原分隔key，各节点的highKey保持一致)
+    auto childIt = std::find(parentNode->children.begin(),
+                             parentNode->children.end(), node);
+    if (childIt != parentNode->children.end()) {
+      size_t i = std::distance(parentNode->children.begin(), childIt);
+
+      // 更新当前节点
+      currentNode->keys.insert(currentNode->keys.begin(),
+                               parentNode->keys[i - 1]);
+      parentNode->keys[i - 1] = currentLeft->keys.back();
+      currentLeft->highKey = parentNode->keys[i - 1];
     }
-    currentNode->keys.insert(currentNode->keys.begin(), tempNode->keys.front());
 
     currentNode->children.insert(currentNode->children.begin(),
                                  currentLeft->children.back());
@@ -545,18 +2287,16 @@ inline void BplusTree<keyType, valueType>::borrowFromL(
 }
 
 // 从右兄弟借(已修改子指针)
-template <typename keyType, typename valueType>
-inline void BplusTree<keyType, valueType>::borrowFromR(
-    std::shared_ptr<Node<keyType, valueType>> node,
-    std::shared_ptr<Node<keyType, valueType>> rightSibling,
-    std::shared_ptr<InterNode<keyType, valueType>> parent) {
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::borrowFromR(
+    NodeHandle node, NodeHandle rightSibling, NodeHandle parent) {
+
+  auto parentNode = getInter(parent);
 
   // 判断node类型
-  if (node->isLeafNode()) { // 叶子结点
-    auto currentNode =
-        std::dynamic_pointer_cast<LeafNode<keyType, valueType>>(node);
-    auto currentRight =
-        std::dynamic_pointer_cast<LeafNode<keyType, valueType>>(rightSibling);
+  if (getNode(node)->isLeafNode()) { // 叶子结点
+    auto currentNode = getLeaf(node);
+    auto currentRight = getLeaf(rightSibling);
 
     // 移入当前节点
     currentNode->keys.push_back(currentRight->keys.front());
@@ -567,42 +2307,36 @@ inline void BplusTree<keyType, valueType>::borrowFromR(
     currentRight->values.erase(currentRight->values.begin());
 
     // 父节点指针更新
-    auto childIt = std::find(parent->children.begin(), parent->children.end(),
-                             currentNode);
-    if (childIt != parent->children.end()) {
-      size_t i = std::distance(parent->children.begin(), childIt);
-      parent->keys[i] = currentRight->keys.front();
+    auto childIt = std::find(parentNode->children.begin(),
+                             parentNode->children.end(), node);
+    if (childIt != parentNode->children.end()) {
+      size_t i = std::distance(parentNode->children.begin(), childIt);
+      parentNode->keys[i] =
+          separatorKey(currentNode->keys.back(), currentRight->keys.front());
+      learned.update(learnedKey(currentNode->highKey), rightSibling,
+                     learnedKey(parentNode->keys[i]));
+      currentNode->highKey = parentNode->keys[i];
     }
   } else { // 内部节点
-    auto currentNode =
-        std::dynamic_pointer_cast<InterNode<keyType, valueType>>(node);
-    auto currentRight =
-        std::dynamic_pointer_cast<InterNode<keyType, valueType>>(rightSibling);
+    auto currentNode = getInter(node);
+    auto currentRight = getInter(rightSibling);
 
     // 更新子节点父指针
     auto newChild = currentRight->children.front();
-    newChild->parent = currentNode;
-
-    // 父节点指针更新
-    auto childIt = std::find(parent->children.begin(), parent->children.end(),
-                             currentNode);
-    if (childIt != parent->children.end()) {
-      size_t i = std::distance(parent->children.begin(), childIt);
-      parent->keys[i] = currentRight->keys.front();
+    getNode(newChild)->parent = node;
+
+    // 父节点指针更新：原分隔key下移到当前节点，右兄弟第一个key上移
+    auto childIt = std::find(parentNode->children.begin(),
+                             parentNode->children.end(), node);
+    if (childIt != parentNode->children.end()) {
+      size_t i = std::distance(parentNode->children.begin(), childIt);
+
+      // 更新当前节点
+      currentNode->keys.push_back(parentNode->keys[i]);
+      parentNode->keys[i] = currentRight->keys.front();
+      currentNode->highKey = parentNode->keys[i];
     }
 
-    // 更新当前节点
-    auto current = currentRight; // InterNode
-    auto tempNode =
-        std::dynamic_pointer_cast<Node<keyType, valueType>>(current); // Node
-    while (!tempNode->isLeafNode()) {
-      current =
-          std::dynamic_pointer_cast<InterNode<keyType, valueType>>(tempNode);
-      tempNode = std::dynamic_pointer_cast<Node<keyType, valueType>>(
-          current->children.front());
-    }
-    currentNode->keys.push_back(tempNode->keys.front());
-
     currentNode->children.push_back(currentRight->children.front());
 
     // 右节点删除信息
@@ -612,18 +2346,16 @@ inline void BplusTree<keyType, valueType>::borrowFromR(
 }
 
 // 找左兄弟合并(合并到左)(已修改)
-template <typename keyType, typename valueType>
-inline void BplusTree<keyType, valueType>::mergeWithL(
-    std::shared_ptr<Node<keyType, valueType>> node,
-    std::shared_ptr<Node<keyType, valueType>> leftSibling,
-    std::shared_ptr<InterNode<keyType, valueType>> parent) {
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::mergeWithL(
+    NodeHandle node, NodeHandle leftSibling, NodeHandle parent) {
+
+  auto parentNode = getInter(parent);
 
   // 判断node类型
-  if (node->isLeafNode()) { // 叶子结点
-    auto currentNode =
-        std::dynamic_pointer_cast<LeafNode<keyType, valueType>>(node);
-    auto currentLeft =
-        std::dynamic_pointer_cast<LeafNode<keyType, valueType>>(leftSibling);
+  if (getNode(node)->isLeafNode()) { // 叶子结点
+    auto currentNode = getLeaf(node);
+    auto currentLeft = getLeaf(leftSibling);
 
     currentLeft->keys.insert(currentLeft->keys.end(), currentNode->keys.begin(),
                              currentNode->keys.end());
@@ -631,37 +2363,32 @@ inline void BplusTree<keyType, valueType>::mergeWithL(
                                currentNode->values.begin(),
                                currentNode->values.end());
 
-    // 更新链表结构(叶子结点)
-    currentLeft->next = currentNode->next;
-
-    auto childIt = std::find(parent->children.begin(), parent->children.end(),
-                             currentNode);
-    if (childIt != parent->children.end()) {
-      size_t i = std::distance(parent->children.begin(), childIt);
-      parent->keys.erase(parent->keys.begin() + i - 1);
-      parent->children.erase(childIt);
+    auto childIt = std::find(parentNode->children.begin(),
+                             parentNode->children.end(), node);
+    if (childIt != parentNode->children.end()) {
+      size_t i = std::distance(parentNode->children.begin(), childIt);
+      parentNode->keys.erase(parentNode->keys.begin() + i - 1);
+      parentNode->children.erase(childIt);
     }
   } else { // 内部节点
-    auto currentNode =
-        std::dynamic_pointer_cast<InterNode<keyType, valueType>>(node);
-    auto currentLeft =
-        std::dynamic_pointer_cast<InterNode<keyType, valueType>>(leftSibling);
+    auto currentNode = getInter(node);
+    auto currentLeft = getInter(leftSibling);
 
     // 将子节点的父亲改为currentLeft
-    for (auto &child : currentNode->children) {
-      child->parent = currentLeft;
+    for (auto child : currentNode->children) {
+      getNode(child)->parent = leftSibling;
     }
 
     // 更新父节点
-    auto childIt = std::find(parent->children.begin(), parent->children.end(),
-                             currentNode);
-    if (childIt != parent->children.end()) {
-      size_t i = std::distance(parent->children.begin(), childIt);
+    auto childIt = std::find(parentNode->children.begin(),
+                             parentNode->children.end(), node);
+    if (childIt != parentNode->children.end()) {
+      size_t i = std::distance(parentNode->children.begin(), childIt);
       // 添加key到左节点
-      currentLeft->keys.push_back(parent->keys[i - 1]);
+      currentLeft->keys.push_back(parentNode->keys[i - 1]);
       // 删除父节点key和children
-      parent->keys.erase(parent->keys.begin() + i - 1);
-      parent->children.erase(childIt);
+      parentNode->keys.erase(parentNode->keys.begin() + i - 1);
+      parentNode->children.erase(childIt);
     }
 
     // 将当前节点合并到左节点
@@ -672,25 +2399,29 @@ inline void BplusTree<keyType, valueType>::mergeWithL(
                                  currentNode->children.end());
   }
 
+  // 更新右链接和上界(叶子即叶链表)
+  inheritLink(leftSibling, node);
+
+  // 被合并的节点归还arena
+  freeNode(node);
+
   // 递归调整父节点
-  if (parent->keys.size() < minKeys) {
+  if (parentNode->keys.size() < minKeys) {
     adjustFather(parent);
   }
 }
 
 // 找右兄弟合并(右合并到当前)
-template <typename keyType, typename valueType>
-inline void BplusTree<keyType, valueType>::mergeWithR(
-    std::shared_ptr<Node<keyType, valueType>> node,
-    std::shared_ptr<Node<keyType, valueType>> rightSibling,
-    std::shared_ptr<InterNode<keyType, valueType>> parent) {
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::mergeWithR(
+    NodeHandle node, NodeHandle rightSibling, NodeHandle parent) {
+
+  auto parentNode = getInter(parent);
 
   // 判断node类型
-  if (node->isLeafNode()) { // 叶子结点
-    auto currentNode =
-        std::dynamic_pointer_cast<LeafNode<keyType, valueType>>(node);
-    auto currentRight =
-        std::dynamic_pointer_cast<LeafNode<keyType, valueType>>(rightSibling);
+  if (getNode(node)->isLeafNode()) { // 叶子结点
+    auto currentNode = getLeaf(node);
+    auto currentRight = getLeaf(rightSibling);
 
     currentNode->keys.insert(currentNode->keys.end(),
                              currentRight->keys.begin(),
@@ -700,37 +2431,32 @@ inline void BplusTree<keyType, valueType>::mergeWithR(
                                currentRight->values.begin(),
                                currentRight->values.end());
 
-    // 更新next指针，维持链表结构(叶子结点)
-    currentNode->next = currentRight->next;
-
-    auto childIt = std::find(parent->children.begin(), parent->children.end(),
-                             currentNode);
-    if (childIt != parent->children.end()) {
-      size_t i = std::distance(parent->children.begin(), childIt);
-      parent->keys.erase(parent->keys.begin() + i);
-      parent->children.erase(childIt + 1);
+    auto childIt = std::find(parentNode->children.begin(),
+                             parentNode->children.end(), node);
+    if (childIt != parentNode->children.end()) {
+      size_t i = std::distance(parentNode->children.begin(), childIt);
+      parentNode->keys.erase(parentNode->keys.begin() + i);
+      parentNode->children.erase(childIt + 1);
     }
   } else { // 内部节点
-    auto currentNode =
-        std::dynamic_pointer_cast<InterNode<keyType, valueType>>(node);
-    auto currentRight =
-        std::dynamic_pointer_cast<InterNode<keyType, valueType>>(rightSibling);
+    auto currentNode = getInter(node);
+    auto currentRight = getInter(rightSibling);
 
     // 将子节点的父亲改为currentNode
-    for (auto &child : currentRight->children) {
-      child->parent = currentNode;
+    for (auto child : currentRight->children) {
+      getNode(child)->parent = node;
     }
 
     // 更新父节点
-    auto childIt = std::find(parent->children.begin(), parent->children.end(),
-                             currentNode);
-    if (childIt != parent->children.end()) {
-      size_t i = std::distance(parent->children.begin(), childIt);
+    auto childIt = std::find(parentNode->children.begin(),
+                             parentNode->children.end(), node);
+    if (childIt != parentNode->children.end()) {
+      size_t i = std::distance(parentNode->children.begin(), childIt);
       // 添加key到当前节点
-      currentNode->keys.push_back(parent->keys[i]);
+      currentNode->keys.push_back(parentNode->keys[i]);
       // 删除父节点key和children
-      parent->keys.erase(parent->keys.begin() + i);
-      parent->children.erase(childIt + 1);
+      parentNode->keys.erase(parentNode->keys.begin() + i);
+      parentNode->children.erase(childIt + 1);
     }
 
     // 将右节点合并到当前节点
@@ -742,39 +2468,46 @@ inline void BplusTree<keyType, valueType>::mergeWithR(
                                  currentRight->children.end());
   }
 
+  // 更新右链接和上界(叶子即叶链表)
+  inheritLink(node, rightSibling);
+
+  // 被合并的节点归还arena
+  freeNode(rightSibling);
+
   // 递归调整父节点
-  if (parent->keys.size() < minKeys) {
+  if (parentNode->keys.size() < minKeys) {
     adjustFather(parent);
   }
 }
 
 // 合并后调整父节点
-template <typename keyType, typename valueType>
-inline void BplusTree<keyType, valueType>::adjustFather(
-    std::shared_ptr<InterNode<keyType, valueType>> currentNode) {
+template <typename keyType, typename valueType, size_t fanout>
+inline void
+BplusTree<keyType, valueType, fanout>::adjustFather(NodeHandle currentNode) {
+
+  auto interNode = getInter(currentNode);
 
   // 判断是否高度减少
   if (currentNode == root) {
-    if (currentNode->keys.empty() && currentNode->children.size() == 1) {
-      root = currentNode->children[0];
-      root->parent = nullptr;
+    if (interNode->keys.empty() && interNode->children.size() == 1) {
+      root = interNode->children[0];
+      getNode(root)->parent = NULL_HANDLE;
+      freeNode(currentNode);
     }
     return;
   }
 
-  auto parent = std::dynamic_pointer_cast<InterNode<keyType, valueType>>(
-      currentNode->parent);
-  if (parent) { // 不为根结点
-    adjust(std::dynamic_pointer_cast<Node<keyType, valueType>>(currentNode),
-           parent);
+  NodeHandle parent = interNode->parent;
+  if (parent != NULL_HANDLE) { // 不为根结点
+    adjust(currentNode, parent);
   }
 }
 
 // 打印单一节点
-template <typename keyType, typename valueType>
-inline void BplusTree<keyType, valueType>::printNode(
-    const std::shared_ptr<Node<keyType, valueType>> &node, int depth) const {
-  if (!node)
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::printNode(NodeHandle node,
+                                                             int depth) const {
+  if (node == NULL_HANDLE)
     return;
 
   std::string str = std::string(depth * 2, ' ');
@@ -782,10 +2515,9 @@ inline void BplusTree<keyType, valueType>::printNode(
   // 打印缩进深度
   std::cout << str << "Depth " << depth << ": ";
 
-  if (node->isLeafNode()) {
+  if (getNode(node)->isLeafNode()) {
 
-    auto currentNode =
-        std::dynamic_pointer_cast<LeafNode<keyType, valueType>>(node);
+    auto currentNode = getLeaf(node);
 
     // 打印节点类型
     std::cout << "Leaf Node:[Size:" << currentNode->keys.size() << "]"
@@ -810,19 +2542,18 @@ inline void BplusTree<keyType, valueType>::printNode(
     std::cout << "]" << std::endl;
 
     // 打印下一个叶子节点
-    if (currentNode->next) {
+    if (currentNode->next != NULL_HANDLE) {
       std::cout << str << "Next Leaf:Exists" << std::endl;
     }
 
     // 打印父节点
-    if (currentNode->parent) {
+    if (currentNode->parent != NULL_HANDLE) {
       std::cout << str << "Parent: Exists" << std::endl;
     }
 
   } else {
 
-    auto currentNode =
-        std::dynamic_pointer_cast<InterNode<keyType, valueType>>(node);
+    auto currentNode = getInter(node);
 
     // 打印节点类型
     std::cout << "Inter Node:[Size:" << currentNode->keys.size() << "]"
@@ -840,281 +2571,187 @@ inline void BplusTree<keyType, valueType>::printNode(
     // 打印子节点(内部节点)
     std::cout << str << "Children pointers:[";
     for (size_t i = 0; i < currentNode->children.size(); ++i) {
-      std::cout << (currentNode->children[i] ? "Node" : "Null");
+      std::cout << (currentNode->children[i] != NULL_HANDLE ? "Node" : "Null");
       if (i < currentNode->children.size() - 1)
         std::cout << ", ";
     }
     std::cout << "]" << std::endl;
 
     // 打印父节点
-    if (currentNode->parent) {
+    if (currentNode->parent != NULL_HANDLE) {
       std::cout << str << "Parent:Exists" << std::endl;
     }
   }
 }
 
-// 将节点存入文件
-template <typename keyType, typename valueType>
-void BplusTree<keyType, valueType>::saveNodeToFile(
-    const std::shared_ptr<Node<keyType, valueType>> &node,
-    std::ofstream &outFile,
-    std::unordered_map<std::shared_ptr<Node<keyType, valueType>>, uint64_t>
-        &nodeOffsetMap,
-    uint64_t &currentOffset) const {
-  if (!node) {
-    std::cout << "Skipping null node at offset " << currentOffset << std::endl;
-    return;
-  }
-
-  // 分配当前偏移量给节点
-  uint64_t nodeOffset = currentOffset;
-  nodeOffsetMap[node] = nodeOffset;
-  std::cout << "Saving node at offset " << nodeOffset
-            << ", isLeaf: " << node->isLeafNode() << ", keys: ";
-  for (const auto &key : node->keys)
-    std::cout << key << " ";
-  std::cout << std::endl;
+// 把节点写入页
+template <typename keyType, typename valueType, size_t fanout>
+void BplusTree<keyType, valueType, fanout>::writeNodePage(
+    char *bytes, NodeHandle node, const PageId *childPages) const {
+  auto currentNode = getNode(node);
+  NodePage header{};
+  header.isLeaf = currentNode->isLeafNode() ? 1 : 0;
 
-  SerializedNode snode; // 确保模板化
-  snode.isLeaf = node->isLeafNode();
-  snode.keyCount = node->keys.size();
-  snode.keys = node->keys;
-
-  // 预计算节点大小
-  uint64_t nodeSize =
-      sizeof(bool) + sizeof(size_t) + snode.keys.size() * sizeof(keyType) +
-      (snode.isLeaf ? snode.keyCount * sizeof(valueType) + sizeof(uint64_t)
-                    : (snode.keyCount + 1) * sizeof(uint64_t));
-
-  // 递归保存子节点，递增 currentOffset
-  if (node->isLeafNode()) {
-    auto leafNode =
-        std::dynamic_pointer_cast<LeafNode<keyType, valueType>>(node);
-    snode.values = leafNode->values;
-
-    snode.nextOffset = 0; // 初始为0，稍后更新
-    std::cout << "Leaf node nextOffset: " << snode.nextOffset << std::endl;
-  } else {
-    auto interNode =
-        std::dynamic_pointer_cast<InterNode<keyType, valueType>>(node);
-    snode.children.resize(interNode->children.size());
-    for (size_t i = 0; i < interNode->children.size(); ++i) {
-
-      if (interNode->children[i]) {
-        if (i == 0) {
-          std::cout << "CurrentOffset is:" << currentOffset << std::endl;
-          currentOffset += nodeSize; // 预留空间
-          std::cout << "CurrentOffset is:" << currentOffset << std::endl;
-        }
-        saveNodeToFile(interNode->children[i], outFile, nodeOffsetMap,
-                       currentOffset);
-        std::cout << "Insert currentOffset is:" << currentOffset << std::endl;
-      }
-    }
-    for (size_t i = 0; i < interNode->children.size(); ++i) {
-      snode.children[i] =
-          interNode->children[i] ? nodeOffsetMap[interNode->children[i]] : 0;
-      std::cout << "Child " << i << " offset: " << snode.children[i]
-                << std::endl;
-    }
-  }
-
-  // 写入数据
-  std::cout << "CurrentOffset is:" << nodeOffset << std::endl;
-  outFile.seekp(static_cast<std::streamoff>(nodeOffset));
-  outFile.write(reinterpret_cast<const char *>(&snode.isLeaf), sizeof(bool));
-  outFile.write(reinterpret_cast<const char *>(&snode.keyCount),
-                sizeof(size_t));
-  outFile.write(reinterpret_cast<const char *>(snode.keys.data()),
-                snode.keys.size() * sizeof(keyType));
-  if (snode.isLeaf) {
-    outFile.write(reinterpret_cast<const char *>(snode.values.data()),
-                  snode.values.size() * sizeof(valueType));
-    // 写入初始 nextOffset
-    outFile.write(reinterpret_cast<const char *>(&snode.nextOffset),
-                  sizeof(uint64_t));
+  if (currentNode->isLeafNode()) {
+    // 叶子的keys/values在写锁内一并复制(不分裂的插入/删除只锁叶子)
+    auto leafNode = getLeaf(node);
+    latchOf(node).lock();
+    size_t count = leafNode->keys.size();
+    header.keyCount = static_cast<uint32_t>(count);
+    size_t keyBytes = storeKeys(bytes, leafNode->keys);
+    storeValues(bytes, keyBytes, leafNode);
+    latchOf(node).unlock();
   } else {
-    outFile.write(reinterpret_cast<const char *>(snode.children.data()),
-                  snode.children.size() * sizeof(uint64_t));
-  }
-
-  // 动态更新叶子节点的 nextOffset
-  // if (snode.isLeaf) {
-  //   auto leafNode =
-  //       std::dynamic_pointer_cast<LeafNode<keyType, valueType>>(node);
-  //   if (leafNode->next &&
-  //       nodeOffsetMap.find(leafNode->next) != nodeOffsetMap.end()) {
-  //     snode.nextOffset = nodeOffsetMap[leafNode->next];
-  //     // 回写 nextOffset
-  //     outFile.seekp(static_cast<std::streamoff>(
-  //         nodeOffset + sizeof(bool) + sizeof(size_t) +
-  //         snode.keys.size() * sizeof(keyType) +
-  //         snode.keyCount * sizeof(valueType)));
-  //     outFile.write(reinterpret_cast<const char *>(&snode.nextOffset),
-  //                   sizeof(uint64_t));
-  //     std::cout << "Updated Leaf node nextOffset: " << snode.nextOffset
-  //               << std::endl;
-  //   }
-  // }
-
-  // 更新 currentOffset
-  if (node->isLeafNode()) {
-    currentOffset = nodeOffset + nodeSize;
-  }
-
-  std::cout << "Updated offset after writing: " << currentOffset << std::endl;
-
-  if (!outFile.good()) {
-    throw std::runtime_error("Failed to write node to file");
+    auto interNode = getInter(node);
+    size_t count = interNode->keys.size();
+    header.keyCount = static_cast<uint32_t>(count);
+    size_t keyBytes = storeKeys(bytes, interNode->keys);
+    std::memcpy(bytes + pageChildrenOffset(keyBytes), childPages,
+                (count + 1) * sizeof(PageId));
   }
+  std::memcpy(bytes, &header, sizeof(NodePage));
 }
 
-// 从文件加载节点
-template <typename keyType, typename valueType>
-void BplusTree<keyType, valueType>::loadNodeFromFile(
-    std::ifstream &inFile, uint64_t offset,
-    std::unordered_map<uint64_t, std::shared_ptr<Node<keyType, valueType>>>
-        &offsetNodeMap) const {
-  if (offsetNodeMap.find(offset) != offsetNodeMap.end()) {
-    std::cout << "Node at offset " << offset << " already loaded, skipping"
-              << std::endl;
-    return;
+// 将节点存入文件
+template <typename keyType, typename valueType, size_t fanout>
+PageId BplusTree<keyType, valueType, fanout>::saveNodeToFile(NodeHandle node,
+                                                             PageFile &file,
+                                                             BufferPool &pool) {
+  auto currentNode = getNode(node);
+  PageId page = file.allocate();
+  // 复制内容之前清除标记，之后的修改留给下一次检查点
+  currentNode->dirty.store(false);
+  currentNode->page = page;
+  BPLUSTREE_LOG(LogLevel::Trace, "node.save", {"page", page},
+                {"leaf", currentNode->isLeafNode()});
+
+  // 子节点先写出，父节点页里才能填入子节点页号
+  std::vector<PageId> childPages;
+  if (!currentNode->isLeafNode()) {
+    auto interNode = getInter(node);
+    childPages.reserve(interNode->children.size());
+    for (NodeHandle child : interNode->children) {
+      childPages.push_back(saveNodeToFile(child, file, pool));
+    }
   }
 
-  std::cout << "Loading node at offset " << offset << std::endl;
-  inFile.seekg(static_cast<std::streamoff>(offset));
-  if (!inFile.good()) {
-    throw std::runtime_error("Failed to seek to offset " +
-                             std::to_string(offset) + " in file");
+  PageGuard guard(pool, page, PageGuard::Create{});
+  writeNodePage(guard.data(), node, childPages.data());
+  return page;
+}
+
+// 从文件加载节点
+template <typename keyType, typename valueType, size_t fanout>
+NodeHandle BplusTree<keyType, valueType, fanout>::loadNodeFromFile(
+    BufferPool &pool, PageId page, int depth, const MetaData &metaData,
+    std::vector<bool> &usedPages) {
+  if (page < HEADER_PAGES || page >= metaData.pageCount ||
+      depth > metaData.treeHeight || usedPages[page]) {
+    throw std::runtime_error("Corrupted node reference to page " +
+                             std::to_string(page));
   }
+  usedPages[page] = true;
+
+  BPLUSTREE_LOG(LogLevel::Trace, "node.load", {"page", page},
+                {"depth", depth});
+  NodeHandle newNode;
+  std::vector<PageId> childPages;
+  {
+    PageGuard guard(pool, page);
+    const char *bytes = guard.data();
+    NodePage header;
+    std::memcpy(&header, bytes, sizeof(NodePage));
+    size_t count = header.keyCount;
+    size_t keyBytes;
+    if (header.isLeaf > 1 ||
+        (header.isLeaf == 0) != (depth < metaData.treeHeight) ||
+        !checkNodePage(bytes, header.isLeaf, count, pool.pageSize(),
+                       keyBytes)) {
+      throw std::runtime_error("Corrupted node at page " +
+                               std::to_string(page));
+    }
 
-  SerializedNode snode;
-  inFile.read(reinterpret_cast<char *>(&snode.isLeaf), sizeof(bool));
-  inFile.read(reinterpret_cast<char *>(&snode.keyCount), sizeof(size_t));
-  snode.keys.resize(snode.keyCount);
-  inFile.read(reinterpret_cast<char *>(snode.keys.data()),
-              snode.keys.size() * sizeof(keyType));
-  std::cout << "Read node: isLeaf=" << snode.isLeaf
-            << ", keyCount=" << snode.keyCount << ", keys: ";
-  for (const auto &key : snode.keys)
-    std::cout << key << " ";
-  std::cout << std::endl;
-  if (!inFile.good()) {
-    throw std::runtime_error("Failed to read keys at offset " +
-                             std::to_string(offset));
-  }
-
-  if (snode.isLeaf) {
-    snode.values.resize(snode.keyCount);
-    inFile.read(reinterpret_cast<char *>(snode.values.data()),
-                snode.values.size() * sizeof(valueType));
-    inFile.read(reinterpret_cast<char *>(&snode.nextOffset), sizeof(uint64_t));
-    std::cout << "Leaf node values: ";
-    for (const auto &val : snode.values)
-      std::cout << val << " ";
-    std::cout << ", nextOffset=" << snode.nextOffset << std::endl;
-    if (!inFile.good()) {
-      throw std::runtime_error(
-          "Failed to read values or nextOffset at offset " +
-          std::to_string(offset));
+    newNode = header.isLeaf ? allocLeaf() : allocInter();
+    loadKeys(getNode(newNode)->keys, bytes, count, keyBytes);
+    if (header.isLeaf) {
+      loadValues(getLeaf(newNode), bytes, count, keyBytes);
+    } else {
+      childPages.resize(count + 1);
+      std::memcpy(childPages.data(), bytes + pageChildrenOffset(keyBytes),
+                  childPages.size() * sizeof(PageId));
     }
-  } else {
-    snode.children.resize(snode.keyCount + 1);
-    inFile.read(reinterpret_cast<char *>(snode.children.data()),
-                snode.children.size() * sizeof(uint64_t));
-    std::cout << "Internal node children offsets: ";
-    for (const auto &child : snode.children)
-      std::cout << child << " ";
-    std::cout << std::endl;
-    if (!inFile.good()) {
-      throw std::runtime_error("Failed to read children at offset " +
-                               std::to_string(offset));
-    }
-  }
-
-  std::shared_ptr<Node<keyType, valueType>> newNode;
-  if (snode.isLeaf) {
-    auto leaf = std::make_shared<LeafNode<keyType, valueType>>();
-    leaf->keys = snode.keys;
-    leaf->values = snode.values;
-    newNode = leaf;
-  } else {
-    auto inter = std::make_shared<InterNode<keyType, valueType>>();
-    inter->keys = snode.keys;
-    inter->children.resize(snode.children.size());
-    newNode = inter;
   }
 
-  offsetNodeMap[offset] = newNode;
-  std::cout << "Node cached at offset " << offset << std::endl;
-
-  if (snode.isLeaf && snode.nextOffset != 0) {
-    std::cout << "Loading next leaf at offset " << snode.nextOffset
-              << std::endl;
-    loadNodeFromFile(inFile, snode.nextOffset, offsetNodeMap);
-    std::dynamic_pointer_cast<LeafNode<keyType, valueType>>(newNode)->next =
-        std::dynamic_pointer_cast<LeafNode<keyType, valueType>>(
-            offsetNodeMap[snode.nextOffset]);
-  } else if (!snode.isLeaf) {
-    auto inter =
-        std::dynamic_pointer_cast<InterNode<keyType, valueType>>(newNode);
-    for (size_t i = 0; i < snode.children.size(); ++i) {
-      if (snode.children[i] != 0) {
-        std::cout << "Loading child " << i << " at offset " << snode.children[i]
-                  << std::endl;
-        loadNodeFromFile(inFile, snode.children[i], offsetNodeMap);
-        inter->children[i] = offsetNodeMap[snode.children[i]];
-      }
+  // 页已解除钉住，递归加载子节点时页缓存可以淘汰它
+  // 子树加载失败时释放本节点和已加载的子节点，再抛出
+  try {
+    for (size_t i = 0; i < childPages.size(); ++i) {
+      NodeHandle child = loadNodeFromFile(pool, childPages[i], depth + 1,
+                                          metaData, usedPages);
+      getInter(newNode)->children.push_back(child);
+      getNode(child)->parent = newNode;
     }
+  } catch (...) {
+    releaseUnpublished(newNode);
+    throw;
   }
+
+  // 与文件内容一致，之后的检查点只在修改后重写
+  getNode(newNode)->page = page;
+  getNode(newNode)->dirty.store(false);
+  return newNode;
 }
 
 // 外部接口
 // 插入操作(test)
-template <typename keyType, typename valueType>
-inline void BplusTree<keyType, valueType>::insert(const keyType &key,
-                                                  const valueType &value) {
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::applyInsert(
+    const keyType &key, const valueType &value) {
+  checkKeyLength(key);
+
+  // 不能乐观读取的类型加上独占锁
+  auto write_lock = writeGuard();
+
+  // 0.叶子未满时只锁叶子完成插入
+  if (tryInsertInLeaf(key, value) == LeafOp::Done) {
+    return;
+  }
 
-  // 加上独占锁
-  std::unique_lock<std::shared_mutex> write_lock(rw_mutex);
+  // 需要分裂：串行化结构修改(内部节点只在结构修改中变化，可直接下降)
+  SmoGuard smo(*this);
 
   // 1.判断是否为空
-  if (!root) {
-    root = std::make_shared<LeafNode<keyType, valueType>>();
+  if (root == NULL_HANDLE) {
+    root = allocLeaf();
     // head = root;
   }
 
   // 2.循环遍历找到插入位置
-  std::shared_ptr<LeafNode<keyType, valueType>> targetLeaf =
-      findLeaf(root, key);
+  NodeHandle targetLeaf = findLeaf(root, key, Seek::Last);
 
   // 3.进行插入操作
+  smoLatch(targetLeaf);
+  if constexpr (packedLeaves) {
+    // 压缩叶子按字节装填，放不下时连同新键值对重新分组
+    auto leafNode = getLeaf(targetLeaf);
+    if (leafRoom(leafNode, key, value)) {
+      insertInLeaf(targetLeaf, key, value);
+      return;
+    }
+    std::vector<keyType> keys(leafNode->keys.begin(), leafNode->keys.end());
+    std::vector<valueType> values(leafNode->values.begin(),
+                                  leafNode->values.end());
+    size_t pos = lowerIndex(leafNode->keys, key);
+    keys.insert(keys.begin() + pos, key);
+    values.insert(values.begin() + pos, value);
+    bool append = !leafNode->hasHighKey && pos + 1 == keys.size();
+    spreadLeaf(targetLeaf, keys, values, append);
+    return;
+  }
   insertInLeaf(targetLeaf, key, value);
 
   // 4.检查是否需要分裂
-  if (targetLeaf->keys.size() > maxKeys) {
-
-    std::shared_ptr<Node<keyType, valueType>> currentNode = targetLeaf;
-    // 可能需要分裂
-    while (currentNode && currentNode->keys.size() > maxKeys) {
-
-      // 根节点
-      if (currentNode == root) {
-        splitRoot(currentNode);
-      } else {
-        // 叶子节点
-        if (currentNode->isLeafNode()) {
-          splitLeaf(std::dynamic_pointer_cast<LeafNode<keyType, valueType>>(
-              currentNode));
-        } else {
-          // 内部节点
-          splitInter(std::dynamic_pointer_cast<InterNode<keyType, valueType>>(
-              currentNode));
-        }
-        currentNode = currentNode->parent;
-      }
-    }
-  }
+  splitOverflow(targetLeaf);
 
   // // 叶子节点
   // if (currentNode->isLeafNode()) {
@@ -1175,33 +2812,375 @@ inline void BplusTree<keyType, valueType>::insert(const keyType &key,
   // }
 }
 
+// 批量构建
+template <typename keyType, typename valueType, size_t fanout>
+template <typename Iterator>
+inline void BplusTree<keyType, valueType, fanout>::applyBulkLoad(
+    Iterator begin, Iterator end, double fillFactor) {
+
+  if (!(fillFactor > 0.0 && fillFactor <= 1.0)) {
+    throw std::runtime_error("Invalid fill factor: " +
+                             std::to_string(fillFactor));
+  }
+  // 先校验输入再丢弃旧树，失败时原有内容保持不变
+  auto byKey = [](const auto &a, const auto &b) { return a.first < b.first; };
+  if (!std::is_sorted(begin, end, byKey)) {
+    throw std::runtime_error("bulkLoad input is not sorted by key");
+  }
+  size_t total = static_cast<size_t>(std::distance(begin, end));
+  if constexpr (slottedKeys) {
+    for (Iterator it = begin; it != end; ++it) {
+      checkKeyLength((*it).first);
+    }
+  }
+
+  // 整个构建只加一次锁：新节点在发布根之前对其他线程不可见，无需节点写锁
+  auto write_lock = writeGuard();
+  SmoGuard smo(*this);
+  discardTree();
+  if (total == 0) {
+    return;
+  }
+
+  // 每个节点的装填数量
+  auto fillCount = [fillFactor](size_t capacity, size_t lower) {
+    size_t target = static_cast<size_t>(capacity * fillFactor + 0.5);
+    return std::min(capacity, std::max(lower, target));
+  };
+
+  // 1.从左到右顺序装填叶子
+  // 节点数按装填比例确定，但不让节点低于最小键数(末尾节点也不会过空)
+  size_t leafMin = std::max<size_t>(minKeys, 1);
+  std::vector<size_t> leafSizes;
+  if constexpr (packedLeaves) {
+    // 压缩叶子按字节装填：依次放入，直到再放一个就超出字节区的装填比例
+    size_t area = LeafNode<keyType, valueType>::areaBytes(leafCapacity);
+    size_t budget = std::max<size_t>(1, static_cast<size_t>(area * fillFactor));
+    size_t limit = leafKeyLimit();
+    PackedRange<keyType> keyRange;
+    PackedRange<valueType> valueRange;
+    size_t n = 0;
+    for (Iterator it = begin; it != end; ++it) {
+      const auto &entry = *it;
+      auto nextKeys = keyRange.with(entry.first);
+      auto nextValues = valueRange.with(entry.second);
+      if (n > 0 && (n == limit || nextKeys.bytes(n + 1) +
+                                          nextValues.bytes(n + 1) >
+                                      budget)) {
+        leafSizes.push_back(n);
+        n = 0;
+        nextKeys = PackedRange<keyType>().with(entry.first);
+        nextValues = PackedRange<valueType>().with(entry.second);
+      }
+      keyRange = nextKeys;
+      valueRange = nextValues;
+      ++n;
+    }
+    leafSizes.push_back(n);
+  } else {
+    leafSizes = evenSplit(total, fillCount(maxKeys, leafMin), leafMin);
+  }
+  std::vector<NodeHandle> level;
+  std::vector<keyType> lowKeys;
+  level.reserve(leafSizes.size());
+  lowKeys.reserve(leafSizes.size());
+
+  Iterator it = begin;
+  for (size_t count : leafSizes) {
+    NodeHandle leaf = allocLeaf();
+    level.push_back(leaf);
+    auto leafNode = getLeaf(leaf);
+    for (size_t i = 0; i < count; ++i, ++it) {
+      const auto &entry = *it;
+      leafNode->keys.push_back(entry.first);
+      leafNode->values.push_back(entry.second);
+    }
+    lowKeys.push_back(
+        level.size() > 1
+            ? separatorKey(getLeaf(level[level.size() - 2])->keys.back(),
+                           leafNode->keys.front())
+            : keyType(leafNode->keys.front()));
+  }
+  linkLevel(level, lowKeys);
+
+  // 2.自底向上逐层构建内部节点，子节点i(i > 0)子树的最小key作为分隔key
+  size_t childrenMin = std::max<size_t>(minKeys + 1, 2);
+  size_t childrenFill = fillCount(maxKeys + 1, childrenMin);
+  while (level.size() > 1) {
+    std::vector<size_t> sizes =
+        evenSplit(level.size(), childrenFill, childrenMin);
+    std::vector<NodeHandle> upper;
+    std::vector<keyType> upperLowKeys;
+    upper.reserve(sizes.size());
+    upperLowKeys.reserve(sizes.size());
+
+    size_t index = 0;
+    for (size_t count : sizes) {
+      NodeHandle inter = allocInter();
+      auto interNode = getInter(inter);
+      upperLowKeys.push_back(lowKeys[index]);
+      for (size_t i = 0; i < count; ++i, ++index) {
+        if (i > 0) {
+          interNode->keys.push_back(lowKeys[index]);
+        }
+        interNode->children.push_back(level[index]);
+        getNode(level[index])->parent = inter;
+      }
+      upper.push_back(inter);
+    }
+    linkLevel(upper, upperLowKeys);
+
+    level.swap(upper);
+    lowKeys.swap(upperLowKeys);
+  }
+
+  // 3.发布新根
+  root = level.front();
+  if (learnedEnabled) {
+    rebuildLearned();
+  }
+}
+
+// 批量插入
+template <typename keyType, typename valueType, size_t fanout>
+template <typename Iterator>
+inline void BplusTree<keyType, valueType, fanout>::insertBatch(Iterator begin,
+                                                               Iterator end,
+                                                               bool sorted) {
+
+  auto byKey = [](const auto &a, const auto &b) { return a.first < b.first; };
+
+  // 无序输入先复制一份稳定排序
+  if (!sorted) {
+    std::vector<std::pair<keyType, valueType>> batch(begin, end);
+    std::stable_sort(batch.begin(), batch.end(), byKey);
+    insertBatch(batch.begin(), batch.end(), true);
+    return;
+  }
+  if (!std::is_sorted(begin, end, byKey)) {
+    throw std::runtime_error("insertBatch input is not sorted by key");
+  }
+  if constexpr (slottedKeys) {
+    for (Iterator it = begin; it != end; ++it) {
+      checkKeyLength((*it).first);
+    }
+  }
+  if (begin == end) {
+    return;
+  }
+  if (!wal) {
+    applySortedBatch(begin, end);
+    return;
+  }
+
+  // 整批记录在同一次提交中落盘
+  uint64_t lsn = 0;
+  {
+    std::lock_guard<std::mutex> wal_lock(walMutex);
+    applySortedBatch(begin, end);
+    for (Iterator it = begin; it != end; ++it) {
+      lsn = logRecord(WalOp::Insert, it->first, it->second);
+    }
+  }
+  wal->commit(lsn);
+}
+
+// 插入已排序的批次
+template <typename keyType, typename valueType, size_t fanout>
+template <typename Iterator>
+inline void BplusTree<keyType, valueType, fanout>::applySortedBatch(
+    Iterator begin, Iterator end) {
+
+  // 整批只加一次锁(内部节点只在结构修改中变化，可直接下降)
+  auto write_lock = writeGuard();
+  SmoGuard smo(*this);
+
+  if (root == NULL_HANDLE) {
+    root = allocLeaf();
+  }
+
+  std::vector<keyType> runKeys, mergedKeys;
+  std::vector<valueType> runValues, mergedValues;
+
+  Iterator it = begin;
+  while (it != end) {
+
+    // 1.每个目标叶子只下降一次
+    NodeHandle targetLeaf = findLeaf(root, (*it).first, Seek::Last);
+    smoLatch(targetLeaf);
+    auto leafNode = getLeaf(targetLeaf);
+
+    // 2.取出落在该叶子范围内(小于上界)的一段
+    // 第一个key总是归入该叶子(与insert一致；存在重复key时叶子中可能
+    // 有等于上界的key，按上界截断可能得到空段)
+    runKeys.clear();
+    runValues.clear();
+    for (Iterator first = it;
+         it != end && (it == first || !leafNode->beyondHighKey((*it).first));
+         ++it) {
+      const auto &entry = *it;
+      runKeys.push_back(entry.first);
+      runValues.push_back(entry.second);
+    }
+
+    // 3.放得下时从后往前原地归并，每个元素只移动一次
+    // 新key排在等值的原有key之前(与insertInLeaf一致)
+    // 变长key被挪走的副本在归并结束前仍占着字节区，可能放不下；压缩叶子
+    // 按字节装填，归并后的宽度事先不知道，两者都改走临时区
+    size_t oldSize = leafNode->keys.size();
+    size_t total = oldSize + runKeys.size();
+    if (total <= maxKeys && !slottedKeys && !packedLeaves) {
+      leafNode->keys.resize(total);
+      leafNode->values.resize(total);
+      size_t i = oldSize;
+      size_t j = runKeys.size();
+      for (size_t w = total; j > 0;) {
+        --w;
+        if (i > 0 && !(leafNode->keys[i - 1] < runKeys[j - 1])) {
+          --i;
+          leafNode->keys[w] = std::move(leafNode->keys[i]);
+          leafNode->values[w] = std::move(leafNode->values[i]);
+        } else {
+          --j;
+          leafNode->keys[w] = runKeys[j];
+          leafNode->values[w] = runValues[j];
+        }
+      }
+      smoUnlatchAll();
+      continue;
+    }
+
+    // 4.放不下时归并到临时区，再一次均匀分成若干个叶子
+    mergedKeys.clear();
+    mergedValues.clear();
+    size_t index = 0;
+    for (size_t j = 0; j < runKeys.size(); ++j) {
+      for (; index < oldSize && leafNode->keys[index] < runKeys[j]; ++index) {
+        mergedKeys.push_back(leafNode->keys[index]);
+        mergedValues.push_back(leafNode->values[index]);
+      }
+      mergedKeys.push_back(runKeys[j]);
+      mergedValues.push_back(runValues[j]);
+    }
+    bool append = index == oldSize && !leafNode->hasHighKey;
+    mergedKeys.insert(mergedKeys.end(), leafNode->keys.begin() + index,
+                      leafNode->keys.end());
+    mergedValues.insert(mergedValues.end(), leafNode->values.begin() + index,
+                        leafNode->values.end());
+
+    // 5.新叶子依次插入父节点，父节点溢出时照常向上分裂
+    spreadLeaf(targetLeaf, mergedKeys, mergedValues, append);
+
+    // 该叶子处理完后树已一致，放开本轮加的写锁(smoMutex仍然持有)
+    smoUnlatchAll();
+  }
+}
+
+// 重新分配叶子内容
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::spreadLeaf(
+    NodeHandle targetLeaf, const std::vector<keyType> &keys,
+    const std::vector<valueType> &values, bool append) {
+
+  // 1.分组：第一组留在原叶子
+  std::vector<size_t> sizes;
+  if constexpr (packedLeaves) {
+    sizes = packedSizes(keys, values, append);
+  } else {
+    (void)append;
+    sizes = evenSplit(keys.size(), maxKeys, std::max<size_t>(minKeys, 1));
+  }
+  auto leafNode = getLeaf(targetLeaf);
+  size_t offset = sizes[0];
+  leafNode->keys.assign(keys.begin(), keys.begin() + offset);
+  leafNode->values.assign(values.begin(), values.begin() + offset);
+  if (sizes.size() == 1) {
+    return;
+  }
+
+  // 2.其余各组放入新叶子
+  std::vector<NodeHandle> newLeaves;
+  std::vector<keyType> separators;
+  for (size_t i = 1; i < sizes.size(); ++i) {
+    NodeHandle newLeaf = allocLeaf();
+    auto newLeafNode = getLeaf(newLeaf);
+    newLeafNode->keys.assign(keys.begin() + offset,
+                             keys.begin() + offset + sizes[i]);
+    newLeafNode->values.assign(values.begin() + offset,
+                               values.begin() + offset + sizes[i]);
+    offset += sizes[i];
+    NodeHandle left = newLeaves.empty() ? targetLeaf : newLeaves.back();
+    separators.push_back(
+        separatorKey(getLeaf(left)->keys.back(), newLeafNode->keys.front()));
+    newLeaves.push_back(newLeaf);
+  }
+
+  // 从右往左挂到原叶子之后，每个新叶子在可见之前链接就已设好
+  for (size_t i = newLeaves.size(); i-- > 0;) {
+    linkSplit(targetLeaf, newLeaves[i], separators[i]);
+  }
+
+  // 3.新叶子依次插入父节点
+  // B-link：新叶子已可经右链接到达，先放开叶子再去改父节点
+  // (此后叶子可能被快速路径修改，只能使用已保存的分隔key)
+  if (blinkMode) {
+    smoUnlatchAll();
+  }
+
+  // 根节点为叶子时先长出一个新根
+  if (getNode(targetLeaf)->parent == NULL_HANDLE) {
+    NodeHandle newRoot = allocInter();
+    getInter(newRoot)->children.push_back(targetLeaf);
+    getNode(targetLeaf)->parent = newRoot;
+    root = newRoot;
+  }
+
+  NodeHandle prev = targetLeaf;
+  for (size_t i = 0; i < newLeaves.size(); ++i) {
+    NodeHandle parent = getNode(prev)->parent;
+    getNode(newLeaves[i])->parent = parent;
+    updateParentPointers(parent, prev, newLeaves[i], separators[i]);
+    splitOverflow(parent);
+    prev = newLeaves[i];
+  }
+}
+
 // 删除操作(test)
-template <typename keyType, typename valueType>
-inline bool BplusTree<keyType, valueType>::remove(const keyType &key) {
+template <typename keyType, typename valueType, size_t fanout>
+inline bool
+BplusTree<keyType, valueType, fanout>::applyRemove(const keyType &key) {
+
+  // 不能乐观读取的类型加上独占锁
+  auto write_lock = writeGuard();
+
+  // 0.删除后不下溢时只锁叶子完成删除
+  LeafOp fast = tryRemoveInLeaf(key);
+  if (fast != LeafOp::NeedSmo) {
+    if (fast == LeafOp::NotFound && root == NULL_HANDLE) {
+      BPLUSTREE_LOG(LogLevel::Debug, "tree.empty", {"op", "remove"});
+    }
+    return fast == LeafOp::Done;
+  }
 
-  // 加上独占锁
-  std::unique_lock<std::shared_mutex> write_lock(rw_mutex);
+  // 需要借调或合并：串行化结构修改
+  SmoGuard smo(*this);
 
   // 根节点为空
-  if (!root) {
-    std::cout << "Tree is empty.\n" << std::endl;
+  if (root == NULL_HANDLE) {
+    BPLUSTREE_LOG(LogLevel::Debug, "tree.empty", {"op", "remove"});
     return false; // 树为空
   }
 
   // 1.寻找目标叶子结点
-  auto targetLeaf = findLeaf(root, key);
-  if (!targetLeaf) {
-    // std::cout << "Key not found in the tree.\n" << std::endl;
-    return false; // 未找到叶子结点
-  }
+  NodeHandle targetLeaf = latchFirstLeaf(key);
+  auto leafNode = getLeaf(targetLeaf);
 
   // 2.在叶子结点中找到对应key，并删除
-  auto it =
-      std::lower_bound(targetLeaf->keys.begin(), targetLeaf->keys.end(), key);
-  if (it != targetLeaf->keys.end()) {
-    size_t index = std::distance(targetLeaf->keys.begin(), it);
-    targetLeaf->keys.erase(it);
-    targetLeaf->values.erase(targetLeaf->values.begin() + index);
+  auto it = leafNode->keys.begin() + lowerIndex(leafNode->keys, key);
+  if (it != leafNode->keys.end() && *it == key) {
+    size_t index = std::distance(leafNode->keys.begin(), it);
+    leafNode->keys.erase(it);
+    leafNode->values.erase(leafNode->values.begin() + index);
     // std::cout << "Key deleted successfully.\n" << std::endl;
   } else {
     // std::cout << "Key not found in the leaf node.\n" << std::endl;
@@ -1209,16 +3188,15 @@ inline bool BplusTree<keyType, valueType>::remove(const keyType &key) {
   }
 
   // 3.不满足要求，进入调整过程
-  if (targetLeaf->keys.size() < minKeys) {
-    auto parent = std::dynamic_pointer_cast<InterNode<keyType, valueType>>(
-        targetLeaf->parent);
-    if (parent) { // 非根节点
-      return adjust(
-          std::dynamic_pointer_cast<Node<keyType, valueType>>(targetLeaf),
-          parent);
+  if (leafUnderflow(leafNode, leafNode->keys.size())) {
+    NodeHandle parent = leafNode->parent;
+    if (parent != NULL_HANDLE) { // 非根节点
+      return adjust(targetLeaf, parent);
     } else { // 根结点
-      if (targetLeaf->keys.empty()) {
-        root = nullptr;
+      if (leafNode->keys.empty()) {
+        freeNode(root);
+        root = NULL_HANDLE;
+        learned.clear();
       }
       return true;
     }
@@ -1229,262 +3207,667 @@ inline bool BplusTree<keyType, valueType>::remove(const keyType &key) {
 }
 
 // 单一查询(test)
-template <typename keyType, typename valueType>
-inline valueType BplusTree<keyType, valueType>::search(const keyType &key) {
+template <typename keyType, typename valueType, size_t fanout>
+inline valueType
+BplusTree<keyType, valueType, fanout>::search(const keyType &key) {
+
+  // 不能乐观读取的类型加上共享锁
+  auto read_lock = readGuard();
+
+  for (;;) {
+    // 获取叶子结点
+    NodeHandle targetLeaf;
+    uint64_t version;
+    if (!descendOptimistic(key, targetLeaf, version, Seek::First)) {
+      continue;
+    }
+
+    // 如果根为空返回
+    if (targetLeaf == NULL_HANDLE) {
+      BPLUSTREE_LOG(LogLevel::Debug, "tree.empty", {"op", "search"});
+      return valueType{}; // 返回默认构造值
+    }
+    auto leafNode = getLeaf(targetLeaf);
 
-  // 加上共享锁
-  std::shared_lock<std::shared_mutex> read_lock(rw_mutex);
+    // 查找候选目标key
+    size_t count = safeSize(leafNode->keys);
+    size_t i = lowerIndex(leafNode->keys, count, key);
 
-  // 如果根为空返回
-  if (!root) {
-    std::cout << "Tree is empty." << std::endl;
-    return valueType{}; // 返回默认构造值
+    // 进一步判断
+    valueType result{};
+    if (i < count && leafNode->keys[i] == key) {
+      result = leafNode->values[i];
+    }
+
+    // 读取期间叶子未被修改才返回
+    if (latchOf(targetLeaf).validate(version)) {
+      return result;
+    }
   }
+}
 
-  // 获取叶子结点
-  auto targetLeaf = findLeaf(root, key);
+// 批量搜索
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::multiSearch(
+    const std::vector<keyType> &keys, std::vector<valueType> &out) {
 
-  // 未找到直接返回
-  if (!targetLeaf) {
-    return valueType{}; // 返回默认构造值
+  // 不能乐观读取的类型加上共享锁
+  auto read_lock = readGuard();
+
+  out.resize(keys.size());
+  for (size_t first = 0; first < keys.size(); first += PROBE_GROUP) {
+    size_t count = std::min(PROBE_GROUP, keys.size() - first);
+    multiSearchGroup(keys.data() + first, count, out.data() + first);
   }
+}
+
+// 改动单键
+template <typename keyType, typename valueType, size_t fanout>
+inline bool BplusTree<keyType, valueType, fanout>::applyModify(
+    const keyType &key, const valueType &newValue) {
+
+  // 不能乐观读取的类型加上独占锁
+  auto write_lock = writeGuard();
+
+  // 只修改value，不改变结构，只需锁住叶子
+  NodeHandle targetLeaf;
+  for (;;) {
+    // 查找搜索key
+    uint64_t version;
+    if (!descendOptimistic(key, targetLeaf, version, Seek::First)) {
+      continue;
+    }
+
+    // 根节点为空
+    if (targetLeaf == NULL_HANDLE) {
+      BPLUSTREE_LOG(LogLevel::Debug, "tree.empty", {"op", "modify"});
+      return false; // 返回默认构造值
+    }
+    if (latchOf(targetLeaf).tryUpgrade(version)) {
+      break;
+    }
+  }
+  auto leafNode = getLeaf(targetLeaf);
 
   // 查找候选目标key
-  auto it =
-      std::lower_bound(targetLeaf->keys.begin(), targetLeaf->keys.end(), key);
+  auto it = leafNode->keys.begin() + lowerIndex(leafNode->keys, key);
 
   // 进一步判断
-  if (it != targetLeaf->keys.end() && *it == key) {
-    size_t i = std::distance(targetLeaf->keys.begin(), it);
-    return targetLeaf->values[i];
+  bool found = false;
+  if (it != leafNode->keys.end() && *it == key) {
+    size_t i = std::distance(leafNode->keys.begin(), it);
+    if constexpr (packedLeaves) {
+      // 新value使差值变宽、字节区放不下时，按插入的慢速路径重新分组
+      size_t count = leafNode->keys.size();
+      if (leafNode->keys.bytes() + leafNode->values.bytesWith(newValue, count) >
+          leafNode->keys.areaSize()) {
+        latchOf(targetLeaf).unlock();
+        return modifySpread(key, newValue);
+      }
+    }
+    leafNode->values[i] = newValue;
+    markDirty(targetLeaf);
+    found = true;
   }
 
-  return valueType{};
+  latchOf(targetLeaf).unlock();
+  return found;
 }
 
-// 改动单键
-template <typename keyType, typename valueType>
-inline bool BplusTree<keyType, valueType>::modify(const keyType &key,
-                                                  const valueType &newValue) {
+// 改写value后重新分组(压缩叶子)
+template <typename keyType, typename valueType, size_t fanout>
+inline bool BplusTree<keyType, valueType, fanout>::modifySpread(
+    const keyType &key, const valueType &newValue) {
+  SmoGuard smo(*this);
+  if (root == NULL_HANDLE) {
+    return false;
+  }
+  NodeHandle targetLeaf = latchFirstLeaf(key);
+  auto leafNode = getLeaf(targetLeaf);
+  size_t i = lowerIndex(leafNode->keys, key);
+  if (i == leafNode->keys.size() || !(leafNode->keys[i] == key)) {
+    return false;
+  }
+  std::vector<keyType> keys(leafNode->keys.begin(), leafNode->keys.end());
+  std::vector<valueType> values(leafNode->values.begin(),
+                                leafNode->values.end());
+  values[i] = newValue;
+  spreadLeaf(targetLeaf, keys, values, false);
+  return true;
+}
 
-  // 加上独占锁
-  std::unique_lock<std::shared_mutex> write_lock(rw_mutex);
+// 范围查询(test)
+template <typename keyType, typename valueType, size_t fanout>
+inline std::vector<std::pair<keyType, valueType>>
+BplusTree<keyType, valueType, fanout>::rangeSearch(const keyType &startKey,
+                                                   const keyType &endKey) {
+
+  std::vector<std::pair<keyType, valueType>> result;
 
   // 根节点为空
-  if (!root) {
-    std::cout << "Tree is empty." << std::endl;
-    return false; // 返回默认构造值
+  if (root.load(std::memory_order_acquire) == NULL_HANDLE) {
+    BPLUSTREE_LOG(LogLevel::Debug, "tree.empty", {"op", "rangeSearch"});
+    return result;
   }
 
-  // 查找搜索key
-  auto targetLeaf = findLeaf(root, key);
-
-  // 未找到节点
-  if (!targetLeaf) {
-    return false; // 返回默认构造值
+  // 游标读到endKey即停止，不再遍历后续叶子
+  Cursor cursor(*this);
+  cursor.seek(startKey, endKey);
+  constexpr size_t chunk = 64;
+  keyType keys[chunk];
+  valueType values[chunk];
+  while (size_t count = cursor.nextN(keys, values, chunk)) {
+    for (size_t i = 0; i < count; ++i) {
+      result.push_back({keys[i], values[i]});
+    }
   }
+  return result;
+}
 
-  // 查找候选目标key
-  auto it =
-      std::lower_bound(targetLeaf->keys.begin(), targetLeaf->keys.end(), key);
+// 游标定位
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::Cursor::locate() {
+  const keyType &key = hasLast ? lastKey : seekKey;
+  Seek seek = hasLast ? Seek::Last : Seek::First;
+  for (;;) {
+    if (!tree.descendOptimistic(key, leaf, version, seek)) {
+      continue;
+    }
+    if (leaf == NULL_HANDLE) {
+      finished = true;
+      return;
+    }
 
-  // 进一步判断
-  if (it != targetLeaf->keys.end() && *it == key) {
-    size_t i = std::distance(targetLeaf->keys.begin(), it);
-    targetLeaf->values[i] = newValue;
-    return true;
+    // 从未返回过时从第一个 >= seekKey 开始，否则跳过 <= lastKey 的
+    auto leafNode = tree.getLeaf(leaf);
+    size_t count = safeSize(leafNode->keys);
+    pos = hasLast ? upperIndex(leafNode->keys, count, key)
+                  : lowerIndex(leafNode->keys, count, key);
+    if (tree.latchOf(leaf).validate(version)) {
+      return;
+    }
   }
+}
 
-  return false;
+template <typename keyType, typename valueType, size_t fanout>
+inline void
+BplusTree<keyType, valueType, fanout>::Cursor::seek(const keyType &key) {
+  seekKey = key;
+  bounded = false;
+  hasLast = false;
+  finished = false;
+  leaf = NULL_HANDLE;
 }
 
-// 范围查询(test)
-template <typename keyType, typename valueType>
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::Cursor::seek(
+    const keyType &key, const keyType &endKey) {
+  seek(key);
+  bounded = true;
+  this->endKey = endKey;
+}
+
+template <typename keyType, typename valueType, size_t fanout>
+inline bool BplusTree<keyType, valueType, fanout>::Cursor::next(
+    keyType &key, valueType &value) {
+  return nextN(&key, &value, 1) == 1;
+}
+
+// 批量读取：每个叶子读一段后校验一次，校验失败时丢弃这一段并重新定位
+template <typename keyType, typename valueType, size_t fanout>
+inline size_t BplusTree<keyType, valueType, fanout>::Cursor::nextN(
+    keyType *keys, valueType *values, size_t n) {
+
+  // 不能乐观读取的类型加上共享锁
+  auto read_lock = tree.readGuard();
+
+  size_t produced = 0;
+  while (produced < n && !finished) {
+    // 上次调用后叶子被修改过时重新定位
+    if (leaf != NULL_HANDLE && !tree.latchOf(leaf).validate(version)) {
+      leaf = NULL_HANDLE;
+    }
+    if (leaf == NULL_HANDLE) {
+      locate();
+      continue;
+    }
+
+    auto leafNode = tree.getLeaf(leaf);
+    size_t count = safeSize(leafNode->keys);
+    size_t taken = 0;
+    bool pastEnd = false;
+    if constexpr (packedLeaves) {
+      // 压缩叶子先用二分确定这一段，再整段解码
+      size_t last = std::min(count, pos + (n - produced));
+      if (bounded) {
+        size_t end = std::max(pos, upperIndex(leafNode->keys, count, endKey));
+        if (end < last) {
+          last = end;
+          pastEnd = true;
+        }
+      }
+      if (last > pos) {
+        taken = std::min(
+            leafNode->keys.decode(pos, last - pos, keys + produced),
+            leafNode->values.decode(pos, last - pos, values + produced));
+      }
+    } else {
+      for (size_t i = pos; i < count && produced + taken < n; ++i) {
+        // 边界判断
+        if (bounded && endKey < leafNode->keys[i]) {
+          pastEnd = true;
+          break;
+        }
+        keys[produced + taken] = leafNode->keys[i];
+        values[produced + taken] = leafNode->values[i];
+        ++taken;
+      }
+    }
+    NodeHandle nextLeaf = leafNode->next;
+    bool rightmost = !leafNode->hasHighKey;
+
+    // 读取期间叶子被修改，丢弃这一段
+    if (!tree.latchOf(leaf).validate(version)) {
+      leaf = NULL_HANDLE;
+      continue;
+    }
+    produced += taken;
+    pos += taken;
+    if (taken > 0) {
+      hasLast = true;
+      lastKey = keys[produced - 1];
+    }
+    if (pastEnd) {
+      finished = true;
+      break;
+    }
+    if (pos < count) {
+      break; // 缓冲区已满
+    }
+
+    // 本叶子读完，转到右侧叶子(先确认next读自未被修改的叶子)
+    // 懒加载时右侧叶子可能尚未读入：有上界却没有右链接时读入后沿补上的链接
+    // 继续，next是占位叶子时读入后重试；都不按lastKey重新定位(会跳过与它
+    // 相等的重复key)
+    if (nextLeaf == NULL_HANDLE) {
+      if (rightmost || !tree.resolveNeighbor(leaf, version, true)) {
+        finished = true;
+        break;
+      }
+      if (!tree.relatchLeaf(leaf, count, version)) {
+        leaf = NULL_HANDLE;
+      }
+      continue;
+    }
+    uint64_t nextVersion;
+    if (!tree.readNode(nextLeaf, nextVersion)) {
+      continue; // 本叶子被修改时在循环开头重新定位
+    }
+    if (!tree.latchOf(leaf).validate(version)) {
+      leaf = NULL_HANDLE;
+      continue;
+    }
+    leaf = nextLeaf;
+    version = nextVersion;
+    pos = 0;
+  }
+  return produced;
+}
+
+// 反向范围查询
+template <typename keyType, typename valueType, size_t fanout>
 inline std::vector<std::pair<keyType, valueType>>
-BplusTree<keyType, valueType>::rangeSearch(const keyType &startKey,
-                                           const keyType &endKey) {
+BplusTree<keyType, valueType, fanout>::reverseRangeSearch(
+    const keyType &startKey, const keyType &endKey) {
 
-  // 加上共享锁
-  std::shared_lock<std::shared_mutex> read_lock(rw_mutex);
+  std::vector<std::pair<keyType, valueType>> result;
 
   // 根节点为空
-  if (!root) {
-    std::cout << "Tree is empty." << std::endl;
-    return {}; // 返回空结果
+  if (root.load(std::memory_order_acquire) == NULL_HANDLE) {
+    BPLUSTREE_LOG(LogLevel::Debug, "tree.empty",
+                  {"op", "reverseRangeSearch"});
+    return result;
   }
 
-  std::vector<std::pair<keyType, valueType>> result;
+  // 从endKey向左读到startKey即停止
+  ReverseCursor cursor(*this);
+  cursor.seek(endKey, startKey);
+  constexpr size_t chunk = 64;
+  keyType keys[chunk];
+  valueType values[chunk];
+  while (size_t count = cursor.nextN(keys, values, chunk)) {
+    for (size_t i = 0; i < count; ++i) {
+      result.push_back({keys[i], values[i]});
+    }
+  }
+  return result;
+}
 
-  // 寻找起始叶子结点
-  auto startLeaf = findLeaf(root, startKey);
+// 反向游标定位
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::ReverseCursor::locate() {
+  const keyType &key = hasLast ? lastKey : seekKey;
+  Seek seek = hasLast ? Seek::First : Seek::Last;
+  for (;;) {
+    if (!tree.descendOptimistic(key, leaf, version, seek)) {
+      continue;
+    }
+    if (leaf == NULL_HANDLE) {
+      finished = true;
+      return;
+    }
 
-  // 未找到返回
-  if (!startLeaf) {
-    return result;
+    // 从未返回过时从最后一个 <= seekKey 开始，否则只取 < lastKey 的
+    auto leafNode = tree.getLeaf(leaf);
+    size_t count = safeSize(leafNode->keys);
+    pos = hasLast ? lowerIndex(leafNode->keys, count, key)
+                  : upperIndex(leafNode->keys, count, key);
+    if (tree.latchOf(leaf).validate(version)) {
+      return;
+    }
   }
+}
 
-  // 寻找第一个满足的key
-  auto it = std::lower_bound(startLeaf->keys.begin(), startLeaf->keys.end(),
-                             startKey);
+template <typename keyType, typename valueType, size_t fanout>
+inline void
+BplusTree<keyType, valueType, fanout>::ReverseCursor::seek(const keyType &key) {
+  seekKey = key;
+  bounded = false;
+  hasLast = false;
+  finished = false;
+  leaf = NULL_HANDLE;
+}
 
-  // 遍历当前叶子节点
-  while (it != startLeaf->keys.end()) {
-    // 边界判断
-    if (*it > endKey) {
-      break;
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::ReverseCursor::seek(
+    const keyType &key, const keyType &lowKey) {
+  seek(key);
+  bounded = true;
+  this->lowKey = lowKey;
+}
+
+template <typename keyType, typename valueType, size_t fanout>
+inline bool BplusTree<keyType, valueType, fanout>::ReverseCursor::next(
+    keyType &key, valueType &value) {
+  return nextN(&key, &value, 1) == 1;
+}
+
+// 反向批量读取：每个叶子读一段后校验一次
+template <typename keyType, typename valueType, size_t fanout>
+inline size_t BplusTree<keyType, valueType, fanout>::ReverseCursor::nextN(
+    keyType *keys, valueType *values, size_t n) {
+
+  // 不能乐观读取的类型加上共享锁
+  auto read_lock = tree.readGuard();
+
+  size_t produced = 0;
+  while (produced < n && !finished) {
+    // 上次调用后叶子被修改过时重新定位
+    if (leaf != NULL_HANDLE && !tree.latchOf(leaf).validate(version)) {
+      leaf = NULL_HANDLE;
+    }
+    if (leaf == NULL_HANDLE) {
+      locate();
+      continue;
     }
 
-    // 加入查询结果
-    size_t i = std::distance(startLeaf->keys.begin(), it);
-    result.push_back({*it, startLeaf->values[i]});
+    auto leafNode = tree.getLeaf(leaf);
+    size_t leafCount = safeSize(leafNode->keys);
+    size_t start = std::min(pos, leafCount);
+    size_t taken = 0;
+    bool pastEnd = false;
+    if constexpr (packedLeaves) {
+      // 压缩叶子先用二分确定这一段，整段解码后再倒序
+      size_t remaining = n - produced;
+      size_t first = bounded ? lowerIndex(leafNode->keys, start, lowKey) : 0;
+      size_t low = std::max(first, start > remaining ? start - remaining : 0);
+      pastEnd = first > 0 && start - first < remaining;
+      if (start > low) {
+        taken = std::min(
+            leafNode->keys.decode(low, start - low, keys + produced),
+            leafNode->values.decode(low, start - low, values + produced));
+        std::reverse(keys + produced, keys + produced + taken);
+        std::reverse(values + produced, values + produced + taken);
+      }
+    } else {
+      for (size_t i = start; i > 0 && produced + taken < n; --i) {
+        // 边界判断
+        if (bounded && leafNode->keys[i - 1] < lowKey) {
+          pastEnd = true;
+          break;
+        }
+        keys[produced + taken] = leafNode->keys[i - 1];
+        values[produced + taken] = leafNode->values[i - 1];
+        ++taken;
+      }
+    }
+    NodeHandle prevLeaf = leafNode->prev;
 
-    ++it;
-  }
+    // 读取期间叶子被修改，丢弃这一段
+    if (!tree.latchOf(leaf).validate(version)) {
+      leaf = NULL_HANDLE;
+      continue;
+    }
+    produced += taken;
+    pos = start - taken;
+    if (taken > 0) {
+      hasLast = true;
+      lastKey = keys[produced - 1];
+    }
+    if (pastEnd) {
+      finished = true;
+      break;
+    }
+    if (pos > 0) {
+      break; // 缓冲区已满
+    }
 
-  // 继续寻找后面叶子结点
-  auto nextLeaf = startLeaf->next;
-  while (nextLeaf) {
-    it = nextLeaf->keys.begin();
-    while (it != nextLeaf->keys.end()) {
-      if (*it > endKey) {
+    // 本叶子读完，转到左侧叶子
+    // 懒加载时空的反向链接也可能是左侧叶子尚未读入，读入后沿补上的链接继续
+    if (prevLeaf == NULL_HANDLE) {
+      if (!tree.lazyPending.load(std::memory_order_acquire)) {
+        // 懒加载可能在读到空链接之后才结束，期间补上链接会推进版本
+        if (tree.latchOf(leaf).validate(version)) {
+          finished = true;
+          break;
+        }
+        leaf = NULL_HANDLE;
+        continue;
+      }
+      if (!tree.resolveNeighbor(leaf, version, false)) {
+        finished = true;
         break;
       }
-      size_t i = std::distance(nextLeaf->keys.begin(), it);
-      result.push_back({*it, nextLeaf->values[i]});
-      ++it;
+      if (!tree.relatchLeaf(leaf, leafCount, version)) {
+        leaf = NULL_HANDLE;
+      }
+      continue;
     }
-    nextLeaf = nextLeaf->next;
-  }
 
-  return result;
+    // prev不受版本保护：左兄弟必须是以next指回本叶子的叶子，
+    // 且两个叶子在同一时刻都未被修改，否则(左侧正在分裂或合并)重新定位
+    uint64_t prevVersion;
+    if (!tree.readNode(prevLeaf, prevVersion)) {
+      continue; // 占位叶子已读入时重试，本叶子被修改时在循环开头重新定位
+    }
+    auto prevNode = tree.getLeaf(prevLeaf);
+    bool linked = prevNode->isLeafNode() && prevNode->next == leaf;
+    size_t count = safeSize(prevNode->keys);
+    if (!linked || !tree.latchOf(prevLeaf).validate(prevVersion) ||
+        !tree.latchOf(leaf).validate(version)) {
+      leaf = NULL_HANDLE;
+      continue;
+    }
+    leaf = prevLeaf;
+    version = prevVersion;
+    pos = count;
+  }
+  return produced;
 }
 
 // 中序遍历
-template <typename keyType, typename valueType>
-inline void BplusTree<keyType, valueType>::inorderTraversal() {
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::inorderTraversal() {
 
-  // 加上共享锁
-  std::shared_lock<std::shared_mutex> read_lock(rw_mutex);
+  // 阻止结构修改，叶子内容在叶子写锁内读取
+  auto read_lock = readGuard();
+  std::lock_guard<std::mutex> smo_lock(smoMutex);
+  loadAll();
 
   // 根节点为空
-  if (!root) {
+  if (root == NULL_HANDLE) {
     std::cout << "Tree is empty." << std::endl;
     return;
   }
 
   // 获取头节点
-  std::shared_ptr<Node<keyType, valueType>> currentNode = root;
-  while (currentNode && !currentNode->isLeafNode()) {
-    currentNode =
-        (std::dynamic_pointer_cast<InterNode<keyType, valueType>>(currentNode)
-             ->children)
-            .front();
+  NodeHandle currentNode = root;
+  while (!getNode(currentNode)->isLeafNode()) {
+    currentNode = getInter(currentNode)->children.front();
   }
   // 遍历叶子结点
-  auto leaf =
-      std::dynamic_pointer_cast<LeafNode<keyType, valueType>>(currentNode);
+  NodeHandle leaf = currentNode;
   size_t count = 0;
-  while (leaf) {
-    for (size_t i = 0; i < leaf->keys.size(); ++i) {
-      std::cout << leaf->keys[i] << ":" << leaf->values[i] << " ";
+  while (leaf != NULL_HANDLE) {
+    auto leafNode = getLeaf(leaf);
+    latchOf(leaf).lock();
+    for (size_t i = 0; i < leafNode->keys.size(); ++i) {
+      std::cout << leafNode->keys[i] << ":" << leafNode->values[i] << " ";
       if (count % 10 == 9) {
         std::cout << "\n" << "                   ";
       }
       ++count;
     }
-    leaf = leaf->next;
+    latchOf(leaf).unlock();
+    leaf = leafNode->next;
   }
 
   std::cout << std::endl;
 }
 
 // 打印B+树
-template <typename keyType, typename valueType>
-inline void BplusTree<keyType, valueType>::printBplusTree(
-    std::shared_ptr<Node<keyType, valueType>> node, const int level) {
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::printBplusTree(
+    NodeHandle node, const int level) {
 
-  // 加上共享锁
-  std::shared_lock<std::shared_mutex> read_lock(rw_mutex);
+  // 阻止结构修改
+  auto read_lock = readGuard();
+  std::lock_guard<std::mutex> smo_lock(smoMutex);
+  loadAll();
 
   // 判断树是否为空
-  if (!root) {
+  if (root == NULL_HANDLE) {
     std::cout << "Tree is empty." << std::endl;
     return;
   }
 
+  printSubtree(node, level);
+}
+
+// 打印子树
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::printSubtree(
+    NodeHandle node, const int level) {
+
   for (int i = 0; i < level; ++i) {
     std::cout << "-";
   }
 
+  // 叶子内容在写锁内读取
+  bool isLeaf = getNode(node)->isLeafNode();
+  if (isLeaf) {
+    latchOf(node).lock();
+  }
+
   // 先打印当前节点的key
+  auto currentNode = getNode(node);
   std::cout << "Node[keys:";
-  for (size_t i = 0; i < node->keys.size(); ++i) {
-    std::cout << node->keys[i] << " ";
+  for (size_t i = 0; i < currentNode->keys.size(); ++i) {
+    std::cout << currentNode->keys[i] << " ";
   }
   std::cout << "]\n";
 
   // 再根据当前节点类型输出
-  if (!node->isLeafNode()) { // 内部节点，循环调用
-    auto interNode =
-        std::dynamic_pointer_cast<InterNode<keyType, valueType>>(node);
-    for (auto &child : interNode->children) {
-      printBplusTree(child, level + 1);
+  if (!currentNode->isLeafNode()) { // 内部节点，循环调用
+    auto interNode = getInter(node);
+    for (auto child : interNode->children) {
+      printSubtree(child, level + 1);
     }
   } else { // 叶子结点
-    auto leafNode =
-        std::dynamic_pointer_cast<LeafNode<keyType, valueType>>(node);
+    auto leafNode = getLeaf(node);
     for (size_t i = 0; i < leafNode->keys.size(); ++i) {
       std::cout << " " << leafNode->keys[i] << ":" << leafNode->values[i]
                 << "\n";
     }
+    latchOf(node).unlock();
   }
 }
 
 // 获取树高
-template <typename keyType, typename valueType>
-inline int BplusTree<keyType, valueType>::getTreeHeight(
-    std::shared_ptr<Node<keyType, valueType>> node) {
+template <typename keyType, typename valueType, size_t fanout>
+inline int
+BplusTree<keyType, valueType, fanout>::getTreeHeight(NodeHandle node) {
+
+  // 阻止结构修改
+  auto read_lock = readGuard();
+  std::lock_guard<std::mutex> smo_lock(smoMutex);
+  loadAll();
+
+  return subtreeHeight(node);
+}
 
-  // 加上共享锁
-  std::shared_lock<std::shared_mutex> read_lock(rw_mutex);
+// 子树高度
+template <typename keyType, typename valueType, size_t fanout>
+inline int
+BplusTree<keyType, valueType, fanout>::subtreeHeight(NodeHandle node) const {
 
-  if (!node) {
+  if (node == NULL_HANDLE) {
     return 0;
   }
-  if (node->isLeafNode()) {
+  if (getNode(node)->isLeafNode()) {
     return 1;
   }
-  auto interNode =
-      std::dynamic_pointer_cast<InterNode<keyType, valueType>>(node);
+  auto interNode = getInter(node);
   int maxHeight = 0;
-  for (auto &child : interNode->children) {
-    maxHeight = std::max(maxHeight, getTreeHeight(child));
+  for (auto child : interNode->children) {
+    maxHeight = std::max(maxHeight, subtreeHeight(child));
   }
   return maxHeight + 1;
 }
 
 // 统计节点数量
-template <typename keyType, typename valueType>
-inline size_t BplusTree<keyType, valueType>::countNode() {
+template <typename keyType, typename valueType, size_t fanout>
+inline size_t BplusTree<keyType, valueType, fanout>::countNode() {
 
-  // 加上共享锁
-  std::shared_lock<std::shared_mutex> read_lock(rw_mutex);
+  // 阻止结构修改
+  auto read_lock = readGuard();
+  std::lock_guard<std::mutex> smo_lock(smoMutex);
+  loadAll();
 
   // 如果树为空，返回0
-  if (!root) {
-    std::cout << "Tree is empty." << std::endl;
+  if (root == NULL_HANDLE) {
+    BPLUSTREE_LOG(LogLevel::Debug, "tree.empty", {"op", "countNode"});
     return 0;
   }
   // 调用递归辅助函数
   return countNodeHelper(root);
 }
 
+// 节点分配统计(分配和释放都在smoMutex内进行)
+template <typename keyType, typename valueType, size_t fanout>
+inline typename BplusTree<keyType, valueType, fanout>::NodeAllocStats
+BplusTree<keyType, valueType, fanout>::allocStats() {
+  std::lock_guard<std::mutex> smo_lock(smoMutex);
+  return {arena.hits(),      arena.misses(),    arena.releases(),
+          arena.liveSlots(), arena.freeSlots(), retiredNodes.size()};
+}
+
 // 统计辅助函数
-template <typename keyType, typename valueType>
-inline size_t BplusTree<keyType, valueType>::countNodeHelper(
-    const std::shared_ptr<Node<keyType, valueType>> &node) {
+template <typename keyType, typename valueType, size_t fanout>
+inline size_t
+BplusTree<keyType, valueType, fanout>::countNodeHelper(NodeHandle node) {
 
-  if (!node) {
+  if (node == NULL_HANDLE) {
     return 0;
   }
 
@@ -1492,11 +3875,10 @@ inline size_t BplusTree<keyType, valueType>::countNodeHelper(
   size_t count = 1;
 
   // 如果是内部节点，递归统计子节点
-  if (!node->isLeafNode()) {
+  if (!getNode(node)->isLeafNode()) {
 
-    auto interNode =
-        std::dynamic_pointer_cast<InterNode<keyType, valueType>>(node);
-    for (const auto &child : interNode->children) {
+    auto interNode = getInter(node);
+    for (auto child : interNode->children) {
       count += countNodeHelper(child);
     }
   }
@@ -1504,75 +3886,468 @@ inline size_t BplusTree<keyType, valueType>::countNodeHelper(
   return count;
 }
 
-template <typename keyType, typename valueType>
-inline void
-BplusTree<keyType, valueType>::serialize(const std::string &filename) {
+// 写日志的修改接口：未开启日志时直接修改
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::insert(
+    const keyType &key, const valueType &value) {
+  if (!wal) {
+    applyInsert(key, value);
+    return;
+  }
+  uint64_t lsn;
+  {
+    std::lock_guard<std::mutex> wal_lock(walMutex);
+    applyInsert(key, value);
+    lsn = logRecord(WalOp::Insert, key, value);
+  }
+  wal->commit(lsn);
+}
 
-  // 加上共享锁
-  std::shared_lock<std::shared_mutex> read_lock(rw_mutex);
+template <typename keyType, typename valueType, size_t fanout>
+inline bool BplusTree<keyType, valueType, fanout>::remove(const keyType &key) {
+  if (!wal) {
+    return applyRemove(key);
+  }
+  uint64_t lsn;
+  {
+    std::lock_guard<std::mutex> wal_lock(walMutex);
+    // 没有删除任何key时不写日志
+    if (!applyRemove(key)) {
+      return false;
+    }
+    lsn = logRecord(WalOp::Remove, key, valueType{});
+  }
+  wal->commit(lsn);
+  return true;
+}
+
+template <typename keyType, typename valueType, size_t fanout>
+inline bool BplusTree<keyType, valueType, fanout>::modify(
+    const keyType &key, const valueType &newValue) {
+  if (!wal) {
+    return applyModify(key, newValue);
+  }
+  uint64_t lsn;
+  {
+    std::lock_guard<std::mutex> wal_lock(walMutex);
+    if (!applyModify(key, newValue)) {
+      return false;
+    }
+    lsn = logRecord(WalOp::Modify, key, newValue);
+  }
+  wal->commit(lsn);
+  return true;
+}
+
+template <typename keyType, typename valueType, size_t fanout>
+template <typename Iterator>
+inline void BplusTree<keyType, valueType, fanout>::bulkLoad(Iterator begin,
+                                                            Iterator end,
+                                                            double fillFactor) {
+  if (!wal) {
+    applyBulkLoad(begin, end, fillFactor);
+    return;
+  }
+
+  // 记为清空后逐个插入，整批在同一次提交中落盘
+  uint64_t lsn;
+  {
+    std::lock_guard<std::mutex> wal_lock(walMutex);
+    applyBulkLoad(begin, end, fillFactor);
+    lsn = logRecord(WalOp::Clear, keyType{}, valueType{});
+    for (Iterator it = begin; it != end; ++it) {
+      lsn = logRecord(WalOp::Insert, it->first, it->second);
+    }
+  }
+  wal->commit(lsn);
+}
+
+// 编码并追加一条日志记录
+template <typename keyType, typename valueType, size_t fanout>
+inline uint64_t BplusTree<keyType, valueType, fanout>::logRecord(
+    WalOp op, const keyType &key, const valueType &value) {
+  // std::string的key编码为 [u32长度][字节]
+  char fixed[sizeof(uint64_t) + 1 + sizeof(keyType) + sizeof(valueType)];
+  std::vector<char> variable;
+  char *record = fixed;
+  if constexpr (slottedKeys) {
+    variable.resize(sizeof(uint64_t) + 1 + sizeof(uint32_t) + key.size() +
+                    sizeof(valueType));
+    record = variable.data();
+  }
+  uint64_t sequence = ++walSequence;
+  std::memcpy(record, &sequence, sizeof(uint64_t));
+  record[sizeof(uint64_t)] = static_cast<char>(op);
+  size_t length = sizeof(uint64_t) + 1;
+  if (op != WalOp::Clear) {
+    if constexpr (slottedKeys) {
+      auto keyLength = static_cast<uint32_t>(key.size());
+      std::memcpy(record + length, &keyLength, sizeof(uint32_t));
+      std::memcpy(record + length + sizeof(uint32_t), key.data(), keyLength);
+      length += sizeof(uint32_t) + keyLength;
+    } else {
+      std::memcpy(record + length, &key, sizeof(keyType));
+      length += sizeof(keyType);
+    }
+  }
+  if (op == WalOp::Insert || op == WalOp::Modify) {
+    std::memcpy(record + length, &value, sizeof(valueType));
+    length += sizeof(valueType);
+  }
+  return wal->append(record, length);
+}
+
+// 解码并重放一条日志记录
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::replayRecord(
+    const char *payload, size_t length) {
+  const size_t head = sizeof(uint64_t) + 1;
+  if (length < head) {
+    throw std::runtime_error("Corrupted log record");
+  }
+  uint64_t sequence;
+  std::memcpy(&sequence, payload, sizeof(uint64_t));
+  auto op = static_cast<WalOp>(payload[sizeof(uint64_t)]);
+  size_t keyBytes = 0;
+  if (op != WalOp::Clear) {
+    if constexpr (slottedKeys) {
+      uint32_t keyLength = 0;
+      if (length >= head + sizeof(uint32_t)) {
+        std::memcpy(&keyLength, payload + head, sizeof(uint32_t));
+      }
+      keyBytes = sizeof(uint32_t) + keyLength;
+    } else {
+      keyBytes = sizeof(keyType);
+    }
+  }
+  size_t expected = head + keyBytes;
+  if (op == WalOp::Insert || op == WalOp::Modify) {
+    expected += sizeof(valueType);
+  }
+  if (length != expected || op < WalOp::Insert || op > WalOp::Clear) {
+    throw std::runtime_error("Corrupted log record " +
+                             std::to_string(sequence));
+  }
 
-  std::cout << "Starting serialization to: " << filename << std::endl;
-  std::ofstream outFile(filename, std::ios::binary);
-  if (!outFile.is_open()) {
-    throw std::runtime_error("Failed to open file for writing: " + filename);
+  // 已包含在加载的文件中
+  if (sequence <= walSequence) {
+    return;
+  }
+  walSequence = sequence;
+
+  keyType key{};
+  valueType value{};
+  if (op != WalOp::Clear) {
+    if constexpr (slottedKeys) {
+      key.assign(payload + head + sizeof(uint32_t),
+                 keyBytes - sizeof(uint32_t));
+    } else {
+      std::memcpy(&key, payload + head, sizeof(keyType));
+    }
+  }
+  if (op == WalOp::Insert || op == WalOp::Modify) {
+    std::memcpy(&value, payload + head + keyBytes, sizeof(valueType));
   }
+  switch (op) {
+  case WalOp::Insert:
+    applyInsert(key, value);
+    break;
+  case WalOp::Remove:
+    applyRemove(key);
+    break;
+  case WalOp::Modify:
+    applyModify(key, value);
+    break;
+  case WalOp::Clear: {
+    auto write_lock = writeGuard();
+    SmoGuard smo(*this);
+    discardTree();
+    break;
+  }
+  }
+}
 
-  MetaData metaData = {maxKeys, minKeys, 0, getTreeHeight(root)};
-  std::cout << "Writing metadata: maxKeys=" << metaData.maxKeys
-            << ", minKeys=" << metaData.minKeys
-            << ", initial rootOffset=0, height=" << metaData.treeHeight
-            << std::endl;
-  outFile.write(reinterpret_cast<const char *>(&metaData), sizeof(MetaData));
+// 打开日志并恢复
+template <typename keyType, typename valueType, size_t fanout>
+inline size_t
+BplusTree<keyType, valueType, fanout>::openWal(const std::string &path) {
+  static_assert(pagedStorage, "the write-ahead log requires trivially "
+                              "copyable (or std::string) keys and trivially "
+                              "copyable values");
+
+  std::lock_guard<std::mutex> wal_lock(walMutex);
+  if (wal) {
+    throw std::runtime_error("Write-ahead log is already open");
+  }
+  auto log = std::make_unique<WriteAheadLog>(path);
+  uint64_t before = walSequence;
+  log->replay([this](const char *payload, size_t length) {
+    replayRecord(payload, length);
+  });
+  wal = std::move(log);
+  return static_cast<size_t>(walSequence - before);
+}
 
-  std::unordered_map<std::shared_ptr<Node<keyType, valueType>>, uint64_t>
-      nodeOffsetMap;
-  uint64_t currentOffset = sizeof(MetaData);
-  std::cout << "Initial offset after metadata: " << currentOffset << std::endl;
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::closeWal() {
+  std::lock_guard<std::mutex> wal_lock(walMutex);
+  wal.reset();
+}
 
-  saveNodeToFile(root, outFile, nodeOffsetMap, currentOffset);
+// 组装文件头(序号和校验和由writeHeader填写)
+template <typename keyType, typename valueType, size_t fanout>
+inline typename BplusTree<keyType, valueType, fanout>::MetaData
+BplusTree<keyType, valueType, fanout>::makeHeader(PageId rootPage,
+                                                  PageId pageCount) {
+  MetaData metaData;
+  std::memset(&metaData, 0, sizeof(MetaData));
+  metaData.magic = FILE_MAGIC;
+  metaData.version = FILE_VERSION;
+  metaData.pageSize = static_cast<uint32_t>(nodePageSize(maxKeys, maxKeyBytes));
+  metaData.maxKeys = maxKeys;
+  metaData.minKeys = minKeys;
+  metaData.keySize = static_cast<uint32_t>(maxKeyBytes);
+  metaData.valueSize = sizeof(valueType);
+  metaData.leafFormat = packedLeaves ? 1 : 0;
+  metaData.rootPage = rootPage;
+  // 树是平衡的，沿最左路径即可得到高度
+  int height = 0;
+  NodeHandle node = root;
+  while (node != NULL_HANDLE) {
+    ++height;
+    ensureLoaded(node);
+    node = getNode(node)->isLeafNode() ? NULL_HANDLE
+                                       : getInter(node)->children.front();
+  }
+  metaData.treeHeight = height;
+  metaData.pageCount = pageCount;
+  metaData.walSequence = walSequence;
+  return metaData;
+}
 
-  outFile.seekp(0);
-  metaData.rootOffset = root ? nodeOffsetMap[root] : 0;
-  std::cout << "Updating metadata with rootOffset: " << metaData.rootOffset
-            << std::endl;
-  outFile.write(reinterpret_cast<const char *>(&metaData), sizeof(MetaData));
+// 把序号为sequence的文件头写入它的槽位(sequence % HEADER_PAGES)
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::writeHeader(
+    BufferPool &pool, MetaData &metaData, uint64_t sequence) {
+  metaData.checkpoint = sequence;
+  metaData.checksum = 0;
+  metaData.checksum = crc32(&metaData, sizeof(MetaData));
+  PageGuard header(pool, static_cast<PageId>(sequence % HEADER_PAGES),
+                   PageGuard::Create{});
+  std::memcpy(header.data(), &metaData, sizeof(MetaData));
+}
 
-  outFile.close();
-  std::cout << "Serialization completed, final offset: " << currentOffset
-            << std::endl;
+// 读取一个文件头槽位，校验失败(未写过或写了一半)时返回false
+template <typename keyType, typename valueType, size_t fanout>
+inline bool BplusTree<keyType, valueType, fanout>::readHeader(
+    BufferPool &pool, PageId slot, MetaData &metaData) {
+  {
+    PageGuard header(pool, slot);
+    std::memcpy(&metaData, header.data(), sizeof(MetaData));
+  }
+  uint32_t checksum = metaData.checksum;
+  metaData.checksum = 0;
+  bool valid = metaData.magic == FILE_MAGIC &&
+               metaData.version == FILE_VERSION &&
+               crc32(&metaData, sizeof(MetaData)) == checksum &&
+               metaData.checkpoint % HEADER_PAGES == slot;
+  metaData.checksum = checksum;
+  return valid;
+}
 
-  if (!outFile.good()) {
-    throw std::runtime_error("Failed to write to file: " + filename);
+// 检查点分配新页：优先复用已提交检查点不再引用的页
+template <typename keyType, typename valueType, size_t fanout>
+inline PageId
+BplusTree<keyType, valueType, fanout>::allocatePage(PageFile &file) {
+  if (freePages.empty()) {
+    return file.allocate();
   }
+  PageId page = freePages.back();
+  freePages.pop_back();
+  return page;
 }
 
-// 反序列化主函数
-template <typename keyType, typename valueType>
-inline void
-BplusTree<keyType, valueType>::deserialize(const std::string &filename) {
+// 增量写出子树，返回节点所在页：节点内容被修改过、或有子节点换了页时
+// 重写(先清除标记再复制，之后的修改重新标记，留给下一次检查点)，
+// 否则沿用原来的页；只访问内存中的节点，干净的节点不产生I/O
+template <typename keyType, typename valueType, size_t fanout>
+inline PageId BplusTree<keyType, valueType, fanout>::checkpointNode(
+    NodeHandle node, PageFile &file, BufferPool &pool, size_t &written) {
+  auto currentNode = getNode(node);
+  // 未读入的占位节点与文件中的页一致
+  if (!currentNode->loaded.load(std::memory_order_relaxed)) {
+    return currentNode->page;
+  }
+  bool rewrite = currentNode->dirty.exchange(false);
+
+  std::vector<PageId> childPages;
+  if (!currentNode->isLeafNode()) {
+    auto interNode = getInter(node);
+    childPages.reserve(interNode->children.size());
+    for (NodeHandle child : interNode->children) {
+      PageId before = getNode(child)->page;
+      childPages.push_back(checkpointNode(child, file, pool, written));
+      rewrite = rewrite || childPages.back() != before;
+    }
+  }
+  if (!rewrite) {
+    return currentNode->page;
+  }
+
+  // 写时复制：不覆盖已提交的页，旧页在本次检查点提交后才能复用
+  if (currentNode->page != NULL_PAGE) {
+    stalePages.push_back(currentNode->page);
+  }
+  PageId page = allocatePage(file);
+  currentNode->page = page;
+  PageGuard guard(pool, page, PageGuard::Create{});
+  writeNodePage(guard.data(), node, childPages.data());
+  ++written;
+  return page;
+}
+
+// 完整写出整棵树(调用方持有walMutex、读锁和smoMutex)
+template <typename keyType, typename valueType, size_t fanout>
+inline size_t BplusTree<keyType, valueType, fanout>::serializeLocked(
+    const std::string &filename) {
+  // 写入期间失败时节点的page不对应任何已提交的文件，下次只能完整写出
+  loadAll();
+  storageFile.clear();
+
+  // 先写临时文件，刷盘后改名替换，崩溃时原文件保持完整
+  BPLUSTREE_LOG(LogLevel::Info, "serialize.begin", {"file", filename});
+  std::string tmpName = filename + ".tmp";
+  PageFile file(tmpName, nodePageSize(maxKeys, maxKeyBytes), true);
+  BufferPool pool(file, POOL_PAGES);
+
+  // 开头的页留给文件头，节点页全部落盘后最后写入
+  for (PageId i = 0; i < HEADER_PAGES; ++i) {
+    PageGuard header(pool, file.allocate(), PageGuard::Create{});
+  }
+  PageId rootPage =
+      root != NULL_HANDLE ? saveNodeToFile(root, file, pool) : NULL_PAGE;
+  pool.flushAll();
+  file.sync();
+
+  MetaData metaData = makeHeader(rootPage, file.pageCount());
+  writeHeader(pool, metaData, 1);
+  pool.flushAll();
+  file.sync();
+  if (std::rename(tmpName.c_str(), filename.c_str()) != 0) {
+    throw std::runtime_error("Failed to replace file: " + filename);
+  }
+  // 改名落盘后才能清空日志：否则崩溃后可能只剩旧文件和已清空的日志
+  syncParentDirectory(filename);
+
+  storageFile = filename;
+  checkpointSequence = 1;
+  freePages.clear();
+  stalePages.clear();
+
+  // 日志中的修改都已包含在文件中(清空前崩溃时按序号跳过)
+  if (wal) {
+    wal->reset();
+  }
 
-  // 加上独占锁
-  std::unique_lock<std::shared_mutex> write_lock(rw_mutex);
+  BPLUSTREE_LOG(LogLevel::Info, "serialize.end",
+                {"pages", metaData.pageCount - HEADER_PAGES});
+  return metaData.pageCount - HEADER_PAGES;
+}
+
+template <typename keyType, typename valueType, size_t fanout>
+inline void
+BplusTree<keyType, valueType, fanout>::serialize(const std::string &filename) {
+  static_assert(pagedStorage, "paged storage requires trivially copyable "
+                              "(or std::string) keys and trivially "
+                              "copyable values");
+
+  // 开启日志时阻止写操作(文件与日志序号一致)；
+  // 阻止结构修改，叶子内容在叶子写锁内复制
+  std::lock_guard<std::mutex> wal_lock(walMutex);
+  auto read_lock = readGuard();
+  std::lock_guard<std::mutex> smo_lock(smoMutex);
+  serializeLocked(filename);
+}
 
-  std::cout << "Starting deserialization from: " << filename << std::endl;
-  std::ifstream inFile(filename, std::ios::binary);
-  if (!inFile.is_open()) {
-    throw std::runtime_error("Failed to open file for reading: " + filename);
+// 增量检查点
+template <typename keyType, typename valueType, size_t fanout>
+inline size_t
+BplusTree<keyType, valueType, fanout>::checkpoint(const std::string &filename) {
+  static_assert(pagedStorage, "paged storage requires trivially copyable "
+                              "(or std::string) keys and trivially "
+                              "copyable values");
+
+  // 加锁同serialize
+  std::lock_guard<std::mutex> wal_lock(walMutex);
+  auto read_lock = readGuard();
+  std::lock_guard<std::mutex> smo_lock(smoMutex);
+
+  // 节点的page只对storageFile有效，其他文件只能完整写出
+  if (filename != storageFile) {
+    return serializeLocked(filename);
   }
+  storageFile.clear();
+
+  PageFile file(filename, nodePageSize(maxKeys, maxKeyBytes), false);
+  BufferPool pool(file, POOL_PAGES);
+  size_t written = 0;
+  PageId rootPage = root != NULL_HANDLE
+                        ? checkpointNode(root, file, pool, written)
+                        : NULL_PAGE;
+  pool.flushAll();
+  file.sync();
+
+  // 新文件头写入另一个槽位：写完之前崩溃时加载的仍是上一个检查点
+  MetaData metaData = makeHeader(rootPage, file.pageCount());
+  writeHeader(pool, metaData, checkpointSequence + 1);
+  pool.flushAll();
+  file.sync();
+
+  // 提交完成，被替换的页可以复用
+  ++checkpointSequence;
+  freePages.insert(freePages.end(), stalePages.begin(), stalePages.end());
+  stalePages.clear();
+  storageFile = filename;
+
+  if (wal) {
+    wal->reset();
+  }
+  BPLUSTREE_LOG(LogLevel::Info, "checkpoint.end",
+                {"sequence", checkpointSequence}, {"pages", written});
+  return written;
+}
 
+// 取校验通过且序号最大的文件头(另一个可能是写了一半的新检查点)
+template <typename keyType, typename valueType, size_t fanout>
+inline typename BplusTree<keyType, valueType, fanout>::MetaData
+BplusTree<keyType, valueType, fanout>::readMetaData(
+    BufferPool &pool, const PageFile &file, const std::string &filename) {
+  if (file.pageCount() < HEADER_PAGES) {
+    throw std::runtime_error("Not a B+ tree page file: " + filename);
+  }
   MetaData metaData;
-  inFile.read(reinterpret_cast<char *>(&metaData), sizeof(MetaData));
-  std::cout << "Read metadata: maxKeys=" << metaData.maxKeys
-            << ", minKeys=" << metaData.minKeys
-            << ", rootOffset=" << metaData.rootOffset
-            << ", height=" << metaData.treeHeight << std::endl;
-  if (!inFile.good()) {
-    inFile.close();
-    throw std::runtime_error("Failed to read metadata from file: " + filename);
-  }
-
-  if (metaData.maxKeys != maxKeys || metaData.minKeys != minKeys) {
-    inFile.close();
+  bool found = false;
+  for (PageId slot = 0; slot < HEADER_PAGES; ++slot) {
+    MetaData candidate;
+    if (readHeader(pool, slot, candidate) &&
+        (!found || candidate.checkpoint > metaData.checkpoint)) {
+      metaData = candidate;
+      found = true;
+    }
+  }
+  if (!found || metaData.pageSize != file.pageSize() ||
+      metaData.pageCount > file.pageCount()) {
+    throw std::runtime_error("Not a B+ tree page file: " + filename);
+  }
+  BPLUSTREE_LOG(LogLevel::Debug, "file.header", {"file", filename},
+                {"maxKeys", metaData.maxKeys}, {"minKeys", metaData.minKeys},
+                {"rootPage", metaData.rootPage},
+                {"height", metaData.treeHeight},
+                {"checkpoint", metaData.checkpoint});
+  if (metaData.maxKeys != maxKeys || metaData.minKeys != minKeys ||
+      metaData.keySize != maxKeyBytes ||
+      metaData.valueSize != sizeof(valueType) ||
+      metaData.leafFormat != (packedLeaves ? 1u : 0u)) {
     throw std::runtime_error(
         "Incompatible B+ tree parameters: file (maxKeys=" +
         std::to_string(metaData.maxKeys) +
@@ -1580,59 +4355,831 @@ BplusTree<keyType, valueType>::deserialize(const std::string &filename) {
         ") vs constructor (maxKeys=" + std::to_string(maxKeys) +
         ", minKeys=" + std::to_string(minKeys) + ")");
   }
+  return metaData;
+}
+
+// 反序列化主函数
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::deserialize(
+    const std::string &filename) {
+  static_assert(pagedStorage, "paged storage requires trivially copyable "
+                              "(or std::string) keys and trivially "
+                              "copyable values");
+
+  // 日志记录的是相对当前树的修改，加载其他文件前必须先关闭日志
+  std::lock_guard<std::mutex> wal_lock(walMutex);
+  if (wal) {
+    throw std::runtime_error("Close the write-ahead log before deserialize");
+  }
+  stopWarmer();
+
+  // 不能乐观读取的类型加上独占锁，并串行化结构修改
+  auto write_lock = writeGuard();
+  SmoGuard smo(*this);
+
+  BPLUSTREE_LOG(LogLevel::Info, "deserialize.begin", {"file", filename});
+  PageFile file(filename, nodePageSize(maxKeys, maxKeyBytes), false);
+  BufferPool pool(file, POOL_PAGES);
+  MetaData metaData = readMetaData(pool, file, filename);
+
+  // 新树在旁边加载，文件损坏时抛出，旧树保持不变
+  NodeHandle newRoot = NULL_HANDLE;
+  std::vector<bool> usedPages(file.pageCount(), false);
+  if (metaData.rootPage != NULL_PAGE) {
+    newRoot =
+        loadNodeFromFile(pool, metaData.rootPage, 1, metaData, usedPages);
+  }
 
-  root = nullptr;
+  // 按层连接右链接(叶子层即叶链表)并恢复各节点上界
+  rebuildLinks(newRoot);
 
-  std::unordered_map<uint64_t, std::shared_ptr<Node<keyType, valueType>>>
-      offsetNodeMap;
+  // 旧树的节点逐个废弃，并发读者校验失败后会从新根重新下降
+  discardTree();
+  storageFile.clear();
 
-  if (metaData.rootOffset != 0) {
-    std::cout << "Loading root node from offset: " << metaData.rootOffset
-              << std::endl;
-    loadNodeFromFile(inFile, metaData.rootOffset, offsetNodeMap);
-    if (offsetNodeMap.find(metaData.rootOffset) == offsetNodeMap.end()) {
-      throw std::runtime_error("Root node not found at offset " +
-                               std::to_string(metaData.rootOffset));
+  // 链接建好后再发布新根
+  root = newRoot;
+  walSequence = metaData.walSequence;
+  if (learnedEnabled) {
+    rebuildLearned();
+  }
+
+  // 之后的检查点写回该文件：不被当前文件头引用的页都可以复用
+  storageFile = filename;
+  checkpointSequence = metaData.checkpoint;
+  stalePages.clear();
+  freePages.clear();
+  for (PageId page = file.pageCount(); page-- > HEADER_PAGES;) {
+    if (!usedPages[page]) {
+      freePages.push_back(page);
+    }
+  }
+
+  BPLUSTREE_LOG(LogLevel::Info, "deserialize.end", {"pages", pool.misses()});
+}
+
+// 懒加载打开
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::deserializeLazy(
+    const std::string &filename, bool warmInBackground) {
+  static_assert(pagedStorage, "paged storage requires trivially copyable "
+                              "(or std::string) keys and trivially "
+                              "copyable values");
+
+  // 加锁同deserialize
+  std::lock_guard<std::mutex> wal_lock(walMutex);
+  if (wal) {
+    throw std::runtime_error("Close the write-ahead log before deserialize");
+  }
+  stopWarmer();
+  auto write_lock = writeGuard();
+  SmoGuard smo(*this);
+
+  auto source = std::make_unique<LazySource>(
+      filename, nodePageSize(maxKeys, maxKeyBytes));
+  MetaData metaData = readMetaData(source->pool, source->file, filename);
+  if (metaData.rootPage != NULL_PAGE &&
+      (metaData.rootPage < HEADER_PAGES ||
+       metaData.rootPage >= metaData.pageCount)) {
+    throw std::runtime_error("Corrupted node reference to page " +
+                             std::to_string(metaData.rootPage));
+  }
+
+  // 只读入根节点，子节点都是占位节点；根节点在旁边读入(loadStub从lazy
+  // 读取，期间暂存旧树的数据源)，读入失败时旧树保持不变
+  NodeHandle newRoot = NULL_HANDLE;
+  if (metaData.rootPage != NULL_PAGE) {
+    source->pageCount = source->file.pageCount();
+    source->usedPages.assign(source->pageCount, false);
+    source->usedPages[metaData.rootPage] = true;
+    std::swap(lazy, source);
+    try {
+      newRoot = makeStub(metaData.rootPage, NULL_HANDLE);
+      loadStub(newRoot);
+    } catch (...) {
+      if (newRoot != NULL_HANDLE) {
+        releaseUnpublished(newRoot);
+      }
+      std::swap(lazy, source);
+      throw;
+    }
+    std::swap(lazy, source);
+  }
+
+  discardTree();
+  storageFile.clear();
+  if (newRoot != NULL_HANDLE) {
+    lazy = std::move(source);
+    lazyPending = true;
+    learned.disable();
+  }
+  root = newRoot;
+  walSequence = metaData.walSequence;
+
+  // 未被引用的页要在全部读入后才知道，此前检查点只追加新页
+  storageFile = filename;
+  checkpointSequence = metaData.checkpoint;
+  stalePages.clear();
+  freePages.clear();
+
+  if (lazy && warmInBackground) {
+    warmer = std::thread([this] {
+      while (!stopWarming.load() && warmStep(WARM_BATCH)) {
+      }
+    });
+  }
+}
+
+// 建立占位节点
+template <typename keyType, typename valueType, size_t fanout>
+inline NodeHandle BplusTree<keyType, valueType, fanout>::makeStub(
+    PageId page, NodeHandle parent) {
+  NodeHandle handle = allocLeaf();
+  auto stub = getNode(handle);
+  stub->loaded.store(false, std::memory_order_relaxed);
+  stub->dirty.store(false, std::memory_order_relaxed);
+  stub->page = page;
+  stub->parent = parent;
+  ++lazy->stubs;
+  return handle;
+}
+
+// 读入占位节点
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::loadStub(NodeHandle handle) {
+  LazySource &source = *lazy;
+  PageId page = getNode(handle)->page;
+  {
+    PageGuard guard(source.pool, page);
+    const char *bytes = guard.data();
+    NodePage header;
+    std::memcpy(&header, bytes, sizeof(NodePage));
+    size_t count = header.keyCount;
+    size_t keyBytes;
+    if (header.isLeaf > 1 ||
+        !checkNodePage(bytes, header.isLeaf, count, source.pool.pageSize(),
+                       keyBytes)) {
+      throw std::runtime_error("Corrupted node at page " +
+                               std::to_string(page));
+    }
+
+    // 先检查子节点页号，出错时节点保持原样
+    std::vector<PageId> childPages;
+    if (!header.isLeaf) {
+      childPages.resize(count + 1);
+      std::memcpy(childPages.data(), bytes + pageChildrenOffset(keyBytes),
+                  childPages.size() * sizeof(PageId));
+      for (PageId child : childPages) {
+        if (child < HEADER_PAGES || child >= source.pageCount ||
+            source.usedPages[child]) {
+          throw std::runtime_error("Corrupted node reference to page " +
+                                   std::to_string(child));
+        }
+        source.usedPages[child] = true;
+      }
+    }
+
+    // 在写锁内填入内容，读者校验失败后重新读取
+    latchOf(handle).lock();
+    if (header.isLeaf) {
+      auto leaf = getLeaf(handle);
+      loadKeys(leaf->keys, bytes, count, keyBytes);
+      loadValues(leaf, bytes, count, keyBytes);
+    } else {
+      // 占位节点按叶子构造，在原槽位上重建为内部节点，保留链接和上界
+      auto stub = getLeaf(handle);
+      NodeHandle parent = stub->parent;
+      NodeHandle next = stub->next;
+      bool hasHighKey = stub->hasHighKey;
+      keyType highKey = stub->highKey;
+      stub->~LeafNode();
+      auto inter = new (arena.get(handle))
+          InterNode<keyType, valueType>(maxKeys + 1, maxKeyBytes, layout);
+      inter->loaded.store(false, std::memory_order_relaxed);
+      inter->dirty.store(false, std::memory_order_relaxed);
+      inter->page = page;
+      inter->parent = parent;
+      inter->next = next;
+      inter->hasHighKey = hasHighKey;
+      inter->highKey = highKey;
+      loadKeys(inter->keys, bytes, count, keyBytes);
+
+      // 子节点的上界为分隔key(最后一个继承本节点的)，同一节点下依次链接
+      for (size_t i = 0; i < childPages.size(); ++i) {
+        NodeHandle child = makeStub(childPages[i], handle);
+        auto childNode = getLeaf(child);
+        if (i < count) {
+          childNode->hasHighKey = true;
+          childNode->highKey = inter->keys[i];
+        } else {
+          childNode->hasHighKey = hasHighKey;
+          childNode->highKey = highKey;
+        }
+        if (i > 0) {
+          getNode(inter->children.back())->next = child;
+          childNode->prev = inter->children.back();
+        }
+        inter->children.push_back(child);
+      }
+
+      // 与已读入的同层邻居的子节点相互链接，邻居未读入时链接留空，
+      // 等邻居读入时再由它补上
+      NodeHandle left = neighbor(handle, false, false);
+      if (left != NULL_HANDLE && getNode(left)->loaded.load()) {
+        NodeHandle leftChild = getInter(left)->children.back();
+        NodeHandle first = inter->children.front();
+        // 结构修改中途(借调/合并前读入兄弟)时该节点可能已被本线程锁住
+        bool held = std::find(smoLatched.begin(), smoLatched.end(),
+                              leftChild) != smoLatched.end();
+        if (!held) {
+          latchOf(leftChild).lock();
+        }
+        getNode(leftChild)->next = first;
+        if (!held) {
+          latchOf(leftChild).unlock();
+        }
+        getLeaf(first)->prev = leftChild;
+      }
+      NodeHandle right = neighbor(handle, true, false);
+      if (right != NULL_HANDLE && getNode(right)->loaded.load()) {
+        NodeHandle rightChild = getInter(right)->children.front();
+        NodeHandle last = inter->children.back();
+        getNode(last)->next = rightChild;
+        if (getNode(rightChild)->isLeafNode()) {
+          // 与左侧相同：在写锁内改反向链接，反向游标读到空链接时校验失败
+          bool held = std::find(smoLatched.begin(), smoLatched.end(),
+                                rightChild) != smoLatched.end();
+          if (!held) {
+            latchOf(rightChild).lock();
+          }
+          getLeaf(rightChild)->prev = last;
+          if (!held) {
+            latchOf(rightChild).unlock();
+          }
+        }
+      }
+    }
+    getNode(handle)->loaded.store(true, std::memory_order_release);
+    latchOf(handle).unlock();
+  }
+
+  // 页已解除钉住，全部读入时可以关闭数据文件
+  ++source.loads;
+  if (--source.stubs == 0) {
+    finishLazy();
+  }
+}
+
+// 同层邻居
+template <typename keyType, typename valueType, size_t fanout>
+inline NodeHandle BplusTree<keyType, valueType, fanout>::neighbor(
+    NodeHandle node, bool right, bool load) {
+  NodeHandle parent = getNode(node)->parent;
+  if (parent == NULL_HANDLE) {
+    return NULL_HANDLE;
+  }
+  const auto &children = getInter(parent)->children;
+  size_t index = static_cast<size_t>(
+      std::find(children.begin(), children.end(), node) - children.begin());
+  if (right ? index + 1 < children.size() : index > 0) {
+    return children[right ? index + 1 : index - 1];
+  }
+
+  // 本节点在父节点的边上：邻居是父节点的邻居的第一个/最后一个子节点
+  NodeHandle up = neighbor(parent, right, load);
+  if (up == NULL_HANDLE) {
+    return NULL_HANDLE;
+  }
+  if (load) {
+    ensureLoaded(up);
+  } else if (!getNode(up)->loaded.load(std::memory_order_relaxed)) {
+    return NULL_HANDLE;
+  }
+  const auto &upChildren = getInter(up)->children;
+  return right ? upChildren.front() : upChildren.back();
+}
+
+// 启用学习索引
+template <typename keyType, typename valueType, size_t fanout>
+inline void
+BplusTree<keyType, valueType, fanout>::enableLearnedIndex(size_t maxError) {
+  static_assert(learnedKeys, "the learned index requires integer keys");
+  SmoGuard smo(*this);
+  loadAll();
+  learned.configure(maxError);
+  learnedEnabled = true;
+  rebuildLearned();
+}
+
+// 停用学习索引
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::disableLearnedIndex() {
+  SmoGuard smo(*this);
+  learnedEnabled = false;
+  learned.disable();
+}
+
+// 读入全部占位节点
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::loadAll() {
+  if (!lazy) {
+    return;
+  }
+  std::vector<NodeHandle> stack = {root};
+  while (!stack.empty() && lazy) {
+    NodeHandle handle = stack.back();
+    stack.pop_back();
+    ensureLoaded(handle);
+    if (!getNode(handle)->isLeafNode()) {
+      for (NodeHandle child : getInter(handle)->children) {
+        stack.push_back(child);
+      }
+    }
+  }
+}
+
+// 全部读入
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::finishLazy() {
+  // 文件中未被引用的页从未分配给检查点，可以复用
+  for (PageId page = lazy->pageCount; page-- > HEADER_PAGES;) {
+    if (!lazy->usedPages[page]) {
+      freePages.push_back(page);
+    }
+  }
+  lazy.reset();
+  lazyPending.store(false, std::memory_order_release);
+  if (learnedEnabled) {
+    rebuildLearned();
+  }
+}
+
+// 预热一批
+template <typename keyType, typename valueType, size_t fanout>
+inline bool BplusTree<keyType, valueType, fanout>::warmStep(size_t budget) {
+  std::lock_guard<std::mutex> smo_lock(smoMutex);
+  if (!lazy) {
+    return false;
+  }
+  size_t stop = lazy->loads + budget;
+
+  // 从上一批停下的位置(第一批从最左)沿叶链表读入，
+  // 右链接为空(右侧叶子的父节点未读入)时从根按上界重新下降
+  // (读入最后一个占位节点时lazy被释放，每步之后都要检查)
+  NodeHandle leaf = root;
+  if (lazy->warmed) {
+    leaf = findLeaf(root, lazy->warmKey, Seek::Last);
+  } else {
+    ensureLoaded(leaf);
+    while (!getNode(leaf)->isLeafNode()) {
+      leaf = getInter(leaf)->children.front();
+      ensureLoaded(leaf);
+    }
+  }
+  while (lazy && lazy->loads < stop) {
+    lazy->warmed = true;
+    auto leafNode = getNode(leaf);
+    if (!leafNode->hasHighKey) {
+      // 已到最右的叶子，途经的节点覆盖了整棵树
+      loadAll();
+      break;
+    }
+    lazy->warmKey = leafNode->highKey;
+    if (leafNode->next != NULL_HANDLE) {
+      leaf = leafNode->next;
+      ensureLoaded(leaf);
+    } else {
+      leaf = findLeaf(root, lazy->warmKey, Seek::Last);
+    }
+  }
+  return lazy != nullptr;
+}
+
+// 停止预热线程
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::stopWarmer() {
+  if (warmer.joinable()) {
+    stopWarming = true;
+    warmer.join();
+    stopWarming = false;
+  }
+}
+
+// 读者进入节点
+template <typename keyType, typename valueType, size_t fanout>
+inline bool BplusTree<keyType, valueType, fanout>::readNode(
+    NodeHandle handle, uint64_t &version) const {
+  if (!latchOf(handle).readLock(version)) {
+    return false;
+  }
+  if (getNode(handle)->loaded.load(std::memory_order_acquire)) {
+    return true;
+  }
+
+  // 占位节点：加锁后确认仍是读到的那个占位节点(未被读入或释放)再读入；
+  // 读入不改变树的内容，因此允许在只读操作中进行
+  auto self = const_cast<BplusTree *>(this);
+  std::lock_guard<std::mutex> smo_lock(self->smoMutex);
+  if (self->lazy && latchOf(handle).validate(version)) {
+    self->loadStub(handle);
+  }
+  return false;
+}
+
+// 游标处理空链接
+template <typename keyType, typename valueType, size_t fanout>
+inline bool BplusTree<keyType, valueType, fanout>::resolveNeighbor(
+    NodeHandle handle, uint64_t version, bool right) const {
+  auto self = const_cast<BplusTree *>(this);
+  std::lock_guard<std::mutex> smo_lock(self->smoMutex);
+  if (!latchOf(handle).validate(version)) {
+    return true; // 节点已被修改，重新定位
+  }
+  if (!self->lazy) {
+    // 全部读入后链接完整：读到空链接之后才补上的，重新定位
+    NodeHandle link =
+        right ? getNode(handle)->next
+              : (getNode(handle)->isLeafNode() ? getLeaf(handle)->prev
+                                               : NULL_HANDLE);
+    return link != NULL_HANDLE;
+  }
+  return self->neighbor(handle, right, true) != NULL_HANDLE;
+}
+
+// 邻居读入后重新进入叶子
+template <typename keyType, typename valueType, size_t fanout>
+inline bool BplusTree<keyType, valueType, fanout>::relatchLeaf(
+    NodeHandle handle, size_t count, uint64_t &version) const {
+  uint64_t current;
+  if (!readNode(handle, current)) {
+    return false;
+  }
+  size_t now = safeSize(getLeaf(handle)->keys);
+  if (now != count || !latchOf(handle).validate(current)) {
+    return false;
+  }
+  version = current;
+  return true;
+}
+
+// 写出只读快照
+template <typename keyType, typename valueType, size_t fanout>
+inline void BplusTree<keyType, valueType, fanout>::saveSnapshot(
+    const std::string &filename) {
+  static_assert(std::is_trivially_copyable_v<keyType> &&
+                    std::is_trivially_copyable_v<valueType>,
+                "snapshots require trivially copyable keys and values");
+  static_assert(!packedLeaves, "snapshots do not support packed keys");
+
+  // 阻止结构修改，叶子内容在叶子写锁内复制
+  auto read_lock = readGuard();
+  std::lock_guard<std::mutex> smo_lock(smoMutex);
+
+  // 按层收集节点：块号按层序分配，下一层的块紧跟在本层之后
+  loadAll();
+  std::vector<std::vector<NodeHandle>> levels;
+  if (root != NULL_HANDLE) {
+    levels.push_back({root});
+    while (!getNode(levels.back().front())->isLeafNode()) {
+      std::vector<NodeHandle> below;
+      for (NodeHandle node : levels.back()) {
+        auto interNode = getInter(node);
+        below.insert(below.end(), interNode->children.begin(),
+                     interNode->children.end());
+      }
+      levels.push_back(std::move(below));
+    }
+  }
+
+  size_t blockSize = nodePageSize(maxKeys, maxKeyBytes);
+  size_t batchBlocks = std::max<size_t>(1, SNAPSHOT_BATCH_BYTES / blockSize);
+  std::vector<char> batch(batchBlocks * blockSize);
+  std::vector<PageId> childBlocks;
+  std::string tmpName = filename + ".tmp";
+  PageFile file(tmpName, blockSize, true);
+
+  SnapshotHeader header{};
+  PageId block = 1;      // 下一个写出的块
+  PageId batchStart = 1; // 批内第一个块
+  size_t batched = 0;
+  for (const auto &level : levels) {
+    // 本层节点的子节点依次占用本层之后的块
+    PageId childBlock = block + static_cast<PageId>(level.size());
+    if (getNode(level.front())->isLeafNode()) {
+      header.firstLeaf = block;
+    }
+    for (NodeHandle node : level) {
+      auto currentNode = getNode(node);
+      childBlocks.clear();
+      if (!currentNode->isLeafNode()) {
+        for (size_t i = 0; i < getInter(node)->children.size(); ++i) {
+          childBlocks.push_back(childBlock++);
+        }
+      } else {
+        header.keyCount += currentNode->keys.size();
+      }
+      char *bytes = batch.data() + batched * blockSize;
+      std::memset(bytes, 0, blockSize);
+      writeNodePage(bytes, node, childBlocks.data());
+      ++block;
+      if (++batched == batchBlocks) {
+        file.write(batchStart, batch.data(), batched);
+        batchStart = block;
+        batched = 0;
+      }
+    }
+  }
+  if (batched > 0) {
+    file.write(batchStart, batch.data(), batched);
+  }
+
+  // 快照头最后写入
+  header.magic = SNAPSHOT_MAGIC;
+  header.version = SNAPSHOT_VERSION;
+  header.blockSize = static_cast<uint32_t>(blockSize);
+  header.maxKeys = maxKeys;
+  header.keySize = sizeof(keyType);
+  header.valueSize = sizeof(valueType);
+  header.rootBlock = levels.empty() ? NULL_PAGE : 1;
+  header.blockCount = block;
+  std::memset(batch.data(), 0, blockSize);
+  std::memcpy(batch.data(), &header, sizeof(SnapshotHeader));
+  file.write(HEADER_PAGE, batch.data());
+  file.sync();
+
+  if (std::rename(tmpName.c_str(), filename.c_str()) != 0) {
+    throw std::runtime_error("Failed to publish snapshot: " + filename);
+  }
+  syncParentDirectory(filename);
+}
+
+// 打开只读快照
+template <typename keyType, typename valueType, size_t fanout>
+inline BplusTree<keyType, valueType, fanout>::Snapshot::Snapshot(
+    const std::string &filename) {
+  static_assert(!packedLeaves, "snapshots do not support packed keys");
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Failed to open snapshot: " + filename);
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(SnapshotHeader)) {
+    ::close(fd);
+    throw std::runtime_error("Not a B+ tree snapshot: " + filename);
+  }
+  length = static_cast<size_t>(st.st_size);
+  void *mapped = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+  // 映射建立后即可关闭文件
+  ::close(fd);
+  if (mapped == MAP_FAILED) {
+    throw std::runtime_error("Failed to map snapshot: " + filename);
+  }
+  base = static_cast<const char *>(mapped);
+  std::memcpy(&header, base, sizeof(SnapshotHeader));
+
+  // 叶子必须位于文件末尾，根块为1(空快照除外)
+  bool valid =
+      header.magic == SNAPSHOT_MAGIC && header.version == SNAPSHOT_VERSION &&
+      header.keySize == sizeof(keyType) &&
+      header.valueSize == sizeof(valueType) &&
+      header.blockSize >= MIN_PAGE_SIZE &&
+      (header.blockSize & (header.blockSize - 1)) == 0 &&
+      pageValuesOffset(header.maxKeys * sizeof(keyType)) +
+              header.maxKeys * sizeof(valueType) <=
+          header.blockSize &&
+      pageChildrenOffset(header.maxKeys * sizeof(keyType)) +
+              (header.maxKeys + 1) * sizeof(PageId) <=
+          header.blockSize &&
+      static_cast<uint64_t>(header.blockCount) * header.blockSize <= length &&
+      (header.rootBlock == NULL_PAGE
+           ? header.blockCount == 1
+           : header.rootBlock == 1 && header.firstLeaf >= 1 &&
+                 header.firstLeaf < header.blockCount);
+  if (!valid) {
+    ::munmap(mapped, length);
+    base = nullptr;
+    throw std::runtime_error("Not a B+ tree snapshot: " + filename);
+  }
+}
+
+template <typename keyType, typename valueType, size_t fanout>
+inline BplusTree<keyType, valueType, fanout>::Snapshot::~Snapshot() {
+  if (base != nullptr) {
+    ::munmap(const_cast<char *>(base), length);
+  }
+}
+
+// 快照中下降到第一个可能含有key的叶子(等于分隔key时走左侧子树)：
+// 子节点块号必然大于父节点块号，损坏的快照不会成环
+template <typename keyType, typename valueType, size_t fanout>
+inline PageId BplusTree<keyType, valueType, fanout>::Snapshot::findLeaf(
+    const keyType &key) const {
+  PageId current = header.rootBlock;
+  while (current != NULL_PAGE && current < header.firstLeaf) {
+    const char *bytes = block(current);
+    NodePage page;
+    std::memcpy(&page, bytes, sizeof(NodePage));
+    if (page.isLeaf != 0 || page.keyCount > header.maxKeys) {
+      throw std::runtime_error("Corrupted snapshot block " +
+                               std::to_string(current));
+    }
+    auto keys = reinterpret_cast<const keyType *>(bytes + pageKeysOffset());
+    auto children = reinterpret_cast<const PageId *>(
+        bytes + pageChildrenOffset(page.keyCount * sizeof(keyType)));
+    PageId child = children[nodeLowerBound(keys, page.keyCount, key)];
+    if (child <= current || child >= header.blockCount) {
+      throw std::runtime_error("Corrupted snapshot block " +
+                               std::to_string(current));
+    }
+    current = child;
+  }
+  return current;
+}
+
+template <typename keyType, typename valueType, size_t fanout>
+inline valueType BplusTree<keyType, valueType, fanout>::Snapshot::search(
+    const keyType &key) const {
+  PageId leaf = findLeaf(key);
+  if (leaf == NULL_PAGE) {
+    return valueType{};
+  }
+  // key等于分隔key时可能都在右侧叶子(叶子连续存放，即下一块)
+  for (; leaf < header.blockCount; ++leaf) {
+    const char *bytes = block(leaf);
+    NodePage page;
+    std::memcpy(&page, bytes, sizeof(NodePage));
+    if (page.isLeaf != 1 || page.keyCount > header.maxKeys) {
+      throw std::runtime_error("Corrupted snapshot block " +
+                               std::to_string(leaf));
+    }
+    auto keys = reinterpret_cast<const keyType *>(bytes + pageKeysOffset());
+    size_t i = nodeLowerBound(keys, page.keyCount, key);
+    if (i == page.keyCount) {
+      continue;
+    }
+    if (keys[i] == key) {
+      auto values = reinterpret_cast<const valueType *>(
+          bytes + pageValuesOffset(page.keyCount * sizeof(keyType)));
+      return values[i];
+    }
+    break;
+  }
+  return valueType{};
+}
+
+template <typename keyType, typename valueType, size_t fanout>
+inline std::vector<std::pair<keyType, valueType>>
+BplusTree<keyType, valueType, fanout>::Snapshot::rangeSearch(
+    const keyType &startKey, const keyType &endKey) const {
+  std::vector<std::pair<keyType, valueType>> result;
+  PageId leaf = findLeaf(startKey);
+  if (leaf == NULL_PAGE) {
+    return result;
+  }
+
+  // 叶子连续存放，直接按块号向后扫描
+  size_t pos = SIZE_MAX;
+  for (; leaf < header.blockCount; ++leaf) {
+    const char *bytes = block(leaf);
+    NodePage page;
+    std::memcpy(&page, bytes, sizeof(NodePage));
+    if (page.isLeaf != 1 || page.keyCount > header.maxKeys) {
+      throw std::runtime_error("Corrupted snapshot block " +
+                               std::to_string(leaf));
+    }
+    auto keys = reinterpret_cast<const keyType *>(bytes + pageKeysOffset());
+    auto values = reinterpret_cast<const valueType *>(
+        bytes + pageValuesOffset(page.keyCount * sizeof(keyType)));
+    if (pos == SIZE_MAX) {
+      pos = nodeLowerBound(keys, page.keyCount, startKey);
     }
-    root = offsetNodeMap[metaData.rootOffset];
-    std::cout << "Root node loaded, keys: ";
-    for (const auto &key : root->keys)
-      std::cout << key << " ";
-    std::cout << std::endl;
+    for (; pos < page.keyCount; ++pos) {
+      if (endKey < keys[pos]) {
+        return result;
+      }
+      result.emplace_back(keys[pos], values[pos]);
+    }
+    pos = 0;
   }
+  return result;
+}
 
-  // 提取并排序叶子节点
-  std::vector<std::shared_ptr<Node<keyType, valueType>>> leafNodes;
-  for (const auto &pair : offsetNodeMap) {
-    if (pair.second->isLeafNode()) {
-      leafNodes.push_back(pair.second);
+// 冻结
+template <typename keyType, typename valueType, size_t fanout>
+inline typename BplusTree<keyType, valueType, fanout>::Frozen
+BplusTree<keyType, valueType, fanout>::freeze() {
+
+  // 阻止结构修改，叶子内容在叶子写锁内复制
+  auto read_lock = readGuard();
+  std::lock_guard<std::mutex> smo_lock(smoMutex);
+  loadAll();
+
+  Frozen frozen;
+  if (root == NULL_HANDLE) {
+    return frozen;
+  }
+  NodeHandle leaf = root;
+  while (!getNode(leaf)->isLeafNode()) {
+    leaf = getInter(leaf)->children.front();
+  }
+  for (; leaf != NULL_HANDLE; leaf = getLeaf(leaf)->next) {
+    auto leafNode = getLeaf(leaf);
+    latchOf(leaf).lock();
+    size_t count = leafNode->keys.size();
+    size_t first = frozen.keys.size();
+    frozen.keys.resize(first + count);
+    frozen.values.resize(first + count);
+    if constexpr (packedLeaves) {
+      leafNode->keys.decode(0, count, frozen.keys.data() + first);
+      leafNode->values.decode(0, count, frozen.values.data() + first);
+    } else {
+      for (size_t i = 0; i < count; ++i) {
+        frozen.keys[first + i] = leafNode->keys[i];
+        frozen.values[first + i] = leafNode->values[i];
+      }
     }
+    latchOf(leaf).unlock();
   }
-  std::sort(leafNodes.begin(), leafNodes.end(),
-            [&offsetNodeMap](const auto &a, const auto &b) {
-              return a->keys[0] < b->keys[0];
-            });
+  // 只读之后不再增长，去掉扩容留下的空余容量
+  frozen.keys.shrink_to_fit();
+  frozen.values.shrink_to_fit();
+
+  size_t blocks = (frozen.keys.size() + Frozen::BLOCK - 1) / Frozen::BLOCK;
+  frozen.index.resize(blocks + 1);
+  frozen.blockOf.resize(blocks + 1);
+  frozen.fillIndex(1, 0);
+  BPLUSTREE_LOG(LogLevel::Debug, "tree.freeze", {"keys", frozen.keys.size()},
+                {"blocks", blocks});
+  return frozen;
+}
 
-  std::cout << "LeafNodes size is:" << leafNodes.size() << std::endl;
+template <typename keyType, typename valueType, size_t fanout>
+inline size_t
+BplusTree<keyType, valueType, fanout>::Frozen::fillIndex(size_t k, size_t i) {
+  if (k < index.size()) {
+    i = fillIndex(2 * k, i);
+    index[k] = keys[i * BLOCK];
+    blockOf[k] = i++;
+    i = fillIndex(2 * k + 1, i);
+  }
+  return i;
+}
 
-  // 连接叶子节点链
-  for (size_t i = 0; i < leafNodes.size() - 1; ++i) {
-    auto leafNode =
-        std::dynamic_pointer_cast<LeafNode<keyType, valueType>>(leafNodes[i]);
-    auto nextNode = std::dynamic_pointer_cast<LeafNode<keyType, valueType>>(
-        leafNodes[i + 1]);
-    leafNode->next = nextNode;
-    std::cout << "Connected leaf node at offset " << leafNode->keys.front()
-              << " to offset " << nextNode->keys.front() << std::endl;
+template <typename keyType, typename valueType, size_t fanout>
+inline size_t BplusTree<keyType, valueType, fanout>::Frozen::lowerBound(
+    const keyType &key) const {
+  if (keys.empty()) {
+    return 0;
+  }
+  // 在块的最小key上找第一个 >= key 的块：沿Eytzinger数组下降，
+  // 向右走一步记一位1，最后去掉末尾连续的1和最后一次向左的一位即为该块
+  // 的位置(为0表示所有块的最小key都 < key)
+  size_t blocks = index.size() - 1;
+  // 每条缓存行的key数，预取本位置往下log2(stride)层的孩子
+  constexpr size_t stride = std::max<size_t>(1, CACHE_LINE / sizeof(keyType));
+  size_t k = 1;
+  while (k <= blocks) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(index.data() + std::min(k * stride, blocks));
+#endif
+    k = 2 * k + (index[k] < key);
+  }
+  while (k & 1) {
+    k >>= 1;
   }
+  k >>= 1;
+  size_t block = k == 0 ? blocks : blockOf[k];
 
-  inFile.close();
-  std::cout << "Deserialization completed, total nodes loaded: "
-            << offsetNodeMap.size() << std::endl;
+  // 第block块的最小key >= key，答案在前一块里或恰为本块起点
+  if (block == 0) {
+    return 0;
+  }
+  size_t first = (block - 1) * BLOCK;
+  size_t count = std::min(BLOCK, keys.size() - first);
+  return first + nodeLowerBound(keys.data() + first, count, key);
+}
 
-  if (!inFile.good()) {
-    throw std::runtime_error("Failed to read file: " + filename);
+template <typename keyType, typename valueType, size_t fanout>
+inline valueType BplusTree<keyType, valueType, fanout>::Frozen::search(
+    const keyType &key) const {
+  size_t i = lowerBound(key);
+  if (i < keys.size() && keys[i] == key) {
+    return values[i];
   }
+  return valueType{};
+}
+
+template <typename keyType, typename valueType, size_t fanout>
+inline std::vector<std::pair<keyType, valueType>>
+BplusTree<keyType, valueType, fanout>::Frozen::rangeSearch(
+    const keyType &startKey, const keyType &endKey) const {
+  std::vector<std::pair<keyType, valueType>> result;
+  for (size_t i = lowerBound(startKey);
+       i < keys.size() && !(endKey < keys[i]); ++i) {
+    result.emplace_back(keys[i], values[i]);
+  }
+  return result;
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,214 @@
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include "PageFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 有界页缓存：固定数量的页帧缓存PageFile中的页
+// 使用者fetch/create得到页帧地址时页被钉住(pin)，用完unpin并注明是否修改
+// 页帧不够时按clock算法淘汰一个未被钉住的页，脏页先写回再复用
+//
+// 并发约定：所有接口由内部互斥锁串行化；钉住期间页帧地址不变，
+// 但同一页的内容由使用者自行同步
+class BufferPool {
+private:
+  // 页帧对齐(便于直接按节点头/key数组解释页内容)
+  static constexpr size_t FRAME_ALIGN = 64;
+
+  struct Frame {
+    PageId page = NULL_PAGE;
+    uint32_t pinCount = 0;
+    bool used = false;       // 是否装有页
+    bool dirty = false;      // 是否需要写回
+    bool referenced = false; // clock引用位
+  };
+
+  PageFile &file;
+  size_t frameBytes;
+  std::unique_ptr<char[]> storage; // 全部页帧(多申请FRAME_ALIGN字节用于对齐)
+  char *frames;
+  std::vector<Frame> frameInfo;
+  std::unordered_map<PageId, size_t> pageTable; // 页号 -> 页帧
+  size_t clockHand;
+  std::mutex mutex;
+
+  // 统计
+  uint64_t hitCount = 0;
+  uint64_t missCount = 0;
+  uint64_t writeCount = 0;
+
+  char *frameData(size_t index) const { return frames + index * frameBytes; }
+
+  // 找一个可用的页帧：优先空帧，否则clock淘汰(引用位为1的给第二次机会)
+  size_t victim() {
+    for (size_t scanned = 0; scanned < 2 * frameInfo.size(); ++scanned) {
+      size_t index = clockHand;
+      clockHand = (clockHand + 1) % frameInfo.size();
+      Frame &frame = frameInfo[index];
+      if (!frame.used) {
+        return index;
+      }
+      if (frame.pinCount > 0) {
+        continue;
+      }
+      if (frame.referenced) {
+        frame.referenced = false;
+        continue;
+      }
+      if (frame.dirty) {
+        file.write(frame.page, frameData(index));
+        ++writeCount;
+      }
+      pageTable.erase(frame.page);
+      frame = Frame();
+      return index;
+    }
+    throw std::runtime_error("Buffer pool exhausted: all " +
+                             std::to_string(frameInfo.size()) +
+                             " frames are pinned");
+  }
+
+  char *install(PageId id, size_t index, bool dirty) {
+    Frame &frame = frameInfo[index];
+    frame.page = id;
+    frame.pinCount = 1;
+    frame.used = true;
+    frame.dirty = dirty;
+    frame.referenced = true;
+    pageTable[id] = index;
+    return frameData(index);
+  }
+
+public:
+  BufferPool(PageFile &file, size_t capacity)
+      : file(file), frameBytes(file.pageSize()),
+        storage(new char[capacity * file.pageSize() + FRAME_ALIGN]),
+        frameInfo(capacity), clockHand(0) {
+    if (capacity == 0) {
+      throw std::invalid_argument("Buffer pool needs at least one frame");
+    }
+    auto address = reinterpret_cast<uintptr_t>(storage.get());
+    frames =
+        storage.get() + (FRAME_ALIGN - address % FRAME_ALIGN) % FRAME_ALIGN;
+    pageTable.reserve(capacity);
+  }
+
+  BufferPool(const BufferPool &) = delete;
+  BufferPool &operator=(const BufferPool &) = delete;
+
+  size_t capacity() const { return frameInfo.size(); }
+  size_t pageSize() const { return frameBytes; }
+  uint64_t hits() const { return hitCount; }
+  uint64_t misses() const { return missCount; }
+  uint64_t writes() const { return writeCount; }
+
+  // 钉住并返回已有的页，未缓存时从文件读入
+  char *fetch(PageId id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = pageTable.find(id);
+    if (it != pageTable.end()) {
+      Frame &frame = frameInfo[it->second];
+      ++frame.pinCount;
+      frame.referenced = true;
+      ++hitCount;
+      return frameData(it->second);
+    }
+    ++missCount;
+    size_t index = victim();
+    file.read(id, frameData(index));
+    return install(id, index, false);
+  }
+
+  // 钉住并返回一个内容清零的页(调用方将整页重写，不必从文件读入)
+  char *create(PageId id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = pageTable.find(id);
+    size_t index;
+    if (it != pageTable.end()) {
+      index = it->second;
+      Frame &frame = frameInfo[index];
+      ++frame.pinCount;
+      frame.referenced = true;
+      frame.dirty = true;
+    } else {
+      index = victim();
+      install(id, index, true);
+    }
+    std::memset(frameData(index), 0, frameBytes);
+    return frameData(index);
+  }
+
+  // 解除钉住；dirty表示使用者修改过页内容
+  void unpin(PageId id, bool dirty) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = pageTable.find(id);
+    if (it == pageTable.end() || frameInfo[it->second].pinCount == 0) {
+      throw std::logic_error("Unpinning page " + std::to_string(id) +
+                             " that is not pinned");
+    }
+    Frame &frame = frameInfo[it->second];
+    --frame.pinCount;
+    frame.dirty = frame.dirty || dirty;
+  }
+
+  // 把所有脏页写回文件(不刷盘)
+  void flushAll() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < frameInfo.size(); ++i) {
+      Frame &frame = frameInfo[i];
+      if (frame.used && frame.dirty) {
+        file.write(frame.page, frameData(i));
+        frame.dirty = false;
+        ++writeCount;
+      }
+    }
+  }
+
+  // 丢弃所有未钉住的页(不写回)
+  void discard() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Frame &frame : frameInfo) {
+      if (frame.used && frame.pinCount == 0) {
+        pageTable.erase(frame.page);
+        frame = Frame();
+      }
+    }
+  }
+};
+
+// 钉住一页，离开作用域时解除钉住
+class PageGuard {
+private:
+  BufferPool &pool;
+  PageId id;
+  char *bytes;
+  bool dirty;
+
+public:
+  // 读取已有的页
+  PageGuard(BufferPool &pool, PageId id)
+      : pool(pool), id(id), bytes(pool.fetch(id)), dirty(false) {}
+
+  // 新建(整页重写)的页
+  struct Create {};
+  PageGuard(BufferPool &pool, PageId id, Create)
+      : pool(pool), id(id), bytes(pool.create(id)), dirty(true) {}
+
+  ~PageGuard() { pool.unpin(id, dirty); }
+
+  PageGuard(const PageGuard &) = delete;
+  PageGuard &operator=(const PageGuard &) = delete;
+
+  char *data() const { return bytes; }
+  void markDirty() { dirty = true; }
+};
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <cstddef>
+#include <cstdint>
+
+// CRC-32(IEEE 802.3，多项式0xEDB88320)，用于日志记录和文件头的完整性校验
+namespace checksum_detail {
+struct Crc32Table {
+  uint32_t entries[256];
+  constexpr Crc32Table() : entries() {
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t crc = i;
+      for (int bit = 0; bit < 8; ++bit) {
+        crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+      }
+      entries[i] = crc;
+    }
+  }
+};
+inline constexpr Crc32Table crc32Table{};
+} // namespace checksum_detail
+
+inline uint32_t crc32(const void *data, size_t length) {
+  auto bytes = static_cast<const uint8_t *>(data);
+  uint32_t crc = 0xFFFFFFFFu;
+  for (size_t i = 0; i < length; ++i) {
+    crc = checksum_detail::crc32Table.entries[(crc ^ bytes[i]) & 0xFFu] ^
+          (crc >> 8);
+  }
+  return crc ^ 0xFFFFFFFFu;
+}
+
+#endif
@@ -0,0 +1,178 @@
+#ifndef EPOCHMANAGER_H
+#define EPOCHMANAGER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// 基于epoch的延迟回收(进程内所有树共用一个全局epoch)
+// 无锁读者在操作开始时登记当前的全局epoch，结束时撤销登记：每个操作
+// 一次store和一次fence，沿途访问节点没有额外的原子操作
+// 写者把摘除的对象连同当时的epoch放入退休列表(RetireList)，攒够一批后推进
+// 全局epoch，只释放epoch小于所有已登记读者epoch的对象——登记得更晚的读者
+// 已经看不到这些对象，不会再访问它们
+//
+// 每个线程第一次登记时占用一条记录(按缓存行对齐，读者只写自己的记录)，
+// 线程退出时归还供其他线程复用；记录本身不释放
+class EpochManager {
+public:
+  // 未登记的记录
+  static constexpr uint64_t IDLE = std::numeric_limits<uint64_t>::max();
+
+private:
+  struct alignas(64) Record {
+    std::atomic<uint64_t> epoch{IDLE}; // 已登记的epoch
+    std::atomic<bool> owned{false};    // 是否已被某个线程占用
+    Record *next = nullptr;            // 记录链表(只在头部插入)
+  };
+
+  // 线程占用的记录和登记的嵌套深度(同一线程的操作可能嵌套)
+  struct LocalRecord {
+    Record *record = nullptr;
+    unsigned depth = 0;
+
+    ~LocalRecord() {
+      if (record != nullptr) {
+        record->epoch.store(IDLE, std::memory_order_release);
+        record->owned.store(false, std::memory_order_release);
+      }
+    }
+  };
+
+  std::atomic<uint64_t> globalEpoch{1};
+  std::atomic<Record *> records{nullptr};
+
+  EpochManager() = default;
+
+  static LocalRecord &local() {
+    thread_local LocalRecord record;
+    return record;
+  }
+
+  // 占用一条空闲记录，没有时新建并插入链表头部
+  Record *acquireRecord() {
+    for (Record *record = records.load(std::memory_order_acquire);
+         record != nullptr; record = record->next) {
+      bool expected = false;
+      if (!record->owned.load(std::memory_order_relaxed) &&
+          record->owned.compare_exchange_strong(expected, true,
+                                                std::memory_order_acquire)) {
+        return record;
+      }
+    }
+    Record *record = new Record;
+    record->owned.store(true, std::memory_order_relaxed);
+    Record *head = records.load(std::memory_order_relaxed);
+    do {
+      record->next = head;
+    } while (!records.compare_exchange_weak(head, record,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed));
+    return record;
+  }
+
+public:
+  EpochManager(const EpochManager &) = delete;
+  EpochManager &operator=(const EpochManager &) = delete;
+
+  // 全局实例(不析构：线程退出时归还记录可能晚于静态对象析构)
+  static EpochManager &instance() {
+    static EpochManager *manager = new EpochManager;
+    return *manager;
+  }
+
+  // 登记：之后读到的对象在撤销登记前不会被释放
+  void enter() {
+    LocalRecord &local = EpochManager::local();
+    if (local.depth++ > 0) {
+      return;
+    }
+    if (local.record == nullptr) {
+      local.record = acquireRecord();
+    }
+    local.record->epoch.store(globalEpoch.load(std::memory_order_seq_cst),
+                              std::memory_order_relaxed);
+    // 登记先于之后对共享数据的读取对回收者可见
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+
+  // 撤销登记
+  void exit() {
+    LocalRecord &local = EpochManager::local();
+    if (--local.depth == 0) {
+      local.record->epoch.store(IDLE, std::memory_order_release);
+    }
+  }
+
+  // 对象退休时的epoch(调用方已把对象摘除)：fence保证登记的epoch比它大的
+  // 读者都能看到摘除
+  uint64_t retireEpoch() const {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return globalEpoch.load(std::memory_order_seq_cst);
+  }
+
+  // 推进全局epoch，返回可回收的上界：退休时epoch小于它的对象都可以释放
+  uint64_t advance() {
+    uint64_t safe = globalEpoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+    // 退休(摘除)先于读取各记录
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (Record *record = records.load(std::memory_order_acquire);
+         record != nullptr; record = record->next) {
+      uint64_t epoch = record->epoch.load(std::memory_order_acquire);
+      if (epoch < safe) {
+        safe = epoch;
+      }
+    }
+    return safe;
+  }
+};
+
+// 登记守卫
+class EpochGuard {
+public:
+  EpochGuard() { EpochManager::instance().enter(); }
+  ~EpochGuard() { EpochManager::instance().exit(); }
+
+  EpochGuard(const EpochGuard &) = delete;
+  EpochGuard &operator=(const EpochGuard &) = delete;
+};
+
+// 退休列表：已摘除、等待宽限期结束的对象(由调用方串行化)
+// 对象按退休的先后(即epoch升序)排列
+template <typename T> class RetireList {
+private:
+  std::vector<std::pair<uint64_t, T>> items;
+
+public:
+  // 对象已对新的读者不可达
+  void retire(T item) {
+    items.emplace_back(EpochManager::instance().retireEpoch(),
+                       std::move(item));
+  }
+
+  // 推进epoch，对宽限期已过的对象调用release后移出列表，返回移出的个数
+  template <typename Release> size_t reclaim(Release &&release) {
+    if (items.empty()) {
+      return 0;
+    }
+    uint64_t safe = EpochManager::instance().advance();
+    size_t count = 0;
+    while (count < items.size() && items[count].first < safe) {
+      release(items[count].second);
+      ++count;
+    }
+    items.erase(items.begin(), items.begin() + count);
+    return count;
+  }
+  size_t reclaim() { return reclaim([](T &) {}); }
+
+  // 丢弃全部对象(调用方保证没有并发读者)
+  void clear() { items.clear(); }
+
+  size_t size() const { return items.size(); }
+};
+
+#endif
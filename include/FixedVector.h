@@ -0,0 +1,177 @@
+#ifndef FIXEDVECTOR_H
+#define FIXEDVECTOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// 定长顺序容器(接口与std::vector的常用子集一致)
+// 元素存放在调用方提供的内联存储中(即节点槽位内部)，容量固定，永不重新分配
+template <typename T> class FixedVector {
+private:
+  T *elems;       // 指向槽位内的存储区
+  uint32_t count; // 当前元素个数
+  uint32_t cap;   // 容量
+
+  static constexpr bool trivial = std::is_trivially_copyable_v<T>;
+
+  void checkCapacity(size_t n) const {
+    if (n > cap) {
+      throw std::length_error("FixedVector capacity exceeded");
+    }
+  }
+
+public:
+  using value_type = T;
+  using iterator = T *;
+  using const_iterator = const T *;
+
+  FixedVector(void *storage, size_t capacity)
+      : elems(static_cast<T *>(storage)), count(0),
+        cap(static_cast<uint32_t>(capacity)) {}
+
+  ~FixedVector() { clear(); }
+
+  FixedVector(const FixedVector &) = delete;
+  FixedVector &operator=(const FixedVector &) = delete;
+
+  size_t size() const { return count; }
+  size_t capacity() const { return cap; }
+  bool empty() const { return count == 0; }
+
+  T *data() { return elems; }
+  const T *data() const { return elems; }
+
+  iterator begin() { return elems; }
+  iterator end() { return elems + count; }
+  const_iterator begin() const { return elems; }
+  const_iterator end() const { return elems + count; }
+
+  T &operator[](size_t i) { return elems[i]; }
+  const T &operator[](size_t i) const { return elems[i]; }
+
+  T &front() { return elems[0]; }
+  const T &front() const { return elems[0]; }
+  T &back() { return elems[count - 1]; }
+  const T &back() const { return elems[count - 1]; }
+
+  void push_back(const T &value) {
+    checkCapacity(count + 1);
+    new (elems + count) T(value);
+    ++count;
+  }
+
+  void pop_back() {
+    --count;
+    std::destroy_at(elems + count);
+  }
+
+  // 在pos处插入单个元素
+  iterator insert(const_iterator pos, const T &value) {
+    size_t index = static_cast<size_t>(pos - elems);
+    checkCapacity(count + 1);
+    if constexpr (trivial) {
+      T copy = value; // value可能指向本容器内的元素
+      std::memmove(static_cast<void *>(elems + index + 1), elems + index,
+                   (count - index) * sizeof(T));
+      elems[index] = copy;
+    } else {
+      if (index == count) {
+        new (elems + count) T(value);
+      } else {
+        T copy(value);
+        new (elems + count) T(std::move(elems[count - 1]));
+        std::move_backward(elems + index, elems + count - 1, elems + count);
+        elems[index] = std::move(copy);
+      }
+    }
+    ++count;
+    return elems + index;
+  }
+
+  // 在pos处插入区间[first, last)(区间不得来自本容器)
+  template <typename InputIt>
+  iterator insert(const_iterator pos, InputIt first, InputIt last) {
+    size_t index = static_cast<size_t>(pos - elems);
+    size_t n = static_cast<size_t>(std::distance(first, last));
+    checkCapacity(count + n);
+    if (n == 0) {
+      return elems + index;
+    }
+
+    if constexpr (trivial) {
+      std::memmove(static_cast<void *>(elems + index + n), elems + index,
+                   (count - index) * sizeof(T));
+      std::copy(first, last, elems + index);
+    } else {
+      // 尾部元素从后往前后移n位
+      for (size_t i = count; i-- > index;) {
+        if (i + n >= count) {
+          new (elems + i + n) T(std::move(elems[i]));
+        } else {
+          elems[i + n] = std::move(elems[i]);
+        }
+      }
+      // 写入新元素
+      for (size_t i = index; first != last; ++first, ++i) {
+        if (i >= count) {
+          new (elems + i) T(*first);
+        } else {
+          elems[i] = *first;
+        }
+      }
+    }
+    count += static_cast<uint32_t>(n);
+    return elems + index;
+  }
+
+  iterator erase(const_iterator pos) {
+    return erase(pos, pos + 1);
+  }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    size_t index = static_cast<size_t>(first - elems);
+    size_t n = static_cast<size_t>(last - first);
+    if (n == 0) {
+      return elems + index;
+    }
+    if constexpr (trivial) {
+      std::memmove(static_cast<void *>(elems + index), elems + index + n,
+                   (count - index - n) * sizeof(T));
+    } else {
+      std::move(elems + index + n, elems + count, elems + index);
+      std::destroy(elems + count - n, elems + count);
+    }
+    count -= static_cast<uint32_t>(n);
+    return elems + index;
+  }
+
+  void resize(size_t n) {
+    checkCapacity(n);
+    if (n < count) {
+      std::destroy(elems + n, elems + count);
+    } else {
+      std::uninitialized_value_construct(elems + count, elems + n);
+    }
+    count = static_cast<uint32_t>(n);
+  }
+
+  template <typename InputIt> void assign(InputIt first, InputIt last) {
+    clear();
+    insert(begin(), first, last);
+  }
+
+  void clear() {
+    std::destroy(elems, elems + count);
+    count = 0;
+  }
+};
+
+#endif
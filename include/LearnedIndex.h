@@ -0,0 +1,379 @@
+#ifndef LEARNEDINDEX_H
+#define LEARNEDINDEX_H
+
+#include "EpochManager.h"
+#include "NodeArena.h"
+#include "NodeSearch.h"
+#include "VersionLatch.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+// 学习索引：叶子之上的路由层，按key找到所在的叶子而不经过内部节点
+//
+// 条目是各叶子的下界(整数key映射成保序的无符号64位数，第一个叶子为0)及其句柄，
+// 按下界升序排列；在其上贪心地拟合分段线性模型(收缩锥)，每段对本段条目的
+// 下标预测误差不超过maxError。查找时先二分选出所在的段，按模型预测下标，
+// 再在 [预测 - 误差, 预测 + 误差] 内二分；窗口边界不能确认结果时退回整体二分，
+// 结果总是精确的
+//
+// 维护：叶子分裂/借调/合并时同步插入、改动或删除一个条目(下标整体平移)，
+// 只累计偏移量drift并放宽窗口，drift超过maxError时按当前条目重新拟合
+//
+// 并发约定：写操作由调用方串行化(树的smoMutex)，期间持有版本锁；
+// 读者不加锁，读前记下版本、读完校验(与节点相同)，读到的句柄在校验通过后才可信
+// 存储块容量不够时换新块，旧块退休(见EpochManager.h)，无锁读者都离开后才释放；
+// 读者的下标都按块容量截断，撕裂的数据不会越界
+class LearnedIndex {
+public:
+  static constexpr size_t DEFAULT_MAX_ERROR = 16;
+
+private:
+  // 一段线性模型：start <= key时预测下标 first + slope * (key - start)，
+  // 不超过本段最后一个条目的预测值cap
+  struct Segment {
+    double slope;
+    double first;
+    double cap;
+  };
+
+  // 一块存储：条目和段共用同一容量(段数不超过条目数)
+  struct Table {
+    size_t capacity;
+    size_t count = 0;        // 条目数
+    size_t segmentCount = 0; // 段数
+    size_t window = 0;       // 查找窗口的半径(实测误差 + drift)
+    std::unique_ptr<uint64_t[]> lows;     // 叶子下界(升序)
+    std::unique_ptr<NodeHandle[]> leaves; // 叶子句柄
+    std::unique_ptr<uint64_t[]> starts;   // 各段起点
+    std::unique_ptr<Segment[]> segments;
+
+    explicit Table(size_t capacity)
+        : capacity(capacity), lows(new uint64_t[capacity]),
+          leaves(new NodeHandle[capacity]), starts(new uint64_t[capacity]),
+          segments(new Segment[capacity]) {}
+  };
+
+  static constexpr size_t MIN_CAPACITY = 64;
+  // 有旧块等待释放时，每隔多少次reserve尝试回收一次(回收要推进全局epoch
+  // 并扫描所有线程的记录)
+  static constexpr size_t RECLAIM_INTERVAL = 64;
+  static constexpr size_t NOT_FOUND = std::numeric_limits<size_t>::max();
+
+  size_t maxError;                        // 拟合的误差上限
+  size_t error = 0;                       // 拟合后实测的最大误差
+  size_t drift = 0;                       // 拟合后插入/删除/改动的条目数
+  std::atomic<bool> enabled{false};       // 条目与叶子层一致，可用于查找
+  VersionLatch versionLatch;              // 读者乐观校验
+  std::unique_ptr<Table> owned;           // 当前块
+  std::atomic<Table *> current{nullptr};  // owned，供读者读取
+  // 换下的旧块，等无锁读者离开后释放
+  RetireList<std::unique_ptr<Table>> retired;
+  size_t reservesSinceReclaim = 0;
+
+  // 预测key的下标(n个条目、m个段)
+  static size_t predict(const Table &table, size_t n, size_t m, uint64_t key) {
+    size_t seg = nodeUpperBound(table.starts.get(), m, key);
+    seg = seg > 0 ? seg - 1 : 0;
+    const Segment &segment = table.segments[seg];
+    uint64_t start = table.starts[seg];
+    double p = segment.first;
+    if (key > start) {
+      p += segment.slope * static_cast<double>(key - start);
+    }
+    p = std::min(p, segment.cap);
+    // 撕裂的数据可能是NaN或越界值
+    if (!(p >= 0.0)) {
+      return 0;
+    }
+    if (!(p < static_cast<double>(n))) {
+      return n - 1;
+    }
+    return static_cast<size_t>(p + 0.5);
+  }
+
+  // 容量至少为n的存储块(调用方持有版本锁)
+  Table &reserve(size_t n) {
+    if (retired.size() > 0 && ++reservesSinceReclaim >= RECLAIM_INTERVAL) {
+      reservesSinceReclaim = 0;
+      retired.reclaim();
+    }
+    Table *table = current.load(std::memory_order_relaxed);
+    if (table != nullptr && table->capacity >= n) {
+      return *table;
+    }
+    size_t capacity = table != nullptr ? table->capacity : MIN_CAPACITY;
+    while (capacity < n) {
+      capacity *= 2;
+    }
+    auto grown = std::make_unique<Table>(capacity);
+    if (table != nullptr) {
+      std::copy(table->lows.get(), table->lows.get() + table->count,
+                grown->lows.get());
+      std::copy(table->leaves.get(), table->leaves.get() + table->count,
+                grown->leaves.get());
+      grown->count = table->count;
+    }
+    current.store(grown.get(), std::memory_order_release);
+    if (owned != nullptr) {
+      retired.retire(std::move(owned));
+    }
+    owned = std::move(grown);
+    return *owned;
+  }
+
+  // 按当前条目重新拟合(收缩锥)，并实测误差
+  void fit(Table &table) {
+    size_t n = table.count;
+    const uint64_t *lows = table.lows.get();
+    double bound = static_cast<double>(maxError);
+    size_t m = 0;
+    for (size_t s = 0; s < n;) {
+      uint64_t start = lows[s];
+      double lo = 0.0, hi = std::numeric_limits<double>::infinity();
+      size_t e = s + 1;
+      for (; e < n; ++e) {
+        double dx = static_cast<double>(lows[e] - start);
+        double dy = static_cast<double>(e - s);
+        if (dx == 0.0) {
+          if (dy > bound) {
+            break;
+          }
+          continue;
+        }
+        double newLo = std::max(lo, (dy - bound) / dx);
+        double newHi = std::min(hi, (dy + bound) / dx);
+        if (newLo > newHi) {
+          break;
+        }
+        lo = newLo;
+        hi = newHi;
+      }
+      double slope = hi == std::numeric_limits<double>::infinity()
+                         ? 0.0
+                         : (lo + hi) / 2;
+      double first = static_cast<double>(s);
+      double last = first + slope * static_cast<double>(lows[e - 1] - start);
+      table.starts[m] = start;
+      table.segments[m] = {slope, first, last};
+      ++m;
+      s = e;
+    }
+    table.segmentCount = m;
+
+    // 按查找时同样的计算实测误差(浮点舍入可能略超maxError)
+    error = 0;
+    for (size_t i = 0; i < n; ++i) {
+      size_t p = predict(table, n, m, lows[i]);
+      error = std::max(error, p > i ? p - i : i - p);
+    }
+    drift = 0;
+    table.window = error;
+  }
+
+  // 条目增删改后累计偏移，超过上限时重新拟合
+  void shifted(Table &table) {
+    if (++drift > maxError) {
+      fit(table);
+    } else {
+      table.window = error + drift;
+    }
+  }
+
+  // 下界为low的条目中句柄为leaf的下标
+  static size_t locate(const Table &table, uint64_t low, NodeHandle leaf) {
+    size_t i = nodeUpperBound(table.lows.get(), table.count, low);
+    for (; i > 0 && table.lows[i - 1] == low; --i) {
+      if (table.leaves[i - 1] == leaf) {
+        return i - 1;
+      }
+    }
+    return NOT_FOUND;
+  }
+
+  // 条目与叶子层对不上(不应发生)：停用，查找退回逐层下降
+  void invalidate(Table &table) {
+    table.count = 0;
+    table.segmentCount = 0;
+    enabled.store(false, std::memory_order_release);
+  }
+
+public:
+  explicit LearnedIndex(size_t maxError = DEFAULT_MAX_ERROR)
+      : maxError(maxError) {}
+
+  LearnedIndex(const LearnedIndex &) = delete;
+  LearnedIndex &operator=(const LearnedIndex &) = delete;
+
+  // 是否可用于查找
+  bool active() const { return enabled.load(std::memory_order_acquire); }
+
+  // 版本锁(读者用)
+  const VersionLatch &latch() const { return versionLatch; }
+
+  // 条目数、段数、查找窗口半径(写者或无并发时读取)
+  size_t size() const {
+    Table *table = current.load(std::memory_order_acquire);
+    return active() && table != nullptr ? table->count : 0;
+  }
+  size_t segmentCount() const {
+    Table *table = current.load(std::memory_order_acquire);
+    return active() && table != nullptr ? table->segmentCount : 0;
+  }
+  size_t window() const {
+    Table *table = current.load(std::memory_order_acquire);
+    return active() && table != nullptr ? table->window : 0;
+  }
+
+  // 读者：key所在的叶子(持有读版本，校验通过后结果才可信)
+  // 没有条目时返回NULL_HANDLE
+  NodeHandle route(uint64_t key) const {
+    const Table *table = current.load(std::memory_order_acquire);
+    if (table == nullptr) {
+      return NULL_HANDLE;
+    }
+    size_t n = std::min(table->count, table->capacity);
+    size_t m = std::min(table->segmentCount, table->capacity);
+    if (n == 0 || m == 0) {
+      return NULL_HANDLE;
+    }
+    size_t p = predict(*table, n, m, key);
+    size_t w = std::min(table->window, n) + 1;
+    size_t a = p > w ? p - w : 0;
+    size_t b = std::min(n, p + w + 1);
+    const uint64_t *lows = table->lows.get();
+    size_t i = a + nodeUpperBound(lows + a, b - a, key);
+    if ((i == a && a > 0) || (i == b && b < n && lows[b] <= key)) {
+      i = nodeUpperBound(lows, n, key);
+    }
+    return i > 0 ? table->leaves[i - 1] : NULL_HANDLE;
+  }
+
+  // 以下由调用方串行化
+
+  // 拟合的误差上限(下次拟合时生效)
+  void configure(size_t maxError) { this->maxError = maxError; }
+
+  // 重建：lows[i]为第i个叶子的下界(lows[0]为0)
+  void assign(const std::vector<uint64_t> &lows,
+              const std::vector<NodeHandle> &leaves) {
+    versionLatch.lock();
+    Table &table = reserve(lows.size());
+    std::copy(lows.begin(), lows.end(), table.lows.get());
+    std::copy(leaves.begin(), leaves.end(), table.leaves.get());
+    table.count = lows.size();
+    fit(table);
+    enabled.store(true, std::memory_order_release);
+    versionLatch.unlock();
+  }
+
+  // 停用(条目清空)
+  void disable() {
+    versionLatch.lock();
+    Table *table = current.load(std::memory_order_relaxed);
+    if (table != nullptr) {
+      invalidate(*table);
+    }
+    enabled.store(false, std::memory_order_release);
+    versionLatch.unlock();
+  }
+
+  // 树已清空(保持启用)
+  void clear() {
+    if (!active()) {
+      return;
+    }
+    versionLatch.lock();
+    Table &table = reserve(0);
+    table.count = 0;
+    table.segmentCount = 0;
+    versionLatch.unlock();
+  }
+
+  // 叶子left分裂出右侧的新叶子leaf，其下界为low
+  // (没有条目时left是唯一的叶子)
+  void insert(NodeHandle left, uint64_t low, NodeHandle leaf) {
+    if (!active()) {
+      return;
+    }
+    versionLatch.lock();
+    Table *old = current.load(std::memory_order_relaxed);
+    Table &table = reserve(std::max<size_t>(old ? old->count + 1 : 0, 2));
+    if (table.count == 0) {
+      table.lows[0] = 0;
+      table.leaves[0] = left;
+      table.lows[1] = low;
+      table.leaves[1] = leaf;
+      table.count = 2;
+      fit(table);
+      versionLatch.unlock();
+      return;
+    }
+    // 新条目紧跟在left之后(下界相同的条目中按句柄找到left)
+    size_t i = nodeUpperBound(table.lows.get(), table.count, low);
+    while (i > 0 && table.leaves[i - 1] != left && table.lows[i - 1] == low) {
+      --i;
+    }
+    if (i == 0 || table.leaves[i - 1] != left) {
+      invalidate(table);
+      versionLatch.unlock();
+      return;
+    }
+    std::copy_backward(table.lows.get() + i, table.lows.get() + table.count,
+                       table.lows.get() + table.count + 1);
+    std::copy_backward(table.leaves.get() + i,
+                       table.leaves.get() + table.count,
+                       table.leaves.get() + table.count + 1);
+    table.lows[i] = low;
+    table.leaves[i] = leaf;
+    ++table.count;
+    shifted(table);
+    versionLatch.unlock();
+  }
+
+  // 下界为low的叶子leaf被合并掉
+  void erase(uint64_t low, NodeHandle leaf) {
+    if (!active()) {
+      return;
+    }
+    versionLatch.lock();
+    Table &table = *current.load(std::memory_order_relaxed);
+    size_t i = locate(table, low, leaf);
+    if (i == NOT_FOUND || i == 0) {
+      invalidate(table);
+      versionLatch.unlock();
+      return;
+    }
+    std::copy(table.lows.get() + i + 1, table.lows.get() + table.count,
+              table.lows.get() + i);
+    std::copy(table.leaves.get() + i + 1, table.leaves.get() + table.count,
+              table.leaves.get() + i);
+    --table.count;
+    shifted(table);
+    versionLatch.unlock();
+  }
+
+  // 借调后叶子leaf的下界由oldLow变为newLow
+  void update(uint64_t oldLow, NodeHandle leaf, uint64_t newLow) {
+    if (!active()) {
+      return;
+    }
+    versionLatch.lock();
+    Table &table = *current.load(std::memory_order_relaxed);
+    size_t i = locate(table, oldLow, leaf);
+    if (i == NOT_FOUND || i == 0) {
+      invalidate(table);
+      versionLatch.unlock();
+      return;
+    }
+    table.lows[i] = newLow;
+    shifted(table);
+    versionLatch.unlock();
+  }
+};
+
+#endif
@@ -0,0 +1,187 @@
+#ifndef NODEARENA_H
+#define NODEARENA_H
+
+#include "VersionLatch.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+// 节点句柄：节点在arena中的槽位编号，0表示空
+using NodeHandle = uint32_t;
+constexpr NodeHandle NULL_HANDLE = 0;
+
+// slab式节点存储：按chunk批量申请定长槽位，用句柄寻址
+// 释放的槽位进入空闲链表供后续分配复用，内存随arena一起归还
+//
+// 并发约定：allocate/release/clear由调用方串行化；get/latch可与之并发
+// chunk按几何级数增长(第k个chunk含 base << k 个槽位)，目录是定长数组，
+// 申请新chunk不会移动已有的目录项，无锁读者随时可以把句柄转成地址
+//
+// 槽位布局：[VersionLatch][节点]，槽位大小按slotAlign取整(chunk按缓存行对齐，
+// slotAlign为64时每个槽位都从缓存行起点开始)
+// 版本锁在槽位首次使用时初始化，之后复用槽位只推进版本号，不会被重置，
+// 持有旧版本号的乐观读者校验必然失败
+class NodeArena {
+public:
+  // 默认的槽位对齐(节点对齐要求不超过8字节)
+  static constexpr size_t SLOT_ALIGN = 8;
+  // 版本锁占用的槽位前缀(节点从槽位的这个偏移开始)
+  static constexpr size_t LATCH_BYTES = sizeof(VersionLatch);
+
+private:
+  // 第一个chunk的目标字节数
+  static constexpr size_t BASE_CHUNK_BYTES = 64 * 1024;
+  // chunk尾部留白：乐观读者在校验前可能按过期的布局越界读少量字节
+  static constexpr size_t CHUNK_PADDING = 64;
+  // 句柄为32位，目录项数量有上限
+  static constexpr size_t MAX_CHUNKS = 33;
+
+  size_t slotBytes; // 每个槽位的字节数(含版本锁)
+  size_t baseShift; // 第一个chunk含 1 << baseShift 个槽位
+
+  std::atomic<char *> chunks[MAX_CHUNKS]; // 已申请的chunk
+  size_t chunkCount;                      // 已申请的chunk数
+  NodeHandle nextSlot;                    // 下一个从未使用过的槽位
+  std::vector<NodeHandle> freeList;       // 已释放的槽位
+  size_t liveCount;                       // 在用槽位数
+
+  // 统计(与allocate/release一样由调用方串行化，clear不清零)
+  uint64_t hitCount = 0;     // 由空闲链表满足的分配
+  uint64_t missCount = 0;    // 取用新槽位的分配
+  uint64_t releaseCount = 0; // 归还的槽位
+
+  static unsigned log2Floor(uint64_t n) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63u - static_cast<unsigned>(__builtin_clzll(n));
+#else
+    unsigned result = 0;
+    while (n >>= 1) {
+      ++result;
+    }
+    return result;
+#endif
+  }
+
+  size_t chunkSlots(size_t index) const {
+    return size_t(1) << (baseShift + index);
+  }
+
+  // 句柄 -> 槽位起始地址
+  char *slot(NodeHandle handle) const {
+    uint64_t biased = uint64_t(handle) + (uint64_t(1) << baseShift);
+    unsigned index = log2Floor(biased) - static_cast<unsigned>(baseShift);
+    uint64_t offset = biased - (uint64_t(1) << (index + baseShift));
+    return chunks[index].load(std::memory_order_acquire) + offset * slotBytes;
+  }
+
+  void addChunk() {
+    char *chunk = static_cast<char *>(
+        ::operator new(slotBytes * chunkSlots(chunkCount) + CHUNK_PADDING,
+                       std::align_val_t(64)));
+    chunks[chunkCount++].store(chunk, std::memory_order_release);
+  }
+
+  void releaseChunks() {
+    for (size_t i = 0; i < chunkCount; ++i) {
+      ::operator delete(chunks[i].load(std::memory_order_relaxed),
+                        std::align_val_t(64));
+      chunks[i].store(nullptr, std::memory_order_relaxed);
+    }
+    chunkCount = 0;
+  }
+
+public:
+  explicit NodeArena(size_t slotSize, size_t slotAlign = SLOT_ALIGN)
+      : slotBytes((LATCH_BYTES + slotSize + slotAlign - 1) / slotAlign *
+                  slotAlign),
+        baseShift(0), chunkCount(0), nextSlot(1), liveCount(0) {
+    while ((slotBytes << (baseShift + 1)) <= BASE_CHUNK_BYTES) {
+      ++baseShift;
+    }
+    for (auto &chunk : chunks) {
+      chunk.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  ~NodeArena() { releaseChunks(); }
+
+  NodeArena(const NodeArena &) = delete;
+  NodeArena &operator=(const NodeArena &) = delete;
+
+  // 分配一个未初始化的槽位(版本锁处于未加锁状态)
+  // 空闲链表后进先出，最近归还(可能还在缓存中)的槽位先被复用
+  NodeHandle allocate() {
+    ++liveCount;
+    if (!freeList.empty()) {
+      ++hitCount;
+      NodeHandle handle = freeList.back();
+      freeList.pop_back();
+      latch(handle).reset();
+      return handle;
+    }
+    // 第k个chunk覆盖的句柄区间为 [(base << k) - base, (base << (k+1)) - base)
+    uint64_t capacity = (uint64_t(1) << (baseShift + chunkCount)) -
+                        (uint64_t(1) << baseShift);
+    if (nextSlot >= capacity) {
+      addChunk();
+    }
+    ++missCount;
+    NodeHandle handle = nextSlot++;
+    new (slot(handle)) VersionLatch();
+    return handle;
+  }
+
+  // 归还槽位(调用方负责先析构其中的对象，并保证版本锁已解锁)
+  void release(NodeHandle handle) {
+    --liveCount;
+    ++releaseCount;
+    freeList.push_back(handle);
+  }
+
+  // 句柄转节点地址(chunk不会移动，地址在arena清空前一直有效)
+  void *get(NodeHandle handle) const { return slot(handle) + LATCH_BYTES; }
+
+  // 句柄对应的版本锁
+  VersionLatch &latch(NodeHandle handle) const {
+    return *reinterpret_cast<VersionLatch *>(slot(handle));
+  }
+
+  // 预取槽位开头的bytes字节(含版本锁)，只发起加载，不等待
+  void prefetch(NodeHandle handle, size_t bytes) const {
+#if defined(__GNUC__) || defined(__clang__)
+    const char *start = slot(handle);
+    for (size_t offset = 0; offset < bytes; offset += 64) {
+      __builtin_prefetch(start + offset, 0, 3);
+    }
+#else
+    (void)handle;
+    (void)bytes;
+#endif
+  }
+
+  // 丢弃全部槽位(调用方保证没有并发访问)
+  void clear() {
+    releaseChunks();
+    freeList.clear();
+    nextSlot = 1;
+    liveCount = 0;
+  }
+
+  size_t slotSize() const { return slotBytes; }
+  size_t liveSlots() const { return liveCount; }
+  size_t freeSlots() const { return freeList.size(); }
+  uint64_t hits() const { return hitCount; }
+  uint64_t misses() const { return missCount; }
+  uint64_t releases() const { return releaseCount; }
+  size_t reservedBytes() const {
+    size_t bytes = 0;
+    for (size_t i = 0; i < chunkCount; ++i) {
+      bytes += slotBytes * chunkSlots(i);
+    }
+    return bytes;
+  }
+};
+
+#endif
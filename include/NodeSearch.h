@@ -0,0 +1,350 @@
+#ifndef NODESEARCH_H
+#define NODESEARCH_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__AVX2__) || defined(__SSE4_2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// 节点内查找
+// lowerBound: 第一个 >= key 的下标(叶子定位)
+// upperBound: 第一个 >  key 的下标(内部节点选择子节点)
+// 整数key在编译期选择SIMD计数内核，其余算术类型使用无分支二分，
+// 其他类型(如std::string)回退到std::lower_bound/upper_bound
+// 1/2字节的内核供压缩叶子在窄差值数组上查找(见PackedArray.h)
+// 节点容量在编译期已知时(fixedRank)二分的步数固定，
+// key数组按缓存行对齐时(lineRank)按行二分
+
+// SIMD内核适用的key类型：1、2、4或8字节整数(且目标平台至少支持SSE2)
+#if defined(__SSE2__)
+constexpr bool simdAvailable = true;
+#else
+constexpr bool simdAvailable = false;
+#endif
+
+template <typename K>
+constexpr bool simdSearchable = simdAvailable && std::is_integral_v<K> &&
+                                !std::is_same_v<K, bool> &&
+                                (sizeof(K) == 1 || sizeof(K) == 2 ||
+                                 sizeof(K) == 4 || sizeof(K) == 8);
+
+// 二分收缩到一条缓存行后改为SIMD顺序计数
+template <typename K> constexpr size_t searchWindow() {
+  return 64 / sizeof(K);
+}
+
+// 比较谓词：upper为真时判断 a <= key，否则判断 a < key
+template <bool upper, typename K>
+inline bool rankLess(const K &a, const K &key) {
+  if constexpr (upper) {
+    return !(key < a);
+  } else {
+    return a < key;
+  }
+}
+
+// 原有的顺序扫描(保留作基准)
+template <typename K>
+inline size_t linearUpperBound(const K *keys, size_t n, const K &key) {
+  for (size_t i = 0; i < n; ++i) {
+    if (key < keys[i]) {
+      return i;
+    }
+  }
+  return n;
+}
+
+// 标量无分支计数
+template <bool upper, typename K>
+inline size_t scalarCount(const K *keys, size_t n, const K &key) {
+  size_t count = 0;
+  for (size_t i = 0; i < n; ++i) {
+    count += rankLess<upper>(keys[i], key);
+  }
+  return count;
+}
+
+inline unsigned popCount(unsigned mask) {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned>(__builtin_popcount(mask));
+#else
+  unsigned count = 0;
+  for (; mask; mask &= mask - 1) {
+    ++count;
+  }
+  return count;
+#endif
+}
+
+// SIMD计数：统计满足rankLess的元素个数
+template <bool upper, typename K>
+inline size_t simdCount(const K *keys, size_t n, const K &key) {
+  size_t i = 0;
+  size_t greater = 0; // upper: 统计 > key 的个数
+  size_t less = 0;    // lower: 统计 < key 的个数
+
+  if constexpr (sizeof(K) == 1) {
+    // 每个元素在掩码中占1位
+    const int8_t bias = std::is_signed_v<K> ? 0 : INT8_MIN;
+    const auto probe = static_cast<int8_t>(static_cast<int8_t>(key) ^ bias);
+#if defined(__AVX2__)
+    const __m256i keyVec = _mm256_set1_epi8(probe);
+    const __m256i biasVec = _mm256_set1_epi8(bias);
+    for (; i + 32 <= n; i += 32) {
+      __m256i data = _mm256_xor_si256(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i)),
+          biasVec);
+      __m256i mask = upper ? _mm256_cmpgt_epi8(data, keyVec)
+                           : _mm256_cmpgt_epi8(keyVec, data);
+      auto bits = static_cast<unsigned>(_mm256_movemask_epi8(mask));
+      (upper ? greater : less) += popCount(bits);
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i keyVec16 = _mm_set1_epi8(probe);
+    const __m128i biasVec16 = _mm_set1_epi8(bias);
+    for (; i + 16 <= n; i += 16) {
+      __m128i data = _mm_xor_si128(
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + i)),
+          biasVec16);
+      __m128i mask = upper ? _mm_cmpgt_epi8(data, keyVec16)
+                           : _mm_cmpgt_epi8(keyVec16, data);
+      auto bits = static_cast<unsigned>(_mm_movemask_epi8(mask));
+      (upper ? greater : less) += popCount(bits);
+    }
+#endif
+  } else if constexpr (sizeof(K) == 2) {
+    // 按字节取掩码，每个元素占2位
+    const int16_t bias = std::is_signed_v<K> ? 0 : INT16_MIN;
+    const auto probe = static_cast<int16_t>(static_cast<int16_t>(key) ^ bias);
+#if defined(__AVX2__)
+    const __m256i keyVec = _mm256_set1_epi16(probe);
+    const __m256i biasVec = _mm256_set1_epi16(bias);
+    for (; i + 16 <= n; i += 16) {
+      __m256i data = _mm256_xor_si256(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i)),
+          biasVec);
+      __m256i mask = upper ? _mm256_cmpgt_epi16(data, keyVec)
+                           : _mm256_cmpgt_epi16(keyVec, data);
+      auto bits = static_cast<unsigned>(_mm256_movemask_epi8(mask));
+      (upper ? greater : less) += popCount(bits) / 2;
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i keyVec8 = _mm_set1_epi16(probe);
+    const __m128i biasVec8 = _mm_set1_epi16(bias);
+    for (; i + 8 <= n; i += 8) {
+      __m128i data = _mm_xor_si128(
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + i)),
+          biasVec8);
+      __m128i mask = upper ? _mm_cmpgt_epi16(data, keyVec8)
+                           : _mm_cmpgt_epi16(keyVec8, data);
+      auto bits = static_cast<unsigned>(_mm_movemask_epi8(mask));
+      (upper ? greater : less) += popCount(bits) / 2;
+    }
+#endif
+  } else if constexpr (sizeof(K) == 4) {
+    // 无符号数翻转符号位后按有符号比较
+    const int32_t bias = std::is_signed_v<K> ? 0 : INT32_MIN;
+    const int32_t probe = static_cast<int32_t>(key) ^ bias;
+#if defined(__AVX2__)
+    const __m256i keyVec = _mm256_set1_epi32(probe);
+    const __m256i biasVec = _mm256_set1_epi32(bias);
+    for (; i + 8 <= n; i += 8) {
+      __m256i data = _mm256_xor_si256(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i)),
+          biasVec);
+      __m256i mask = upper ? _mm256_cmpgt_epi32(data, keyVec)
+                           : _mm256_cmpgt_epi32(keyVec, data);
+      unsigned bits = static_cast<unsigned>(
+          _mm256_movemask_ps(_mm256_castsi256_ps(mask)));
+      (upper ? greater : less) += popCount(bits);
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i keyVec4 = _mm_set1_epi32(probe);
+    const __m128i biasVec4 = _mm_set1_epi32(bias);
+    for (; i + 4 <= n; i += 4) {
+      __m128i data = _mm_xor_si128(
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + i)),
+          biasVec4);
+      __m128i mask = upper ? _mm_cmpgt_epi32(data, keyVec4)
+                           : _mm_cmpgt_epi32(keyVec4, data);
+      unsigned bits =
+          static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(mask)));
+      (upper ? greater : less) += popCount(bits);
+    }
+#endif
+  } else {
+    const int64_t bias = std::is_signed_v<K> ? 0 : INT64_MIN;
+    const int64_t probe = static_cast<int64_t>(key) ^ bias;
+    (void)probe; // 仅SSE2时64位比较没有向量指令可用
+#if defined(__AVX2__)
+    const __m256i keyVec = _mm256_set1_epi64x(probe);
+    const __m256i biasVec = _mm256_set1_epi64x(bias);
+    for (; i + 4 <= n; i += 4) {
+      __m256i data = _mm256_xor_si256(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i)),
+          biasVec);
+      __m256i mask = upper ? _mm256_cmpgt_epi64(data, keyVec)
+                           : _mm256_cmpgt_epi64(keyVec, data);
+      unsigned bits = static_cast<unsigned>(
+          _mm256_movemask_pd(_mm256_castsi256_pd(mask)));
+      (upper ? greater : less) += popCount(bits);
+    }
+#endif
+#if defined(__SSE4_2__)
+    const __m128i keyVec2 = _mm_set1_epi64x(probe);
+    const __m128i biasVec2 = _mm_set1_epi64x(bias);
+    for (; i + 2 <= n; i += 2) {
+      __m128i data = _mm_xor_si128(
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + i)),
+          biasVec2);
+      __m128i mask = upper ? _mm_cmpgt_epi64(data, keyVec2)
+                           : _mm_cmpgt_epi64(keyVec2, data);
+      unsigned bits =
+          static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(mask)));
+      (upper ? greater : less) += popCount(bits);
+    }
+#endif
+  }
+
+  // 剩余元素
+  if constexpr (upper) {
+    return (i - greater) + scalarCount<true>(keys + i, n - i, key);
+  } else {
+    return less + scalarCount<false>(keys + i, n - i, key);
+  }
+}
+
+// 无分支二分：收缩到window后对剩余区间顺序计数
+template <bool upper, typename K>
+inline size_t branchlessRank(const K *keys, size_t n, const K &key,
+                             size_t window) {
+  const K *base = keys;
+  size_t len = n;
+  while (len > window) {
+    size_t half = len / 2;
+    base = rankLess<upper>(base[half], key) ? base + half : base;
+    len -= half;
+  }
+  size_t offset = static_cast<size_t>(base - keys);
+  if constexpr (simdSearchable<K>) {
+    return offset + simdCount<upper>(base, len, key);
+  } else {
+    return offset + scalarCount<upper>(base, len, key);
+  }
+}
+
+// key数组从缓存行起点开始时(节点的CacheAligned布局)按行二分：
+// 比较每行的最后一个key选出所在的行，再在这一行内SIMD计数，
+// 每一步只触及一条缓存行(无分支二分的位置与行无关，最后的窗口常跨两行)
+template <bool upper, typename K>
+inline size_t lineRank(const K *keys, size_t n, const K &key) {
+  constexpr size_t perLine = searchWindow<K>();
+  size_t lines = (n + perLine - 1) / perLine;
+  if (lines == 0) {
+    return 0;
+  }
+  // 第j行整行都满足rankLess
+  auto below = [&](size_t j) {
+    return rankLess<upper>(keys[std::min((j + 1) * perLine, n) - 1], key);
+  };
+  size_t base = 0;
+  size_t len = lines;
+  while (len > 1) {
+    size_t half = len / 2;
+    base = below(base + half - 1) ? base + half : base;
+    len -= half;
+  }
+  base += below(base);
+  if (base == lines) {
+    return n;
+  }
+  size_t first = base * perLine;
+  return first + simdCount<upper>(keys + first,
+                                  std::min(perLine, n - first), key);
+}
+
+inline bool lineAligned(const void *p) {
+  return reinterpret_cast<uintptr_t>(p) % 64 == 0;
+}
+
+// 编译期按key类型选择内核
+template <bool upper, typename K>
+inline size_t nodeRank(const K *keys, size_t n, const K &key) {
+  if constexpr (simdSearchable<K>) {
+    if (lineAligned(keys)) {
+      return lineRank<upper>(keys, n, key);
+    }
+    return branchlessRank<upper>(keys, n, key, searchWindow<K>());
+  } else if constexpr (std::is_arithmetic_v<K>) {
+    return branchlessRank<upper>(keys, n, key, 1);
+  } else if constexpr (upper) {
+    return static_cast<size_t>(std::upper_bound(keys, keys + n, key) - keys);
+  } else {
+    return static_cast<size_t>(std::lower_bound(keys, keys + n, key) - keys);
+  }
+}
+
+// 不超过n的最大2的幂
+constexpr size_t bitFloor(size_t n) {
+  size_t p = 1;
+  while (p * 2 <= n) {
+    p *= 2;
+  }
+  return p;
+}
+
+// 节点容量在编译期已知(BplusTree的fanout)：按2的幂步长做无分支二分，
+// 步数只取决于容量，循环可完全展开；步长降到window后对剩余区间计数
+// 每一步之后答案落在 [base, base + step) 内
+template <size_t capacity, bool upper, typename K>
+inline size_t fixedRank(const K *keys, size_t n, const K &key) {
+  constexpr size_t window = simdSearchable<K> ? searchWindow<K>() : 1;
+  constexpr size_t top = bitFloor(capacity);
+  constexpr size_t last = top >= window ? window : 2 * top;
+  size_t base = 0;
+  for (size_t step = top; step >= window && step > 0; step /= 2) {
+    base = base + step <= n && rankLess<upper>(keys[base + step - 1], key)
+               ? base + step
+               : base;
+  }
+  size_t len = std::min(n - base, last - 1);
+  if constexpr (simdSearchable<K>) {
+    return base + simdCount<upper>(keys + base, len, key);
+  } else {
+    return base + scalarCount<upper>(keys + base, len, key);
+  }
+}
+
+// 编译期容量的版本只用于算术类型(按行对齐时同样按行二分)，其余同nodeRank
+template <size_t capacity, bool upper, typename K>
+inline size_t fixedNodeRank(const K *keys, size_t n, const K &key) {
+  if constexpr (std::is_arithmetic_v<K>) {
+    if constexpr (simdSearchable<K>) {
+      if (lineAligned(keys)) {
+        return lineRank<upper>(keys, n, key);
+      }
+    }
+    return fixedRank<capacity, upper>(keys, n, key);
+  } else {
+    return nodeRank<upper>(keys, n, key);
+  }
+}
+
+template <typename K>
+inline size_t nodeLowerBound(const K *keys, size_t n, const K &key) {
+  return nodeRank<false>(keys, n, key);
+}
+
+template <typename K>
+inline size_t nodeUpperBound(const K *keys, size_t n, const K &key) {
+  return nodeRank<true>(keys, n, key);
+}
+
+#endif
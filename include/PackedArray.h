@@ -0,0 +1,778 @@
+#ifndef PACKEDARRAY_H
+#define PACKEDARRAY_H
+
+#include "NodeSearch.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+
+// 整数的节点内压缩存储(frame-of-reference)：元素减去基准值base后按同一宽度
+// (1/2/4/8字节)紧密存放，宽度取能容纳节点内最大差值的最小一档。单调递增的ID
+// 在一个叶子内差值很小，每个元素通常只占1~2字节
+//
+// 压缩叶子中key和value共用一块字节区：key从前往后、value从后往前排列，两者的
+// 宽度各自独立，节点按字节用量(而不是key个数)分裂/合并。插入/改写超出范围的
+// 元素时整体换基准或加宽(原地重新编码)，删除后能变窄时原地变窄
+//
+// 有符号数先翻转符号位映射到无符号数(保持顺序)，差值数组因此按无符号数有序，
+// 节点内定位在差值数组上直接使用NodeSearch.h的1/2/4/8字节SIMD内核
+//
+// 接口与FixedVector的常用子集一致，元素以值返回，可写的下标访问返回代理
+
+// 压缩叶子的key类型：BplusTree<PackedKey<uint64_t>, uint64_t>的叶子按差值压缩
+// 存放(value也须为整数)；可与T互相隐式转换，比较时按T比较
+template <typename T> struct PackedKey {
+  static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>,
+                "PackedKey requires an integer type");
+
+  T value{};
+
+  PackedKey() = default;
+  PackedKey(T value) : value(value) {}
+  operator T() const { return value; }
+
+  friend std::ostream &operator<<(std::ostream &out, const PackedKey &key) {
+    return out << key.value;
+  }
+};
+
+template <typename K> constexpr bool isPackedKey = false;
+template <typename T> constexpr bool isPackedKey<PackedKey<T>> = true;
+
+// 元素对应的整数类型
+template <typename E> struct PackedInteger {
+  using type = E;
+};
+template <typename T> struct PackedInteger<PackedKey<T>> {
+  using type = T;
+};
+
+// 元素与保序的无符号数之间的映射及宽度选择
+template <typename E> struct PackedCodec {
+  using T = typename PackedInteger<E>::type;
+  using U = std::make_unsigned_t<T>;
+  static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>,
+                "PackedArray requires integer elements");
+  static_assert(sizeof(E) == sizeof(T), "PackedKey must wrap a single T");
+
+  static constexpr U SIGN =
+      std::is_signed_v<T> ? static_cast<U>(U(1) << (sizeof(U) * 8 - 1)) : U(0);
+
+  static U toRaw(const E &x) {
+    return static_cast<U>(static_cast<T>(x)) ^ SIGN;
+  }
+  static E fromRaw(U raw) { return E(static_cast<T>(U(raw ^ SIGN))); }
+
+  // 容纳差值range的最小宽度
+  static size_t widthFor(U range) {
+    uint64_t r = range;
+    return r <= 0xFFu ? 1 : r <= 0xFFFFu ? 2 : r <= 0xFFFFFFFFu ? 4 : 8;
+  }
+};
+
+// 一组元素的取值范围：按顺序装填时累计，估算压缩后的字节数
+template <typename E> class PackedRange {
+private:
+  using Codec = PackedCodec<E>;
+  using U = typename Codec::U;
+  U lo = 0, hi = 0;
+  bool empty = true;
+
+public:
+  PackedRange() = default;
+  PackedRange(U lo, U hi) : lo(lo), hi(hi), empty(false) {}
+
+  // 加入x之后的范围
+  PackedRange with(const E &x) const {
+    U raw = Codec::toRaw(x);
+    return empty ? PackedRange(raw, raw)
+                 : PackedRange(std::min(lo, raw), std::max(hi, raw));
+  }
+  PackedRange with(const PackedRange &other) const {
+    if (other.empty || empty) {
+      return empty ? other : *this;
+    }
+    return PackedRange(std::min(lo, other.lo), std::max(hi, other.hi));
+  }
+
+  size_t width() const { return empty ? 1 : Codec::widthFor(U(hi - lo)); }
+
+  // n个元素按该范围编码的字节数
+  size_t bytes(size_t n) const { return n * width(); }
+};
+
+template <typename E> class PackedArray {
+private:
+  using Codec = PackedCodec<E>;
+  using T = typename Codec::T;
+  using U = typename Codec::U;
+
+  char *area;                        // 字节区
+  uint32_t areaBytes;                // 字节区大小
+  uint32_t count;                    // 当前元素个数
+  uint32_t cap;                      // 容量(元素个数)
+  uint32_t used;                     // 已用字节(count * width)
+  const uint32_t *peerUsed = nullptr; // 共用字节区的另一个数组的已用字节
+  bool fromEnd = false;              // 从字节区末尾往前排列
+  uint8_t width = 1;                 // 每个差值的字节数
+  U base = 0;                        // 基准值(不大于任何元素)
+  U lo = 0, hi = 0;                  // 元素的取值范围(只会偏宽)
+
+  // 未加锁读取时宽度可能是撕裂的，归到合法的一档
+  size_t safeWidth() const {
+    size_t w = width;
+    return w <= 1 ? 1 : w <= 2 ? 2 : w <= 4 ? 4 : 8;
+  }
+
+  // 第i个差值的偏移(调用方保证 (i + 1) * w 不超过字节区)
+  size_t offset(size_t i, size_t w) const {
+    return fromEnd ? areaBytes - (i + 1) * w : i * w;
+  }
+
+  static U readDelta(const char *p, size_t w) {
+    switch (w) {
+    case 1:
+      return static_cast<U>(static_cast<uint8_t>(*p));
+    case 2: {
+      uint16_t d;
+      std::memcpy(&d, p, sizeof(d));
+      return static_cast<U>(d);
+    }
+    case 4: {
+      uint32_t d;
+      std::memcpy(&d, p, sizeof(d));
+      return static_cast<U>(d);
+    }
+    default: {
+      uint64_t d;
+      std::memcpy(&d, p, sizeof(d));
+      return static_cast<U>(d);
+    }
+    }
+  }
+  static void writeDelta(char *p, size_t w, U delta) {
+    switch (w) {
+    case 1:
+      *p = static_cast<char>(static_cast<uint8_t>(delta));
+      break;
+    case 2: {
+      auto d = static_cast<uint16_t>(delta);
+      std::memcpy(p, &d, sizeof(d));
+      break;
+    }
+    case 4: {
+      auto d = static_cast<uint32_t>(delta);
+      std::memcpy(p, &d, sizeof(d));
+      break;
+    }
+    default: {
+      auto d = static_cast<uint64_t>(delta);
+      std::memcpy(p, &d, sizeof(d));
+      break;
+    }
+    }
+  }
+
+  U rawAt(size_t i) const {
+    return U(base + readDelta(area + offset(i, width), width));
+  }
+  void setRaw(size_t i, U raw) {
+    writeDelta(area + offset(i, width), width, U(raw - base));
+  }
+
+  size_t peerBytes() const { return peerUsed ? *peerUsed : 0; }
+
+  // 把[first, first + n)整体移到to开始的位置(按当前宽度)
+  void moveBlock(size_t first, size_t n, size_t to) {
+    if (n == 0 || first == to) {
+      return;
+    }
+    size_t w = width;
+    size_t src = fromEnd ? offset(first + n - 1, w) : offset(first, w);
+    size_t dst = fromEnd ? offset(to + n - 1, w) : offset(to, w);
+    std::memmove(area + dst, area + src, n * w);
+  }
+
+  // 按新的基准值和宽度原地重新编码：距起点的位置i * w只增不减(加宽)时
+  // 从后往前，变窄时从前往后，每个差值先读出再写入
+  void recode(U newBase, size_t newWidth) {
+    size_t w = width;
+    if (newWidth >= w) {
+      for (size_t i = count; i-- > 0;) {
+        U raw = U(base + readDelta(area + offset(i, w), w));
+        writeDelta(area + offset(i, newWidth), newWidth, U(raw - newBase));
+      }
+    } else {
+      for (size_t i = 0; i < count; ++i) {
+        U raw = U(base + readDelta(area + offset(i, w), w));
+        writeDelta(area + offset(i, newWidth), newWidth, U(raw - newBase));
+      }
+    }
+    base = newBase;
+    width = static_cast<uint8_t>(newWidth);
+    used = count * width;
+  }
+
+  // 准备容纳取值范围为[newLo, newHi]的n个元素：放不下时抛出异常且不修改，
+  // 否则按需换基准/加宽(基准不变也够用时保留，避免重新编码)
+  void prepare(U newLo, U newHi, size_t n) {
+    size_t newWidth = Codec::widthFor(U(newHi - newLo));
+    if (n > cap || n * newWidth + peerBytes() > areaBytes) {
+      throw std::length_error("PackedArray capacity exceeded");
+    }
+    bool keepBase = count > 0 && base <= newLo &&
+                    Codec::widthFor(U(newHi - base)) == newWidth;
+    if (!keepBase || newWidth != width) {
+      recode(keepBase ? base : newLo, newWidth);
+    }
+    lo = newLo;
+    hi = newHi;
+  }
+
+  // 删除后重新求取值范围，能变窄时原地变窄
+  void shrink() {
+    if (count == 0) {
+      clear();
+      return;
+    }
+    U newLo = rawAt(0), newHi = newLo;
+    for (size_t i = 1; i < count; ++i) {
+      U raw = rawAt(i);
+      newLo = std::min(newLo, raw);
+      newHi = std::max(newHi, raw);
+    }
+    lo = newLo;
+    hi = newHi;
+    size_t newWidth = Codec::widthFor(U(hi - lo));
+    if (newWidth < width) {
+      recode(lo, newWidth);
+    }
+  }
+
+  // 把n个差值(宽度为D)解码到out，按字节区中的顺序
+  template <typename D>
+  static void decodeRun(const char *src, size_t n, U base, E *out) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    // 8/4字节元素：零扩展差值后加基准值、翻转符号位，一次处理一个向量
+    if constexpr ((sizeof(U) == 8 || sizeof(U) == 4) &&
+                  sizeof(D) <= sizeof(U)) {
+      constexpr size_t lanes = 32 / sizeof(U);
+      const __m256i baseVec =
+          sizeof(U) == 8 ? _mm256_set1_epi64x(static_cast<int64_t>(base))
+                         : _mm256_set1_epi32(static_cast<int32_t>(base));
+      const __m256i signVec =
+          sizeof(U) == 8 ? _mm256_set1_epi64x(static_cast<int64_t>(Codec::SIGN))
+                         : _mm256_set1_epi32(static_cast<int32_t>(Codec::SIGN));
+      for (; i + lanes <= n; i += lanes) {
+        const char *p = src + i * sizeof(D);
+        __m256i deltas;
+        if constexpr (sizeof(D) == sizeof(U)) {
+          deltas = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        } else if constexpr (sizeof(D) * lanes == 16) {
+          __m128i packed =
+              _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+          deltas = sizeof(U) == 8 ? _mm256_cvtepu32_epi64(packed)
+                                  : _mm256_cvtepu16_epi32(packed);
+        } else if constexpr (sizeof(D) * lanes == 8) {
+          __m128i packed =
+              _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p));
+          deltas = sizeof(U) == 8 ? _mm256_cvtepu16_epi64(packed)
+                                  : _mm256_cvtepu8_epi32(packed);
+        } else {
+          int32_t word;
+          std::memcpy(&word, p, sizeof(word));
+          deltas = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(word));
+        }
+        __m256i values = sizeof(U) == 8 ? _mm256_add_epi64(deltas, baseVec)
+                                        : _mm256_add_epi32(deltas, baseVec);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i),
+                            _mm256_xor_si256(values, signVec));
+      }
+    }
+#endif
+    for (; i < n; ++i) {
+      D d;
+      std::memcpy(&d, src + i * sizeof(D), sizeof(D));
+      out[i] = Codec::fromRaw(U(base + d));
+    }
+  }
+
+  // 在宽度为D的前n个差值上定位
+  template <bool upper, typename D> size_t rankAs(size_t n, U delta) const {
+    const D *deltas = reinterpret_cast<const D *>(area);
+    return nodeRank<upper>(deltas, n, static_cast<D>(delta));
+  }
+
+  template <bool upper> size_t bound(size_t n, const E &key) const {
+    size_t w = safeWidth();
+    n = std::min<size_t>({n, count, areaBytes / w});
+    U raw = Codec::toRaw(key);
+    U from = base;
+    if (n == 0 || raw < from) {
+      return 0;
+    }
+    uint64_t delta = U(raw - from);
+    uint64_t limit = w == 8 ? ~uint64_t(0) : (uint64_t(1) << (w * 8)) - 1;
+    if (delta > limit) {
+      return n;
+    }
+    switch (w) {
+    case 1:
+      return rankAs<upper, uint8_t>(n, U(delta));
+    case 2:
+      return rankAs<upper, uint16_t>(n, U(delta));
+    case 4:
+      return rankAs<upper, uint32_t>(n, U(delta));
+    default:
+      return rankAs<upper, uint64_t>(n, U(delta));
+    }
+  }
+
+public:
+  // 可写的元素代理
+  class Ref {
+  private:
+    PackedArray *array;
+    size_t index;
+
+  public:
+    Ref(PackedArray *array, size_t index) : array(array), index(index) {}
+
+    operator E() const { return array->get(index); }
+
+    Ref &operator=(const E &x) {
+      array->set(index, x);
+      return *this;
+    }
+    Ref &operator=(const Ref &x) { return *this = static_cast<E>(x); }
+
+    friend bool operator==(const Ref &a, const E &b) {
+      return static_cast<T>(static_cast<E>(a)) == static_cast<T>(b);
+    }
+    friend bool operator==(const E &a, const Ref &b) { return b == a; }
+    friend bool operator==(const Ref &a, const Ref &b) {
+      return a == static_cast<E>(b);
+    }
+    friend bool operator!=(const Ref &a, const E &b) { return !(a == b); }
+    friend bool operator!=(const E &a, const Ref &b) { return !(b == a); }
+    friend bool operator!=(const Ref &a, const Ref &b) { return !(a == b); }
+    friend bool operator<(const Ref &a, const E &b) {
+      return static_cast<T>(static_cast<E>(a)) < static_cast<T>(b);
+    }
+    friend bool operator<(const E &a, const Ref &b) {
+      return static_cast<T>(a) < static_cast<T>(static_cast<E>(b));
+    }
+    friend bool operator<(const Ref &a, const Ref &b) {
+      return a < static_cast<E>(b);
+    }
+    friend bool operator>(const Ref &a, const E &b) { return b < a; }
+    friend bool operator>(const E &a, const Ref &b) { return b < a; }
+    friend bool operator>(const Ref &a, const Ref &b) { return b < a; }
+    friend bool operator<=(const Ref &a, const E &b) { return !(b < a); }
+    friend bool operator<=(const E &a, const Ref &b) { return !(b < a); }
+    friend bool operator<=(const Ref &a, const Ref &b) { return !(b < a); }
+    friend bool operator>=(const Ref &a, const E &b) { return !(a < b); }
+    friend bool operator>=(const E &a, const Ref &b) { return !(a < b); }
+    friend bool operator>=(const Ref &a, const Ref &b) { return !(a < b); }
+    friend std::ostream &operator<<(std::ostream &out, const Ref &x) {
+      return out << static_cast<E>(x);
+    }
+  };
+
+  // 随机访问迭代器(解引用得到值或代理)
+  template <typename Container, typename Reference> class Iterator {
+  private:
+    Container *array = nullptr;
+    size_t index = 0;
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = E;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = Reference;
+
+    Iterator() = default;
+    Iterator(Container *array, size_t index) : array(array), index(index) {}
+    // iterator可转换为const_iterator
+    template <typename C, typename R>
+    Iterator(const Iterator<C, R> &other)
+        : array(other.container()), index(other.position()) {}
+
+    Container *container() const { return array; }
+    size_t position() const { return index; }
+
+    Reference operator*() const { return (*array)[index]; }
+    Reference operator[](difference_type n) const {
+      return (*array)[index + n];
+    }
+
+    Iterator &operator++() {
+      ++index;
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator old = *this;
+      ++index;
+      return old;
+    }
+    Iterator &operator--() {
+      --index;
+      return *this;
+    }
+    Iterator operator--(int) {
+      Iterator old = *this;
+      --index;
+      return old;
+    }
+    Iterator &operator+=(difference_type n) {
+      index += n;
+      return *this;
+    }
+    Iterator &operator-=(difference_type n) {
+      index -= n;
+      return *this;
+    }
+    friend Iterator operator+(Iterator it, difference_type n) {
+      return it += n;
+    }
+    friend Iterator operator+(difference_type n, Iterator it) {
+      return it += n;
+    }
+    friend Iterator operator-(Iterator it, difference_type n) {
+      return it -= n;
+    }
+    friend difference_type operator-(const Iterator &a, const Iterator &b) {
+      return static_cast<difference_type>(a.index) -
+             static_cast<difference_type>(b.index);
+    }
+    friend bool operator==(const Iterator &a, const Iterator &b) {
+      return a.index == b.index;
+    }
+    friend bool operator!=(const Iterator &a, const Iterator &b) {
+      return a.index != b.index;
+    }
+    friend bool operator<(const Iterator &a, const Iterator &b) {
+      return a.index < b.index;
+    }
+    friend bool operator>(const Iterator &a, const Iterator &b) {
+      return a.index > b.index;
+    }
+    friend bool operator<=(const Iterator &a, const Iterator &b) {
+      return a.index <= b.index;
+    }
+    friend bool operator>=(const Iterator &a, const Iterator &b) {
+      return a.index >= b.index;
+    }
+  };
+
+  // 持久化头：[基准值 u64][宽度 u8][填充]
+  static constexpr size_t HEADER_BYTES = 16;
+
+  using value_type = E;
+  using iterator = Iterator<PackedArray, Ref>;
+  using const_iterator = Iterator<const PackedArray, E>;
+
+  // 独占字节区：storage开始的bytes字节，最多capacity个元素
+  PackedArray(void *storage, size_t bytes, size_t capacity)
+      : area(static_cast<char *>(storage)),
+        areaBytes(static_cast<uint32_t>(bytes)), count(0),
+        cap(static_cast<uint32_t>(capacity)), used(0) {}
+
+  PackedArray(const PackedArray &) = delete;
+  PackedArray &operator=(const PackedArray &) = delete;
+
+  // 两个空数组改为共用storage开始的bytes字节：front从前往后、back从后往前，
+  // 各自最多bytes / 2个元素(每个元素至少1字节)
+  template <typename Other>
+  static void share(PackedArray &front, PackedArray<Other> &back, void *storage,
+                    size_t bytes) {
+    front.bind(storage, bytes, bytes / 2, false, &back.used);
+    back.bind(storage, bytes, bytes / 2, true, &front.used);
+  }
+
+  size_t size() const { return count; }
+  size_t capacity() const { return cap; }
+  bool empty() const { return count == 0; }
+
+  // 差值宽度、已用字节、字节区大小
+  size_t elementWidth() const { return width; }
+  size_t bytes() const { return used; }
+  size_t areaSize() const { return areaBytes; }
+
+  // 取值范围
+  PackedRange<E> range() const {
+    return count == 0 ? PackedRange<E>() : PackedRange<E>(lo, hi);
+  }
+
+  // 放入x后共n个元素时本数组占用的字节数
+  size_t bytesWith(const E &x, size_t n) const {
+    return range().with(x).bytes(n);
+  }
+
+  // 并入other的全部元素后占用的字节数
+  size_t bytesWith(const PackedArray &other) const {
+    return range().with(other.range()).bytes(count + other.count);
+  }
+
+  // 第i个元素(未加锁读取时越界的下标返回基准值，不越出字节区)
+  E get(size_t i) const {
+    size_t w = safeWidth();
+    if ((i + 1) * w > areaBytes) {
+      return Codec::fromRaw(base);
+    }
+    return Codec::fromRaw(U(base + readDelta(area + offset(i, w), w)));
+  }
+
+  // 第i个元素所在的地址(供预取)
+  const void *address(size_t i) const {
+    size_t w = safeWidth();
+    return (i + 1) * w > areaBytes ? area : area + offset(i, w);
+  }
+
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, count); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, count); }
+
+  Ref operator[](size_t i) { return Ref(this, i); }
+  E operator[](size_t i) const { return get(i); }
+
+  Ref front() { return Ref(this, 0); }
+  E front() const { return get(0); }
+  Ref back() { return Ref(this, count - 1); }
+  E back() const { return get(count - 1); }
+
+  // 改写第i个元素(超出当前宽度时整体重新编码)
+  void set(size_t i, const E &x) {
+    U raw = Codec::toRaw(x);
+    if (raw < lo || raw > hi) {
+      prepare(std::min(lo, raw), std::max(hi, raw), count);
+    }
+    setRaw(i, raw);
+  }
+
+  void push_back(const E &x) { insert(end(), x); }
+
+  void pop_back() { erase(end() - 1); }
+
+  void clear() {
+    count = 0;
+    used = 0;
+    width = 1;
+    base = lo = hi = 0;
+  }
+
+  // 缩短时丢弃末尾的元素，增长时补默认值
+  void resize(size_t n) {
+    if (n <= count) {
+      erase(begin() + n, end());
+      return;
+    }
+    E zero{};
+    size_t extra = n - count;
+    for (size_t i = 0; i < extra; ++i) {
+      push_back(zero);
+    }
+  }
+
+  // 在pos处插入单个元素
+  iterator insert(const_iterator pos, const E &x) {
+    size_t index = pos.position();
+    U raw = Codec::toRaw(x);
+    if (count == 0) {
+      prepare(raw, raw, 1);
+    } else {
+      prepare(std::min(lo, raw), std::max(hi, raw), count + 1);
+    }
+    moveBlock(index, count - index, index + 1);
+    ++count;
+    used = count * width;
+    setRaw(index, raw);
+    return iterator(this, index);
+  }
+
+  // 在pos处插入区间[first, last)(区间不得来自本容器)
+  template <typename InputIt>
+  iterator insert(const_iterator pos, InputIt first, InputIt last) {
+    size_t index = pos.position();
+    size_t n = static_cast<size_t>(std::distance(first, last));
+    if (n == 0) {
+      return iterator(this, index);
+    }
+    U newLo = Codec::toRaw(static_cast<E>(*first));
+    U newHi = newLo;
+    for (InputIt it = first; it != last; ++it) {
+      U raw = Codec::toRaw(static_cast<E>(*it));
+      newLo = std::min(newLo, raw);
+      newHi = std::max(newHi, raw);
+    }
+    if (count > 0) {
+      newLo = std::min(newLo, lo);
+      newHi = std::max(newHi, hi);
+    }
+    prepare(newLo, newHi, count + n);
+    moveBlock(index, count - index, index + n);
+    count += static_cast<uint32_t>(n);
+    used = count * width;
+    for (size_t i = index; first != last; ++first, ++i) {
+      setRaw(i, Codec::toRaw(static_cast<E>(*first)));
+    }
+    return iterator(this, index);
+  }
+
+  template <typename InputIt> void assign(InputIt first, InputIt last) {
+    clear();
+    insert(end(), first, last);
+  }
+
+  iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    size_t index = first.position();
+    size_t n = last.position() - index;
+    if (n == 0) {
+      return iterator(this, index);
+    }
+    // 删掉了取值范围的端点时才需要重新求范围
+    bool extreme = false;
+    for (size_t i = index; i < index + n && !extreme; ++i) {
+      U raw = rawAt(i);
+      extreme = raw == lo || raw == hi;
+    }
+    moveBlock(index + n, count - index - n, index);
+    count -= static_cast<uint32_t>(n);
+    used = count * width;
+    if (extreme || count == 0) {
+      shrink();
+    }
+    return iterator(this, index);
+  }
+
+  // 节点内定位：前n个元素中第一个 >= key / > key 的下标
+  // (只用于从前往后排列的key；未加锁读取时n和宽度按字节区截断)
+  size_t lowerBound(size_t n, const E &key) const {
+    return bound<false>(n, key);
+  }
+  size_t upperBound(size_t n, const E &key) const {
+    return bound<true>(n, key);
+  }
+
+  // 批量解码[first, first + n)到out(按下标顺序)，返回解码的个数
+  // 每种宽度一个内核，8/4字节元素在AVX2下按向量解码
+  size_t decode(size_t first, size_t n, E *out) const {
+    size_t w = safeWidth();
+    size_t limit = std::min<size_t>(count, areaBytes / w);
+    if (first >= limit) {
+      return 0;
+    }
+    n = std::min(n, limit - first);
+    if (n == 0) {
+      return 0;
+    }
+    const char *src =
+        area + (fromEnd ? offset(first + n - 1, w) : offset(first, w));
+    U from = base;
+    switch (w) {
+    case 1:
+      decodeRun<uint8_t>(src, n, from, out);
+      break;
+    case 2:
+      decodeRun<uint16_t>(src, n, from, out);
+      break;
+    case 4:
+      decodeRun<uint32_t>(src, n, from, out);
+      break;
+    default:
+      decodeRun<uint64_t>(src, n, from, out);
+      break;
+    }
+    // 从后往前排列的数组在字节区中是逆序的
+    if (fromEnd) {
+      std::reverse(out, out + n);
+    }
+    return n;
+  }
+
+  // 持久化：[基准值 u64][宽度 u8][填充][差值 x count](按下标顺序)
+  size_t storedBytes() const { return HEADER_BYTES + used; }
+  void store(char *dst) const {
+    uint64_t from = base;
+    std::memset(dst, 0, HEADER_BYTES);
+    std::memcpy(dst, &from, sizeof(from));
+    dst[sizeof(from)] = static_cast<char>(width);
+    char *out = dst + HEADER_BYTES;
+    if (!fromEnd) {
+      std::memcpy(out, area, used);
+      return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+      std::memcpy(out + i * width, area + offset(i, width), width);
+    }
+  }
+
+  // 检查src处n个元素的持久化内容(最多limit字节)，合法时返回其字节数，
+  // 否则返回0；width返回差值宽度
+  static size_t measure(const char *src, size_t n, size_t limit,
+                        size_t &width) {
+    if (limit < HEADER_BYTES) {
+      return 0;
+    }
+    uint64_t from;
+    std::memcpy(&from, src, sizeof(from));
+    width = static_cast<uint8_t>(src[sizeof(from)]);
+    bool valid = (width == 1 || width == 2 || width == 4 || width == 8) &&
+                 width <= sizeof(U) && from == static_cast<U>(from) &&
+                 n <= (limit - HEADER_BYTES) / width;
+    return valid ? HEADER_BYTES + n * width : 0;
+  }
+
+  // 读入已检查过的n个元素；放不下时抛出异常
+  void load(const char *src, size_t n) {
+    size_t w;
+    if (measure(src, n, HEADER_BYTES + n * 8, w) == 0 || n > cap ||
+        n * w + peerBytes() > areaBytes) {
+      throw std::length_error("PackedArray capacity exceeded");
+    }
+    clear();
+    uint64_t from;
+    std::memcpy(&from, src, sizeof(from));
+    base = static_cast<U>(from);
+    width = static_cast<uint8_t>(w);
+    count = static_cast<uint32_t>(n);
+    used = count * width;
+    const char *in = src + HEADER_BYTES;
+    for (size_t i = 0; i < n; ++i) {
+      std::memcpy(area + offset(i, w), in + i * w, w);
+    }
+    if (n > 0) {
+      lo = hi = rawAt(0);
+      for (size_t i = 1; i < n; ++i) {
+        U raw = rawAt(i);
+        lo = std::min(lo, raw);
+        hi = std::max(hi, raw);
+      }
+    }
+  }
+
+private:
+  template <typename Other> friend class PackedArray;
+
+  void bind(void *storage, size_t bytes, size_t capacity, bool reversed,
+            const uint32_t *peer) {
+    area = static_cast<char *>(storage);
+    areaBytes = static_cast<uint32_t>(bytes);
+    cap = static_cast<uint32_t>(capacity);
+    fromEnd = reversed;
+    peerUsed = peer;
+    clear();
+  }
+};
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef PAGEFILE_H
+#define PAGEFILE_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// 页号：页在数据文件中的编号，文件开头是文件头页，节点页号从不为0
+using PageId = uint32_t;
+constexpr PageId HEADER_PAGE = 0;
+constexpr PageId NULL_PAGE = 0;
+
+// 定长页组成的数据文件：第id页位于偏移 id * pageSize
+// 只负责按页读写，缓存和回写策略由BufferPool决定
+//
+// 并发约定：read/write基于pread/pwrite，不同页之间可以并发；
+// allocate由调用方串行化
+class PageFile {
+private:
+  int fd;
+  size_t pageBytes;
+  PageId pages; // 文件中的页数(含未写入的已分配页)
+  std::string path;
+
+  [[noreturn]] void fail(const std::string &what) const {
+    throw std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+  }
+
+public:
+  // create为true时新建(或清空)文件，否则打开已有文件
+  PageFile(const std::string &path, size_t pageBytes, bool create)
+      : fd(-1), pageBytes(pageBytes), pages(0), path(path) {
+    int flags = O_RDWR | (create ? O_CREAT | O_TRUNC : 0);
+    fd = ::open(path.c_str(), flags, 0644);
+    if (fd < 0) {
+      fail("Failed to open page file");
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      ::close(fd);
+      fail("Failed to stat page file");
+    }
+    pages = static_cast<PageId>((static_cast<uint64_t>(st.st_size) +
+                                 pageBytes - 1) /
+                                pageBytes);
+  }
+
+  ~PageFile() {
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+
+  PageFile(const PageFile &) = delete;
+  PageFile &operator=(const PageFile &) = delete;
+
+  size_t pageSize() const { return pageBytes; }
+  PageId pageCount() const { return pages; }
+
+  // 在文件末尾分配一个新页(内容在第一次写入前未定义)
+  PageId allocate() { return pages++; }
+
+  // 读取一页；文件末尾之后未写入的部分读作0
+  void read(PageId id, char *buffer) const {
+    off_t offset = static_cast<off_t>(id) * static_cast<off_t>(pageBytes);
+    size_t done = 0;
+    while (done < pageBytes) {
+      ssize_t n = ::pread(fd, buffer + done, pageBytes - done,
+                          offset + static_cast<off_t>(done));
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        fail("Failed to read page " + std::to_string(id) + " of");
+      }
+      if (n == 0) {
+        std::memset(buffer + done, 0, pageBytes - done);
+        break;
+      }
+      done += static_cast<size_t>(n);
+    }
+  }
+
+  // 从第id页开始写入连续的count页
+  void write(PageId id, const char *buffer, size_t count = 1) {
+    off_t offset = static_cast<off_t>(id) * static_cast<off_t>(pageBytes);
+    size_t bytes = count * pageBytes;
+    size_t done = 0;
+    while (done < bytes) {
+      ssize_t n = ::pwrite(fd, buffer + done, bytes - done,
+                           offset + static_cast<off_t>(done));
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        fail("Failed to write page " + std::to_string(id) + " of");
+      }
+      done += static_cast<size_t>(n);
+    }
+    if (id + count > pages) {
+      pages = static_cast<PageId>(id + count);
+    }
+  }
+
+  // 刷盘
+  void sync() {
+    if (::fsync(fd) != 0) {
+      fail("Failed to sync page file");
+    }
+  }
+};
+
+// 刷盘path所在目录：rename换入的文件在目录项落盘后才能保证崩溃后仍可见
+inline void syncParentDirectory(const std::string &path) {
+  size_t slash = path.find_last_of('/');
+  std::string dir = slash == std::string::npos ? "."
+                    : slash == 0               ? "/"
+                                               : path.substr(0, slash);
+  int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+  if (fd < 0) {
+    throw std::runtime_error("Failed to open directory " + dir + ": " +
+                             std::strerror(errno));
+  }
+  if (::fsync(fd) != 0) {
+    int error = errno;
+    ::close(fd);
+    throw std::runtime_error("Failed to sync directory " + dir + ": " +
+                             std::strerror(error));
+  }
+  ::close(fd);
+}
+
+#endif
@@ -0,0 +1,680 @@
+#ifndef SLOTTEDKEYS_H
+#define SLOTTEDKEYS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+// 变长key(std::string)的节点内存储：槽位页布局加前缀压缩
+// 存储区为 [offsets x (capacity + 1)][key字节区]。字节区开头是节点内所有key
+// 的公共前缀(只存一份)，其后按顺序紧密排列各key去掉前缀后的后缀：第i个后缀
+// 占前缀之后的[offsets[i], offsets[i + 1])；每个key不超过keyBytes字节，字节区
+// 按capacity * keyBytes预留，节点按key个数分裂/合并即可保证放得下
+// 查找时先与公共前缀比较一次，二分只对后缀做memcmp，不为每个key单独分配内存
+//
+// 插入不以公共前缀开头的key时前缀缩短(让出的字节补回每个后缀前面)；删除和
+// 整体替换后重新求最长的公共前缀，改写单个key只会让前缀缩短
+//
+// 接口与FixedVector的常用子集一致，元素以代理返回：KeyView是只读的字节区
+// 引用(公共前缀和后缀两段)，KeyRef额外记录下标，赋值时改写该位置的key；
+// 两者都可以隐式转换为std::string，插入/删除后失效(与迭代器相同)
+
+// 按字节比较(与std::string的顺序一致)
+inline int compareKeyBytes(const char *a, size_t aLength, const char *b,
+                           size_t bLength) {
+  int order = std::memcmp(a, b, std::min(aLength, bLength));
+  if (order != 0) {
+    return order;
+  }
+  return aLength < bLength ? -1 : aLength > bLength ? 1 : 0;
+}
+
+class KeyView {
+protected:
+  const char *head = nullptr; // 第一段(节点内的公共前缀)
+  size_t headLength = 0;
+  const char *tail = nullptr; // 第二段
+  size_t tailLength = 0;
+
+  // 第pos个字节的位置，rest返回所在段从它开始的剩余字节数
+  const char *at(size_t pos, size_t &rest) const {
+    if (pos < headLength) {
+      rest = headLength - pos;
+      return head + pos;
+    }
+    rest = tailLength - (pos - headLength);
+    return tail + (pos - headLength);
+  }
+
+public:
+  KeyView() = default;
+  KeyView(const char *ptr, size_t length) : tail(ptr), tailLength(length) {}
+  KeyView(const char *head, size_t headLength, const char *tail,
+          size_t tailLength)
+      : head(head), headLength(headLength), tail(tail),
+        tailLength(tailLength) {}
+  KeyView(const std::string &key) : tail(key.data()), tailLength(key.size()) {}
+
+  size_t size() const { return headLength + tailLength; }
+
+  // 字节是否连续存放(只有一段非空)，连续时data()指向第一个字节
+  bool contiguous() const { return headLength == 0 || tailLength == 0; }
+  const char *data() const { return headLength > 0 ? head : tail; }
+
+  // 任一段落在[begin, end)内
+  bool within(const char *begin, const char *end) const {
+    return (headLength > 0 && head >= begin && head < end) ||
+           (tailLength > 0 && tail >= begin && tail < end);
+  }
+
+  // 把[pos, pos + n)复制到dst
+  void copy(char *dst, size_t pos, size_t n) const {
+    if (pos < headLength) {
+      size_t part = std::min(n, headLength - pos);
+      std::memcpy(dst, head + pos, part);
+      dst += part;
+      pos += part;
+      n -= part;
+    }
+    if (n > 0) {
+      std::memcpy(dst, tail + (pos - headLength), n);
+    }
+  }
+
+  operator std::string() const {
+    std::string key(size(), '\0');
+    copy(&key[0], 0, key.size());
+    return key;
+  }
+
+  // 公共前缀的字节数
+  friend size_t commonPrefix(const KeyView &a, const KeyView &b) {
+    size_t n = std::min(a.size(), b.size());
+    for (size_t pos = 0; pos < n;) {
+      size_t aRest, bRest;
+      const char *p = a.at(pos, aRest);
+      const char *q = b.at(pos, bRest);
+      size_t part = std::min({aRest, bRest, n - pos});
+      auto same = static_cast<size_t>(std::mismatch(p, p + part, q).first - p);
+      if (same < part) {
+        return pos + same;
+      }
+      pos += part;
+    }
+    return n;
+  }
+
+  friend int compare(const KeyView &a, const KeyView &b) {
+    if (a.contiguous() && b.contiguous()) {
+      return compareKeyBytes(a.data(), a.size(), b.data(), b.size());
+    }
+    size_t same = commonPrefix(a, b);
+    if (same < a.size() && same < b.size()) {
+      size_t rest;
+      auto x = static_cast<unsigned char>(*a.at(same, rest));
+      auto y = static_cast<unsigned char>(*b.at(same, rest));
+      return x < y ? -1 : 1;
+    }
+    return a.size() < b.size() ? -1 : a.size() > b.size() ? 1 : 0;
+  }
+  friend bool operator==(const KeyView &a, const KeyView &b) {
+    return a.size() == b.size() && commonPrefix(a, b) == a.size();
+  }
+  friend bool operator!=(const KeyView &a, const KeyView &b) {
+    return !(a == b);
+  }
+  friend bool operator<(const KeyView &a, const KeyView &b) {
+    return compare(a, b) < 0;
+  }
+  friend bool operator>(const KeyView &a, const KeyView &b) { return b < a; }
+  friend bool operator<=(const KeyView &a, const KeyView &b) {
+    return !(b < a);
+  }
+  friend bool operator>=(const KeyView &a, const KeyView &b) {
+    return !(a < b);
+  }
+  friend std::ostream &operator<<(std::ostream &out, const KeyView &key) {
+    out.write(key.head, static_cast<std::streamsize>(key.headLength));
+    return out.write(key.tail, static_cast<std::streamsize>(key.tailLength));
+  }
+};
+
+class SlottedKeys {
+private:
+  uint32_t *offsets;     // capacity + 1 项，offsets[count]为后缀的总字节数
+  char *bytes;           // key字节区：[公共前缀][后缀...]
+  uint32_t count;        // 当前key个数
+  uint32_t cap;          // 容量(key个数)
+  uint32_t keyBytes;     // 单个key的最大字节数
+  uint32_t prefixLength; // 公共前缀的字节数
+
+  size_t byteCapacity() const { return static_cast<size_t>(cap) * keyBytes; }
+  size_t usedBytes() const { return prefixLength + offsets[count]; }
+  char *suffixes() { return bytes + prefixLength; }
+  const char *suffixes() const { return bytes + prefixLength; }
+  size_t suffixLength(size_t i) const { return offsets[i + 1] - offsets[i]; }
+
+  // 公共前缀缩短为length字节后字节区的用量
+  size_t usedAfterShrink(size_t length) const {
+    return count == 0 ? 0
+                      : usedBytes() + (count - 1) * (prefixLength - length);
+  }
+
+  // 修改后共n个key、字节区共用used字节
+  void checkCapacity(size_t n, size_t used) const {
+    if (n > cap || used > byteCapacity()) {
+      throw std::length_error("SlottedKeys capacity exceeded");
+    }
+  }
+  void checkKey(size_t keyLength) const {
+    if (keyLength > keyBytes) {
+      throw std::length_error("Key longer than " + std::to_string(keyBytes) +
+                              " bytes");
+    }
+  }
+
+  // 从index起的后缀后移n个位置/shift字节，空出的位置由调用方填写
+  void openGap(size_t index, size_t n, size_t shift) {
+    char *area = suffixes();
+    size_t start = offsets[index];
+    std::memmove(area + start + shift, area + start, offsets[count] - start);
+    for (size_t i = count + 1; i-- > index;) {
+      offsets[i + n] = static_cast<uint32_t>(offsets[i] + shift);
+    }
+    count += static_cast<uint32_t>(n);
+  }
+
+  // 删除[index, index + n)的key
+  void closeGap(size_t index, size_t n) {
+    char *area = suffixes();
+    size_t start = offsets[index];
+    size_t shift = offsets[index + n] - start;
+    std::memmove(area + start, area + start + shift,
+                 offsets[count] - start - shift);
+    for (size_t i = index + n; i <= count; ++i) {
+      offsets[i - n] = static_cast<uint32_t>(offsets[i] - shift);
+    }
+    count -= static_cast<uint32_t>(n);
+  }
+
+  // 公共前缀缩短为length字节：让出的字节补到每个后缀前面，
+  // 从后往前移动，第i个后缀右移i * delta字节(第0个不动)
+  // 调用方先用usedAfterShrink检查容量
+  void shrinkPrefix(size_t length) {
+    size_t delta = prefixLength - length;
+    if (delta == 0) {
+      return;
+    }
+    for (size_t i = count; i-- > 1;) {
+      size_t from = prefixLength + offsets[i];
+      size_t to = from + i * delta;
+      std::memmove(bytes + to, bytes + from, suffixLength(i));
+      std::memcpy(bytes + to - delta, bytes + length, delta);
+    }
+    for (size_t i = 1; i <= count; ++i) {
+      offsets[i] = static_cast<uint32_t>(offsets[i] + i * delta);
+    }
+    prefixLength = static_cast<uint32_t>(length);
+  }
+
+  // 删除后重新求最长的公共前缀：所有后缀共同的开头移入前缀，
+  // 从前往后移动，第i个后缀左移i * grow字节(第0个的开头原地成为前缀)
+  void growPrefix() {
+    if (count == 0) {
+      prefixLength = 0;
+      offsets[0] = 0;
+      return;
+    }
+    const char *area = suffixes();
+    size_t grow = suffixLength(0);
+    for (size_t i = 1; i < count && grow > 0; ++i) {
+      size_t n = std::min(grow, suffixLength(i));
+      grow = static_cast<size_t>(
+          std::mismatch(area, area + n, area + offsets[i]).first - area);
+    }
+    if (grow == 0) {
+      return;
+    }
+    for (size_t i = 1; i < count; ++i) {
+      size_t from = prefixLength + offsets[i] + grow;
+      std::memmove(bytes + from - i * grow, bytes + from,
+                   suffixLength(i) - grow);
+    }
+    for (size_t i = 1; i <= count; ++i) {
+      offsets[i] = static_cast<uint32_t>(offsets[i] - i * grow);
+    }
+    prefixLength = static_cast<uint32_t>(prefixLength + grow);
+  }
+
+  KeyView prefix() const { return KeyView(bytes, prefixLength); }
+
+  // 来源可能是本容器的字节区(会被移动)，先复制出来
+  bool aliases(const KeyView &key) const {
+    return key.within(bytes, bytes + byteCapacity());
+  }
+
+public:
+  // 可写的元素代理
+  class KeyRef : public KeyView {
+  private:
+    SlottedKeys *keys;
+    size_t index;
+
+  public:
+    KeyRef(SlottedKeys *keys, size_t index)
+        : KeyView(keys->view(index)), keys(keys), index(index) {}
+
+    KeyRef &operator=(const KeyView &key) {
+      keys->set(index, key);
+      static_cast<KeyView &>(*this) = keys->view(index);
+      return *this;
+    }
+    KeyRef &operator=(const KeyRef &key) {
+      return *this = static_cast<const KeyView &>(key);
+    }
+    KeyRef &operator=(const std::string &key) { return *this = KeyView(key); }
+  };
+
+  // 随机访问迭代器(解引用得到代理)
+  template <typename Container, typename Reference> class Iterator {
+  private:
+    Container *keys = nullptr;
+    size_t index = 0;
+    friend class SlottedKeys;
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::string;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = Reference;
+
+    Iterator() = default;
+    Iterator(Container *keys, size_t index) : keys(keys), index(index) {}
+    // iterator可转换为const_iterator
+    template <typename C, typename R>
+    Iterator(const Iterator<C, R> &other)
+        : keys(other.container()), index(other.position()) {}
+
+    Container *container() const { return keys; }
+    size_t position() const { return index; }
+
+    Reference operator*() const { return (*keys)[index]; }
+    Reference operator[](difference_type n) const {
+      return (*keys)[index + n];
+    }
+
+    Iterator &operator++() {
+      ++index;
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator old = *this;
+      ++index;
+      return old;
+    }
+    Iterator &operator--() {
+      --index;
+      return *this;
+    }
+    Iterator operator--(int) {
+      Iterator old = *this;
+      --index;
+      return old;
+    }
+    Iterator &operator+=(difference_type n) {
+      index += n;
+      return *this;
+    }
+    Iterator &operator-=(difference_type n) {
+      index -= n;
+      return *this;
+    }
+    friend Iterator operator+(Iterator it, difference_type n) {
+      return it += n;
+    }
+    friend Iterator operator+(difference_type n, Iterator it) {
+      return it += n;
+    }
+    friend Iterator operator-(Iterator it, difference_type n) {
+      return it -= n;
+    }
+    friend difference_type operator-(const Iterator &a, const Iterator &b) {
+      return static_cast<difference_type>(a.index) -
+             static_cast<difference_type>(b.index);
+    }
+    friend bool operator==(const Iterator &a, const Iterator &b) {
+      return a.index == b.index;
+    }
+    friend bool operator!=(const Iterator &a, const Iterator &b) {
+      return a.index != b.index;
+    }
+    friend bool operator<(const Iterator &a, const Iterator &b) {
+      return a.index < b.index;
+    }
+    friend bool operator>(const Iterator &a, const Iterator &b) {
+      return a.index > b.index;
+    }
+    friend bool operator<=(const Iterator &a, const Iterator &b) {
+      return a.index <= b.index;
+    }
+    friend bool operator>=(const Iterator &a, const Iterator &b) {
+      return a.index >= b.index;
+    }
+  };
+
+  using value_type = std::string;
+  using iterator = Iterator<SlottedKeys, KeyRef>;
+  using const_iterator = Iterator<const SlottedKeys, KeyView>;
+
+  // 存储区字节数
+  static size_t storageBytes(size_t capacity, size_t keyBytes) {
+    return (capacity + 1) * sizeof(uint32_t) + capacity * keyBytes;
+  }
+
+  SlottedKeys(void *storage, size_t capacity, size_t keyBytes)
+      : offsets(static_cast<uint32_t *>(storage)),
+        bytes(static_cast<char *>(storage) +
+              (capacity + 1) * sizeof(uint32_t)),
+        count(0), cap(static_cast<uint32_t>(capacity)),
+        keyBytes(static_cast<uint32_t>(keyBytes)), prefixLength(0) {
+    offsets[0] = 0;
+  }
+
+  SlottedKeys(const SlottedKeys &) = delete;
+  SlottedKeys &operator=(const SlottedKeys &) = delete;
+
+  size_t size() const { return count; }
+  size_t capacity() const { return cap; }
+  bool empty() const { return count == 0; }
+
+  // 第i个key
+  KeyView view(size_t i) const {
+    return KeyView(bytes, prefixLength, suffixes() + offsets[i],
+                   suffixLength(i));
+  }
+
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, count); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, count); }
+
+  KeyRef operator[](size_t i) { return KeyRef(this, i); }
+  KeyView operator[](size_t i) const { return view(i); }
+
+  KeyRef front() { return KeyRef(this, 0); }
+  KeyView front() const { return view(0); }
+  KeyRef back() { return KeyRef(this, count - 1); }
+  KeyView back() const { return view(count - 1); }
+
+  // 改写第i个key，其后的后缀整体移动
+  void set(size_t i, const KeyView &key) {
+    checkKey(key.size());
+    if (aliases(key)) {
+      set(i, KeyView(std::string(key)));
+      return;
+    }
+    size_t keep = std::min<size_t>(prefixLength, commonPrefix(prefix(), key));
+    size_t delta = prefixLength - keep;
+    size_t oldLength = suffixLength(i) + delta;
+    size_t newLength = key.size() - keep;
+    checkCapacity(count, usedAfterShrink(keep) + newLength - oldLength);
+    shrinkPrefix(keep);
+
+    char *area = suffixes();
+    size_t tail = offsets[i + 1];
+    std::memmove(area + offsets[i] + newLength, area + tail,
+                 offsets[count] - tail);
+    for (size_t j = i + 1; j <= count; ++j) {
+      offsets[j] = static_cast<uint32_t>(offsets[j] - oldLength + newLength);
+    }
+    key.copy(area + offsets[i], keep, newLength);
+  }
+
+  void push_back(const KeyView &key) { insert(end(), key); }
+
+  void pop_back() {
+    --count;
+    growPrefix();
+  }
+
+  void clear() {
+    count = 0;
+    prefixLength = 0;
+    offsets[0] = 0;
+  }
+
+  // 缩短时丢弃末尾的key，增长时补空key(公共前缀随之清空)
+  void resize(size_t n) {
+    if (n <= count) {
+      count = static_cast<uint32_t>(n);
+      growPrefix();
+      return;
+    }
+    checkCapacity(n, usedAfterShrink(0));
+    shrinkPrefix(0);
+    for (size_t i = count; i < n; ++i) {
+      offsets[i + 1] = offsets[count];
+    }
+    count = static_cast<uint32_t>(n);
+  }
+
+  // 在pos处插入单个key
+  iterator insert(const_iterator pos, const KeyView &key) {
+    checkKey(key.size());
+    if (aliases(key)) {
+      return insert(pos, KeyView(std::string(key)));
+    }
+    size_t index = pos.position();
+    if (count == 0) {
+      // 唯一的key整个作为公共前缀
+      checkCapacity(1, key.size());
+      key.copy(bytes, 0, key.size());
+      prefixLength = static_cast<uint32_t>(key.size());
+      offsets[1] = 0;
+      count = 1;
+      return iterator(this, index);
+    }
+    size_t keep = std::min<size_t>(prefixLength, commonPrefix(prefix(), key));
+    size_t length = key.size() - keep;
+    checkCapacity(count + 1, usedAfterShrink(keep) + length);
+    shrinkPrefix(keep);
+    openGap(index, 1, length);
+    offsets[index + 1] = static_cast<uint32_t>(offsets[index] + length);
+    key.copy(suffixes() + offsets[index], keep, length);
+    return iterator(this, index);
+  }
+
+  // 在pos处插入区间[first, last)(区间不得来自本容器)
+  template <typename InputIt>
+  iterator insert(const_iterator pos, InputIt first, InputIt last) {
+    size_t index = pos.position();
+    size_t n = static_cast<size_t>(std::distance(first, last));
+    if (n == 0) {
+      return iterator(this, index);
+    }
+
+    // 新的公共前缀：原有前缀(空容器时为第一个key)与区间内各key的公共前缀
+    KeyView base = count > 0 ? prefix() : KeyView(*first);
+    size_t keep = base.size();
+    size_t total = 0;
+    for (InputIt it = first; it != last; ++it) {
+      KeyView key = *it;
+      checkKey(key.size());
+      keep = std::min(keep, commonPrefix(base, key));
+      total += key.size();
+    }
+    size_t added = total - n * keep;
+    if (count == 0) {
+      checkCapacity(n, keep + added);
+      base.copy(bytes, 0, keep);
+      prefixLength = static_cast<uint32_t>(keep);
+    } else {
+      checkCapacity(count + n, usedAfterShrink(keep) + added);
+      shrinkPrefix(keep);
+    }
+
+    openGap(index, n, added);
+    char *area = suffixes();
+    size_t offset = offsets[index];
+    for (size_t i = index; first != last; ++first, ++i) {
+      KeyView key = *first;
+      offsets[i] = static_cast<uint32_t>(offset);
+      key.copy(area + offset, keep, key.size() - keep);
+      offset += key.size() - keep;
+    }
+    return iterator(this, index);
+  }
+
+  template <typename InputIt> void assign(InputIt first, InputIt last) {
+    clear();
+    insert(end(), first, last);
+  }
+
+  iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    size_t index = first.position();
+    size_t n = last.position() - index;
+    if (n > 0) {
+      closeGap(index, n);
+      growPrefix();
+    }
+    return iterator(this, index);
+  }
+
+  // 节点内定位：前count个key中第一个 >= key / > key 的下标
+  size_t lowerBound(size_t n, const KeyView &key) const {
+    return bound<false>(n, key);
+  }
+  size_t upperBound(size_t n, const KeyView &key) const {
+    return bound<true>(n, key);
+  }
+
+  // 持久化：[offsets x (count + 1)][key字节]，写出完整的key(不含公共前缀
+  // 的压缩)，读入时重新求公共前缀
+  size_t storedBytes() const {
+    return (count + 1) * sizeof(uint32_t) +
+           static_cast<size_t>(count) * prefixLength + offsets[count];
+  }
+  void store(char *dst) const {
+    char *out = dst + (count + 1) * sizeof(uint32_t);
+    for (size_t i = 0; i <= count; ++i) {
+      auto offset = static_cast<uint32_t>(offsets[i] + i * prefixLength);
+      std::memcpy(dst + i * sizeof(uint32_t), &offset, sizeof(uint32_t));
+    }
+    for (size_t i = 0; i < count; ++i) {
+      view(i).copy(out, 0, prefixLength + suffixLength(i));
+      out += prefixLength + suffixLength(i);
+    }
+  }
+
+  // 检查src处n个key的持久化内容(最多limit字节，每个key不超过keyBytes字节)，
+  // 合法时返回其字节数，否则返回0
+  static size_t measure(const char *src, size_t n, size_t limit,
+                        size_t keyBytes) {
+    size_t head = (n + 1) * sizeof(uint32_t);
+    if (head > limit) {
+      return 0;
+    }
+    uint32_t previous;
+    std::memcpy(&previous, src, sizeof(uint32_t));
+    if (previous != 0) {
+      return 0;
+    }
+    for (size_t i = 1; i <= n; ++i) {
+      uint32_t offset;
+      std::memcpy(&offset, src + i * sizeof(uint32_t), sizeof(uint32_t));
+      if (offset < previous || offset - previous > keyBytes) {
+        return 0;
+      }
+      previous = offset;
+    }
+    return previous > limit - head ? 0 : head + previous;
+  }
+
+  // 读入n个key，src最多limit字节；内容不合法时返回0且不修改，
+  // 否则返回读取的字节数
+  size_t load(const char *src, size_t n, size_t limit) {
+    size_t stored = n > cap ? 0 : measure(src, n, limit, keyBytes);
+    if (stored == 0) {
+      return 0;
+    }
+    size_t head = (n + 1) * sizeof(uint32_t);
+    auto storedKey = [src, head](size_t i) {
+      uint32_t range[2];
+      std::memcpy(range, src + i * sizeof(uint32_t), sizeof(range));
+      return KeyView(src + head + range[0], range[1] - range[0]);
+    };
+
+    clear();
+    if (n == 0) {
+      return stored;
+    }
+    KeyView first = storedKey(0);
+    size_t keep = first.size();
+    for (size_t i = 1; i < n && keep > 0; ++i) {
+      keep = std::min(keep, commonPrefix(first, storedKey(i)));
+    }
+    first.copy(bytes, 0, keep);
+    prefixLength = static_cast<uint32_t>(keep);
+    char *area = suffixes();
+    size_t offset = 0;
+    for (size_t i = 0; i < n; ++i) {
+      KeyView key = storedKey(i);
+      offsets[i] = static_cast<uint32_t>(offset);
+      key.copy(area + offset, keep, key.size() - keep);
+      offset += key.size() - keep;
+    }
+    offsets[n] = static_cast<uint32_t>(offset);
+    count = static_cast<uint32_t>(n);
+    return stored;
+  }
+
+private:
+  // 先与公共前缀比较一次：不以它开头的key在所有key之前或之后，
+  // 否则只对后缀二分
+  template <bool upper> size_t bound(size_t n, const KeyView &key) const {
+    if (!key.contiguous()) {
+      return bound<upper>(n, KeyView(std::string(key)));
+    }
+    if (n == 0) {
+      return 0;
+    }
+    const char *target = key.data();
+    size_t length = key.size();
+    size_t head = std::min<size_t>(prefixLength, length);
+    int order = head > 0 ? std::memcmp(target, bytes, head) : 0;
+    if (order == 0 && length < prefixLength) {
+      order = -1;
+    }
+    if (order != 0) {
+      return order < 0 ? 0 : n;
+    }
+    target += prefixLength;
+    length -= prefixLength;
+
+    const char *area = suffixes();
+    size_t low = 0;
+    while (n > 0) {
+      size_t half = n / 2;
+      size_t mid = low + half;
+      int probe = compareKeyBytes(area + offsets[mid], suffixLength(mid),
+                                  target, length);
+      if (upper ? probe <= 0 : probe < 0) {
+        low = mid + 1;
+        n -= half + 1;
+      } else {
+        n = half;
+      }
+    }
+    return low;
+  }
+};
+
+#endif
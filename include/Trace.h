@@ -0,0 +1,125 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+// 编译期可裁剪的结构化日志
+// 每条日志是一个事件：级别、事件名和若干 名字=值 字段，交给可替换的
+// 接收函数处理。级别低于BPLUSTREE_LOG_LEVEL的日志语句在编译期整体删除
+// (字段的求值和格式化也一起删除)；保留的日志语句在未安装接收函数时
+// 只多一次原子读取
+//
+// BPLUSTREE_LOG_LEVEL取LogLevel的数值，默认Release(定义了NDEBUG)为Off，
+// 其他为Debug；例如 -DBPLUSTREE_LOG_LEVEL=0 打开全部事件
+enum class LogLevel : int { Trace = 0, Debug, Info, Warn, Error, Off };
+
+#ifndef BPLUSTREE_LOG_LEVEL
+#ifdef NDEBUG
+#define BPLUSTREE_LOG_LEVEL 5
+#else
+#define BPLUSTREE_LOG_LEVEL 1
+#endif
+#endif
+
+constexpr LogLevel compiledLogLevel =
+    static_cast<LogLevel>(BPLUSTREE_LOG_LEVEL);
+
+constexpr bool logEnabled(LogLevel level) {
+  return level != LogLevel::Off && level >= compiledLogLevel;
+}
+
+constexpr const char *logLevelName(LogLevel level) {
+  switch (level) {
+  case LogLevel::Trace:
+    return "TRACE";
+  case LogLevel::Debug:
+    return "DEBUG";
+  case LogLevel::Info:
+    return "INFO";
+  case LogLevel::Warn:
+    return "WARN";
+  case LogLevel::Error:
+    return "ERROR";
+  default:
+    return "OFF";
+  }
+}
+
+// 事件字段：值在构造时格式化为字符串(只在事件真正发出时发生)
+struct LogField {
+  const char *name;
+  std::string value;
+
+  template <typename T>
+  LogField(const char *name, const T &v) : name(name), value(format(v)) {}
+
+private:
+  template <typename T> static std::string format(const T &v) {
+    if constexpr (std::is_same_v<T, bool>) {
+      return v ? "true" : "false";
+    } else if constexpr (std::is_arithmetic_v<T>) {
+      return std::to_string(v);
+    } else if constexpr (std::is_convertible_v<const T &, std::string>) {
+      return std::string(v);
+    } else {
+      std::ostringstream out;
+      out << v;
+      return out.str();
+    }
+  }
+};
+
+struct LogEvent {
+  LogLevel level;
+  const char *name;
+  const LogField *fields;
+  size_t fieldCount;
+};
+
+// 接收函数：同一时刻可能被多个线程调用，需自行处理并发
+using LogSink = void (*)(const LogEvent &);
+
+namespace trace_detail {
+inline std::atomic<LogSink> sink{nullptr};
+} // namespace trace_detail
+
+// 安装接收函数(nullptr表示丢弃)，返回之前的接收函数
+inline LogSink setLogSink(LogSink sink) {
+  return trace_detail::sink.exchange(sink);
+}
+
+inline LogSink currentLogSink() {
+  return trace_detail::sink.load(std::memory_order_acquire);
+}
+
+// 现成的接收函数：每个事件一行写到std::clog，
+// 形如 [DEBUG] node.save page=3 leaf=true
+inline void clogSink(const LogEvent &event) {
+  std::ostringstream line;
+  line << '[' << logLevelName(event.level) << "] " << event.name;
+  for (size_t i = 0; i < event.fieldCount; ++i) {
+    line << ' ' << event.fields[i].name << '=' << event.fields[i].value;
+  }
+  line << '\n';
+  std::clog << line.str();
+}
+
+// 发出一个事件：BPLUSTREE_LOG(LogLevel::Debug, "node.save", {"page", page})
+// 级别被裁剪时整条语句(包括字段表达式)不生成代码
+#define BPLUSTREE_LOG(level, event, ...)                                      \
+  do {                                                                        \
+    if constexpr (logEnabled(level)) {                                        \
+      if (LogSink logSink_ = currentLogSink()) {                              \
+        const LogField logFields_[] = {__VA_ARGS__};                          \
+        logSink_(LogEvent{level, event, logFields_, std::size(logFields_)});  \
+      }                                                                       \
+    }                                                                         \
+  } while (0)
+
+#endif
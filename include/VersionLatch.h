@@ -0,0 +1,91 @@
+#ifndef VERSIONLATCH_H
+#define VERSIONLATCH_H
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// 节点版本锁(optimistic lock coupling)
+// 版本字：bit0 = 已废弃(节点已释放)，bit1 = 写锁，其余位为版本号
+// 读者不加锁：读前记下版本，读完校验版本未变，否则重试
+// 写者用CAS把版本字置为加锁状态，解锁时版本号加一
+class VersionLatch {
+private:
+  static constexpr uint64_t OBSOLETE = 1;
+  static constexpr uint64_t LOCKED = 2;
+
+  std::atomic<uint64_t> word{0};
+
+  // 自旋等待，多次失败后让出CPU
+  static void backoff(unsigned &spins) {
+    if (++spins < 64) {
+#if defined(__SSE2__)
+      _mm_pause();
+#endif
+    } else {
+      std::this_thread::yield();
+    }
+  }
+
+public:
+  static bool isLocked(uint64_t version) { return (version & LOCKED) != 0; }
+  static bool isObsolete(uint64_t version) {
+    return (version & OBSOLETE) != 0;
+  }
+
+  // 读锁：等待写锁释放后返回版本号；节点已废弃时返回false
+  bool readLock(uint64_t &version) const {
+    unsigned spins = 0;
+    version = word.load(std::memory_order_acquire);
+    while (isLocked(version)) {
+      backoff(spins);
+      version = word.load(std::memory_order_acquire);
+    }
+    return !isObsolete(version);
+  }
+
+  // 校验读取期间版本未变
+  bool validate(uint64_t version) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return word.load(std::memory_order_relaxed) == version;
+  }
+
+  // 由读锁升级为写锁，期间被修改过则失败
+  bool tryUpgrade(uint64_t version) {
+    return word.compare_exchange_strong(version, version + LOCKED,
+                                        std::memory_order_acquire);
+  }
+
+  // 阻塞式写锁(节点不可处于废弃状态)
+  void lock() {
+    unsigned spins = 0;
+    for (;;) {
+      uint64_t version = word.load(std::memory_order_relaxed);
+      if (!isLocked(version) && tryUpgrade(version)) {
+        return;
+      }
+      backoff(spins);
+    }
+  }
+
+  // 解锁并推进版本号
+  void unlock() { word.fetch_add(LOCKED, std::memory_order_release); }
+
+  // 解锁并标记为废弃(节点即将归还arena)
+  void unlockObsolete() {
+    word.fetch_add(LOCKED + OBSOLETE, std::memory_order_release);
+  }
+
+  // 槽位复用时清除废弃标记并推进版本号，旧版本的读者必然校验失败
+  void reset() {
+    uint64_t version = word.load(std::memory_order_relaxed);
+    word.store((version & ~(LOCKED | OBSOLETE)) + 4,
+               std::memory_order_release);
+  }
+};
+
+#endif
@@ -0,0 +1,213 @@
+#ifndef WRITEAHEADLOG_H
+#define WRITEAHEADLOG_H
+
+#include "Checksum.h"
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// 只追加的预写日志：记录格式为 [长度 u32][CRC32 u32][内容]，内容由使用者定义
+// append把记录放进内存缓冲区并返回其提交位置(LSN)，commit等待该位置落盘
+//
+// 组提交：commit时若没有刷盘在进行，调用者成为leader，把缓冲区中所有写者
+// 追加的记录一次写出并fdatasync；刷盘期间到达的写者继续追加到新缓冲区，
+// 由下一个leader一起刷盘，多个写者因此分摊一次fsync
+//
+// LSN是逻辑字节位置，reset(截断日志)后也不回退
+class WriteAheadLog {
+private:
+  static constexpr size_t FRAME_HEADER = 2 * sizeof(uint32_t);
+  // 单条记录的长度上限(更长的长度字段只可能来自损坏的尾部)
+  static constexpr uint32_t MAX_RECORD = 1 << 24;
+  // 恢复时每次读入的字节数
+  static constexpr size_t READ_CHUNK = 1 << 20;
+
+  int fd;
+  std::string path;
+  std::mutex mutex;
+  std::condition_variable flushed;
+  std::vector<char> buffer;  // 尚未写出的记录
+  std::vector<char> writing; // leader正在写出的记录
+  uint64_t appendedLsn = 0;  // 已追加(含缓冲区)的位置
+  uint64_t durableLsn = 0;   // 已落盘的位置
+  bool flushing = false;     // 是否有leader在刷盘
+  bool failed = false;       // 写日志失败后拒绝继续提交
+  uint64_t syncCount = 0;
+
+  [[noreturn]] void fail(const std::string &what) const {
+    throw std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+  }
+
+  void writeAll(const char *data, size_t length) {
+    while (length > 0) {
+      ssize_t n = ::write(fd, data, length);
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        fail("Failed to write log");
+      }
+      data += n;
+      length -= static_cast<size_t>(n);
+    }
+  }
+
+public:
+  explicit WriteAheadLog(const std::string &path) : path(path) {
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+      fail("Failed to open log");
+    }
+  }
+
+  ~WriteAheadLog() { ::close(fd); }
+
+  WriteAheadLog(const WriteAheadLog &) = delete;
+  WriteAheadLog &operator=(const WriteAheadLog &) = delete;
+
+  // fsync次数
+  uint64_t syncs() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return syncCount;
+  }
+
+  // 按顺序把每条完整记录的内容交给visitor(data, length)，返回记录数
+  // 遇到不完整或校验失败的记录(崩溃时写了一半)即停止，并从该处截断日志
+  // 必须在第一次append之前调用
+  template <typename Visitor> size_t replay(Visitor &&visitor) {
+    std::vector<char> data;
+    size_t begin = 0;      // data中下一条记录的起点
+    off_t fileOffset = 0;  // 已读入的文件位置
+    uint64_t validEnd = 0; // 最后一条完整记录之后的文件位置
+    size_t records = 0;
+    bool eof = false;
+    for (;;) {
+      // 保证缓冲区中至少有一个完整的记录
+      size_t need = FRAME_HEADER;
+      if (data.size() - begin >= FRAME_HEADER) {
+        uint32_t length;
+        std::memcpy(&length, data.data() + begin, sizeof(uint32_t));
+        if (length > MAX_RECORD) {
+          break;
+        }
+        need += length;
+      }
+      if (data.size() - begin < need) {
+        if (eof) {
+          break;
+        }
+        data.erase(data.begin(), data.begin() + static_cast<long>(begin));
+        begin = 0;
+        size_t oldSize = data.size();
+        data.resize(oldSize + std::max(READ_CHUNK, need));
+        ssize_t n = ::pread(fd, data.data() + oldSize, data.size() - oldSize,
+                            fileOffset);
+        if (n < 0) {
+          if (errno == EINTR) {
+            data.resize(oldSize);
+            continue;
+          }
+          fail("Failed to read log");
+        }
+        data.resize(oldSize + static_cast<size_t>(n));
+        fileOffset += n;
+        eof = n == 0;
+        continue;
+      }
+
+      uint32_t length, crc;
+      std::memcpy(&length, data.data() + begin, sizeof(uint32_t));
+      std::memcpy(&crc, data.data() + begin + sizeof(uint32_t),
+                  sizeof(uint32_t));
+      const char *payload = data.data() + begin + FRAME_HEADER;
+      if (crc32(payload, length) != crc) {
+        break;
+      }
+      visitor(payload, static_cast<size_t>(length));
+      ++records;
+      begin += FRAME_HEADER + length;
+      validEnd += FRAME_HEADER + length;
+    }
+
+    // 截掉损坏的尾部，之后的记录接在最后一条完整记录之后
+    if (::ftruncate(fd, static_cast<off_t>(validEnd)) != 0) {
+      fail("Failed to truncate log");
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    appendedLsn = durableLsn = validEnd;
+    return records;
+  }
+
+  // 追加一条记录，返回提交位置(传给commit)
+  uint64_t append(const char *data, size_t length) {
+    uint32_t header[2] = {static_cast<uint32_t>(length), crc32(data, length)};
+    std::lock_guard<std::mutex> lock(mutex);
+    const char *bytes = reinterpret_cast<const char *>(header);
+    buffer.insert(buffer.end(), bytes, bytes + FRAME_HEADER);
+    buffer.insert(buffer.end(), data, data + length);
+    appendedLsn += FRAME_HEADER + length;
+    return appendedLsn;
+  }
+
+  // 等待lsn之前的记录全部落盘(组提交)
+  void commit(uint64_t lsn) {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (durableLsn < lsn) {
+      if (failed) {
+        throw std::runtime_error("Write-ahead log is unusable: " + path);
+      }
+      if (flushing) {
+        flushed.wait(lock);
+        continue;
+      }
+
+      // 成为leader：写出缓冲区中所有写者的记录
+      flushing = true;
+      writing.swap(buffer);
+      uint64_t target = appendedLsn;
+      lock.unlock();
+      try {
+        writeAll(writing.data(), writing.size());
+        if (::fdatasync(fd) != 0) {
+          fail("Failed to sync log");
+        }
+      } catch (...) {
+        lock.lock();
+        flushing = false;
+        failed = true;
+        flushed.notify_all();
+        throw;
+      }
+      writing.clear();
+      lock.lock();
+      flushing = false;
+      durableLsn = target;
+      ++syncCount;
+      flushed.notify_all();
+    }
+  }
+
+  // 清空日志：已追加的记录都已包含在持久化的快照中，视为已落盘
+  // 调用方保证期间没有新的append
+  void reset() {
+    std::unique_lock<std::mutex> lock(mutex);
+    flushed.wait(lock, [this] { return !flushing; });
+    if (::ftruncate(fd, 0) != 0) {
+      fail("Failed to truncate log");
+    }
+    buffer.clear();
+    durableLsn = appendedLsn;
+    flushed.notify_all();
+  }
+};
+
+#endif
@@ -1,9 +1,12 @@
 #include "../include/BplusTree.h" // 假设你的B+树类定义在此头文件中
+#include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <random>
+#include <utility>
 #include <vector>
 
 void test_bplus_tree_bulk_insert() {
@@ -64,8 +67,98 @@ void test_bplus_tree_bulk_insert() {
   std::cout << "结果已保存到 insert_performance.csv" << std::endl;
 }
 
+// insertBatch：同样的随机键按不同批大小成批插入，与逐个插入对比
+void test_bplus_tree_insert_batch() {
+  const int num_inserts = 10'000'000;
+  std::mt19937 gen(20240601);
+  std::uniform_int_distribution<> key_dist(1, 1'000'000'000);
+  std::vector<std::pair<int, int64_t>> pairs(num_inserts);
+  for (auto &entry : pairs) {
+    entry.first = key_dist(gen);
+    entry.second = int64_t{entry.first} * 10;
+  }
+
+  std::ofstream outFile("./insert_batch_performance.csv");
+  if (!outFile) {
+    std::cerr << "无法创建文件 insert_batch_performance.csv" << std::endl;
+    return;
+  }
+  outFile << "Degree,BatchSize,TotalTime(s),InsertionsPerSecond\n";
+
+  for (int degree : {4, 64}) {
+    std::cout << "\n测试度数: " << degree << " (maxKeys=" << degree - 1 << ")"
+              << std::endl;
+
+    // 批大小为1即逐个insert(基准)
+    for (int batch_size : {1, 1'000, 100'000}) {
+      BplusTree<int, int64_t> tree(degree);
+      auto start_time = std::chrono::high_resolution_clock::now();
+
+      if (batch_size == 1) {
+        for (const auto &entry : pairs) {
+          tree.insert(entry.first, entry.second);
+        }
+      } else {
+        for (int i = 0; i < num_inserts; i += batch_size) {
+          int last = std::min(num_inserts, i + batch_size);
+          tree.insertBatch(pairs.begin() + i, pairs.begin() + last);
+        }
+      }
+
+      auto end_time = std::chrono::high_resolution_clock::now();
+      auto duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+          end_time - start_time);
+      double duration_seconds = duration_ms.count() / 1000.0;
+      int insertions_per_second =
+          static_cast<int>(num_inserts / duration_seconds);
+
+      // 抽样校验
+      for (int i = 0; i < num_inserts; i += 9973) {
+        assert(tree.search(pairs[i].first) == pairs[i].second);
+      }
+
+      std::cout << "批大小: " << batch_size << " 总耗时: " << duration_seconds
+                << " 秒 平均每秒插入: " << insertions_per_second << " 次"
+                << std::endl;
+      outFile << degree << "," << batch_size << "," << duration_seconds << ","
+              << insertions_per_second << "\n";
+    }
+  }
+
+  outFile.close();
+  std::cout << "结果已保存到 insert_batch_performance.csv" << std::endl;
+}
+
+// 含重复key的批次：insertBatch后的内容应与逐个insert相同
+void test_bplus_tree_insert_batch_duplicates() {
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<> key_dist(1, 200);
+  std::vector<std::pair<int, int64_t>> pairs(5'000);
+  for (size_t i = 0; i < pairs.size(); ++i) {
+    pairs[i] = {key_dist(gen), static_cast<int64_t>(i)};
+  }
+
+  for (int degree : {4, 64}) {
+    BplusTree<int, int64_t> inserted(degree);
+    for (const auto &entry : pairs) {
+      inserted.insert(entry.first, entry.second);
+    }
+    BplusTree<int, int64_t> batched(degree);
+    batched.insertBatch(pairs.begin(), pairs.end());
+
+    auto expected = inserted.rangeSearch(1, 200);
+    auto actual = batched.rangeSearch(1, 200);
+    assert(actual.size() == pairs.size());
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    assert(actual == expected);
+  }
+}
+
 int main() {
+  test_bplus_tree_insert_batch_duplicates();
   test_bplus_tree_bulk_insert();
+  test_bplus_tree_insert_batch();
   std::cout << "批量插入测试通过！" << std::endl;
   return 0;
 }
\ No newline at end of file
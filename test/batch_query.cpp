@@ -1,4 +1,5 @@
 #include "../include/BplusTree.h" // 假设你的B+树类定义在此头文件中
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <iostream>
@@ -106,6 +107,41 @@ void test_bplus_tree_bulk_operations() {
   std::cout << "平均每秒查询："
             << static_cast<int>(num_queries / query_duration_seconds) << " 次"
             << std::endl;
+
+  // 批量查询阶段：同样数量的随机键，每批1024个交给multiSearch
+  const int batch_size = 1024;
+  std::cout << "开始批量查询(multiSearch) " << num_queries << " 个键"
+            << std::endl;
+  std::vector<int> batch(batch_size);
+  std::vector<int> results;
+  auto multi_start_time = std::chrono::high_resolution_clock::now();
+  int multi_found_count = 0;
+  for (int i = 0; i < num_queries; i += batch_size) {
+    batch.resize(std::min(batch_size, num_queries - i));
+    for (int &key : batch) {
+      key = key_dist(gen);
+    }
+    tree.multiSearch(batch, results);
+    for (int value : results) {
+      if (value != 0) {
+        ++multi_found_count;
+      }
+    }
+  }
+  auto multi_end_time = std::chrono::high_resolution_clock::now();
+  auto multi_duration_ms =
+      std::chrono::duration_cast<std::chrono::milliseconds>(multi_end_time -
+                                                            multi_start_time);
+  double multi_duration_seconds = multi_duration_ms.count() / 1000.0;
+
+  std::cout << "批量查询完成！" << std::endl;
+  std::cout << "找到比例：" << (multi_found_count * 100.0 / num_queries) << "%"
+            << std::endl;
+  std::cout << "批量查询总耗时：" << multi_duration_seconds << " 秒"
+            << std::endl;
+  std::cout << "平均每秒查询："
+            << static_cast<int>(num_queries / multi_duration_seconds) << " 次"
+            << std::endl;
 }
 
 int main() {
@@ -0,0 +1,108 @@
+#include "../include/BplusTree.h" // 假设你的B+树类定义在此头文件中
+#include <cassert>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// 批量构建测试：同一份有序键值对分别用逐个insert和bulkLoad建树，
+// 比较耗时、节点数，并抽样校验两棵树的查询结果一致
+
+double elapsed_seconds(std::chrono::high_resolution_clock::time_point start) {
+  auto end_time = std::chrono::high_resolution_clock::now();
+  auto duration_ms =
+      std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start);
+  return duration_ms.count() / 1000.0;
+}
+
+void test_bplus_tree_bulk_load() {
+  const int num_pairs = 10'000'000; // 1000万
+
+  // 有序输入：键为奇数，查询偶数必然不命中
+  std::vector<std::pair<int, int>> pairs(num_pairs);
+  for (int i = 0; i < num_pairs; ++i) {
+    pairs[i] = {2 * i + 1, i};
+  }
+
+  // 打开文件以写入结果
+  std::ofstream outFile("./bulk_load_performance.csv");
+  if (!outFile) {
+    std::cerr << "无法创建文件 bulk_load_performance.csv" << std::endl;
+    return;
+  }
+  // 写入CSV头
+  outFile << "Degree,Method,FillFactor,TotalTime(s),PairsPerSecond,Nodes\n";
+
+  for (int degree : {4, 64}) {
+    std::cout << "\n测试度数: " << degree << " (maxKeys=" << degree - 1 << ")"
+              << std::endl;
+
+    // 逐个插入(基准)
+    BplusTree<int, int> inserted(degree);
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (const auto &entry : pairs) {
+      inserted.insert(entry.first, entry.second);
+    }
+    double insert_seconds = elapsed_seconds(start_time);
+    size_t insert_nodes = inserted.countNode();
+    std::cout << "逐个插入 总耗时: " << insert_seconds << " 秒"
+              << " 节点数: " << insert_nodes << std::endl;
+    outFile << degree << ",insert,-," << insert_seconds << ","
+            << static_cast<long>(num_pairs / insert_seconds) << ","
+            << insert_nodes << "\n";
+
+    for (double fill : {1.0, 0.7}) {
+      BplusTree<int, int> loaded(degree);
+      start_time = std::chrono::high_resolution_clock::now();
+      loaded.bulkLoad(pairs.begin(), pairs.end(), fill);
+      double load_seconds = elapsed_seconds(start_time);
+      size_t load_nodes = loaded.countNode();
+
+      // 抽样校验
+      for (int i = 0; i < num_pairs; i += 9973) {
+        assert(loaded.search(2 * i + 1) == inserted.search(2 * i + 1));
+        assert(loaded.search(2 * i + 2) == 0);
+      }
+
+      std::cout << "bulkLoad(装填比例 " << fill
+                << ") 总耗时: " << load_seconds << " 秒"
+                << " 节点数: " << load_nodes
+                << " 加速比: " << insert_seconds / load_seconds << std::endl;
+      outFile << degree << ",bulkLoad," << fill << "," << load_seconds << ","
+              << static_cast<long>(num_pairs / load_seconds) << ","
+              << load_nodes << "\n";
+    }
+  }
+
+  outFile.close();
+  std::cout << "结果已保存到 bulk_load_performance.csv" << std::endl;
+}
+
+// 无序输入应在丢弃旧树之前被拒绝，原有内容保持可查
+void test_bulk_load_unsorted_keeps_tree() {
+  BplusTree<int, int> tree(4);
+  for (int i = 1; i <= 1000; ++i) {
+    tree.insert(i, i * 10);
+  }
+
+  std::vector<std::pair<int, int>> unsorted = {{5, 1}, {3, 2}, {7, 3}};
+  bool threw = false;
+  try {
+    tree.bulkLoad(unsorted.begin(), unsorted.end());
+  } catch (const std::runtime_error &) {
+    threw = true;
+  }
+  assert(threw);
+  for (int i = 1; i <= 1000; ++i) {
+    assert(tree.search(i) == i * 10);
+  }
+}
+
+int main() {
+  test_bulk_load_unsorted_keeps_tree();
+  test_bplus_tree_bulk_load();
+  std::cout << "批量构建测试通过！" << std::endl;
+  return 0;
+}
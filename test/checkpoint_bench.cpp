@@ -0,0 +1,82 @@
+#include "../include/BplusTree.h" // 假设你的B+树类定义在此头文件中
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// 增量检查点测试：构建一棵树并完整写出一次，之后每轮随机修改若干个key，
+// 比较增量检查点与完整序列化的耗时和写出的页数，
+// 并用新树反序列化检查点文件，检查内容与原树一致
+
+double elapsed_seconds(std::chrono::high_resolution_clock::time_point start) {
+  auto end_time = std::chrono::high_resolution_clock::now();
+  auto duration_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(end_time - start);
+  return duration_us.count() / 1e6;
+}
+
+void test_bplus_tree_checkpoint() {
+  const int num_pairs = 2'000'000; // 树中的键值对数量
+  const std::string data_file = "./bplustree.dat";
+  const std::string full_file = "./bplustree_full.dat";
+
+  std::ofstream outFile("./checkpoint_performance.csv");
+  if (!outFile) {
+    std::cerr << "无法创建文件 checkpoint_performance.csv" << std::endl;
+    return;
+  }
+  outFile << "ModifiedKeys,CheckpointTime(s),CheckpointPages,"
+             "SerializeTime(s),SerializePages\n";
+
+  BplusTree<int, uint64_t> tree(128);
+  for (int i = 0; i < num_pairs; ++i) {
+    tree.insert(i, static_cast<uint64_t>(i));
+  }
+  tree.serialize(data_file);
+
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> pick(0, num_pairs - 1);
+  for (int modified : {1, 10, 100, 1'000, 10'000, 100'000}) {
+    for (int i = 0; i < modified; ++i) {
+      int key = pick(rng);
+      tree.modify(key, static_cast<uint64_t>(key) + modified);
+    }
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    size_t checkpoint_pages = tree.checkpoint(data_file);
+    double checkpoint_seconds = elapsed_seconds(start_time);
+
+    // 对比：加载检查点文件，完整写出到另一个文件(checkpoint到非当前数据
+    // 文件时即完整写出)
+    BplusTree<int, uint64_t> loaded(128);
+    loaded.deserialize(data_file);
+    start_time = std::chrono::high_resolution_clock::now();
+    size_t serialize_pages = loaded.checkpoint(full_file);
+    double serialize_seconds = elapsed_seconds(start_time);
+
+    assert(loaded.rangeSearch(0, num_pairs) ==
+           tree.rangeSearch(0, num_pairs));
+    std::cout << "修改key数: " << modified
+              << " 检查点耗时: " << checkpoint_seconds
+              << " 秒 写出页数: " << checkpoint_pages
+              << " | 完整序列化耗时: " << serialize_seconds
+              << " 秒 写出页数: " << serialize_pages << std::endl;
+    outFile << modified << "," << checkpoint_seconds << ","
+            << checkpoint_pages << "," << serialize_seconds << ","
+            << serialize_pages << "\n";
+  }
+
+  std::remove(data_file.c_str());
+  std::remove(full_file.c_str());
+  outFile.close();
+  std::cout << "结果已保存到 checkpoint_performance.csv" << std::endl;
+}
+
+int main() {
+  test_bplus_tree_checkpoint();
+  std::cout << "增量检查点测试通过！" << std::endl;
+  return 0;
+}
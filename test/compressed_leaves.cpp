@@ -0,0 +1,160 @@
+#include "../include/BplusTree.h" // 假设你的B+树类定义在此头文件中
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 压缩叶子测试：同样的整数键值对分别放入普通的树和PackedKey的树，
+// key为连续的ID(差值很小)或随机的64位ID，value为较小的计数，
+// 比较乱序插入、随机查询、全量扫描、写入文件的耗时和每个键值对占用的内存
+
+double elapsed_seconds(std::chrono::high_resolution_clock::time_point start) {
+  auto end_time = std::chrono::high_resolution_clock::now();
+  auto duration_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(end_time - start);
+  return duration_us.count() / 1e6;
+}
+
+struct Result {
+  double insert_seconds, search_seconds, scan_seconds, serialize_seconds;
+  double bytes_per_entry;
+};
+
+// 对一种树跑完整的一轮测试
+template <typename Tree, typename Key>
+Result run_case(const std::vector<uint64_t> &ids,
+                const std::vector<uint64_t> &values,
+                const std::vector<size_t> &queries) {
+  const std::string data_file = "./bplustree.dat";
+  Result result{};
+
+  Tree tree(128);
+  auto start_time = std::chrono::high_resolution_clock::now();
+  for (size_t i = 0; i < ids.size(); ++i) {
+    tree.insert(Key(ids[i]), values[i]);
+  }
+  result.insert_seconds = elapsed_seconds(start_time);
+  result.bytes_per_entry =
+      static_cast<double>(tree.memoryUsage()) / static_cast<double>(ids.size());
+
+  // 随机查询
+  uint64_t checksum = 0;
+  start_time = std::chrono::high_resolution_clock::now();
+  for (size_t q : queries) {
+    checksum += tree.search(Key(ids[q]));
+  }
+  result.search_seconds = elapsed_seconds(start_time);
+  uint64_t expected = 0;
+  for (size_t q : queries) {
+    expected += values[q];
+  }
+  assert(checksum == expected);
+  (void)expected;
+
+  // 游标全量扫描
+  start_time = std::chrono::high_resolution_clock::now();
+  typename Tree::Cursor cursor(tree);
+  cursor.seek(Key(0));
+  std::vector<Key> keys(256);
+  std::vector<uint64_t> buffer(256);
+  size_t scanned = 0;
+  uint64_t sum = 0;
+  for (size_t n; (n = cursor.nextN(keys.data(), buffer.data(), 256)) > 0;) {
+    scanned += n;
+    for (size_t i = 0; i < n; ++i) {
+      sum += buffer[i];
+    }
+  }
+  result.scan_seconds = elapsed_seconds(start_time);
+  assert(scanned == ids.size());
+  (void)sum;
+
+  start_time = std::chrono::high_resolution_clock::now();
+  tree.serialize(data_file);
+  result.serialize_seconds = elapsed_seconds(start_time);
+
+  // 重新加载后抽查
+  Tree loaded(128);
+  loaded.deserialize(data_file);
+  assert(loaded.search(Key(ids[queries[0]])) == values[queries[0]]);
+  std::remove(data_file.c_str());
+  return result;
+}
+
+void test_bplus_tree_compressed_leaves() {
+  std::ofstream outFile("./compressed_leaves_performance.csv");
+  if (!outFile) {
+    std::cerr << "无法创建文件 compressed_leaves_performance.csv" << std::endl;
+    return;
+  }
+  outFile << "KeyKind,Layout,DataSize,InsertTime(s),SearchTime(s),"
+             "ScanTime(s),SerializeTime(s),BytesPerEntry\n";
+
+  std::mt19937_64 rng(42);
+  const std::pair<std::string, size_t> cases[] = {{"sequential", 1'000'000},
+                                                  {"random", 1'000'000}};
+  for (const auto &[kind, num_pairs] : cases) {
+    // 连续ID从一个较大的起点开始，随机ID取满64位
+    std::vector<uint64_t> ids(num_pairs);
+    for (size_t i = 0; i < num_pairs; ++i) {
+      ids[i] = kind == "sequential" ? 1'000'000'000ULL + i : rng();
+    }
+    std::vector<uint64_t> values(num_pairs);
+    for (uint64_t &value : values) {
+      value = rng() % 1000;
+    }
+    // 乱序插入
+    std::vector<size_t> order(num_pairs);
+    for (size_t i = 0; i < num_pairs; ++i) {
+      order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), rng);
+    std::vector<uint64_t> shuffled_ids(num_pairs), shuffled_values(num_pairs);
+    for (size_t i = 0; i < num_pairs; ++i) {
+      shuffled_ids[i] = ids[order[i]];
+      shuffled_values[i] = values[order[i]];
+    }
+    std::vector<size_t> queries(num_pairs);
+    std::uniform_int_distribution<size_t> pick(0, num_pairs - 1);
+    for (size_t &q : queries) {
+      q = pick(rng);
+    }
+
+    Result plain =
+        run_case<BplusTree<uint64_t, uint64_t>, uint64_t>(
+            shuffled_ids, shuffled_values, queries);
+    Result packed =
+        run_case<BplusTree<PackedKey<uint64_t>, uint64_t>,
+                 PackedKey<uint64_t>>(shuffled_ids, shuffled_values, queries);
+
+    for (const auto &[layout, r] :
+         {std::make_pair("plain", plain), std::make_pair("packed", packed)}) {
+      std::cout << "key类型: " << kind << " 布局: " << layout
+                << " 数据量: " << num_pairs << " 插入: " << r.insert_seconds
+                << " 秒 | 查询: " << r.search_seconds
+                << " 秒 | 扫描: " << r.scan_seconds
+                << " 秒 | 写入文件: " << r.serialize_seconds
+                << " 秒 | 每个键值对: " << r.bytes_per_entry << " 字节"
+                << std::endl;
+      outFile << kind << "," << layout << "," << num_pairs << ","
+              << r.insert_seconds << "," << r.search_seconds << ","
+              << r.scan_seconds << "," << r.serialize_seconds << ","
+              << r.bytes_per_entry << "\n";
+    }
+  }
+
+  outFile.close();
+  std::cout << "结果已保存到 compressed_leaves_performance.csv" << std::endl;
+}
+
+int main() {
+  test_bplus_tree_compressed_leaves();
+  std::cout << "压缩叶子测试通过！" << std::endl;
+  return 0;
+}
@@ -0,0 +1,142 @@
+#include "../include/BplusTree.h" // 假设你的B+树类定义在此头文件中
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+// 重复key测试：在小阶数的树中插入一长串相同的key，使其跨过多次叶子分裂
+// (分隔key与两侧的key相等)，检查每一份都能被查找、范围查询、快照和冻结
+// 读到，并能逐个删除；分别在普通下降和学习索引下运行
+// 另有一串最小的key(学习索引中多个叶子的下界都是它)，并在按需加载的
+// 副本上检查游标沿链接读入相邻叶子时不跳过重复key
+
+using Tree = BplusTree<int, uint64_t>;
+
+// 范围查询[key, key]的结果个数，并确认都是该key
+size_t count_copies(Tree &tree, int key) {
+  auto result = tree.rangeSearch(key, key);
+  auto reversed = tree.reverseRangeSearch(key, key);
+  assert(result.size() == reversed.size());
+  for (const auto &pair : result) {
+    assert(pair.first == key);
+    (void)pair;
+  }
+  return result.size();
+}
+
+void test_bplus_tree_duplicate_keys(bool learned) {
+  const int num_keys = 1000;
+  const int dup_key = 500;
+  const size_t copies = 300;
+  const size_t batch_copies = 200;
+  const int batch_key = 700;
+  const int min_key = std::numeric_limits<int>::min();
+  const size_t min_copies = 20;
+
+  std::mt19937 rng(42);
+  std::vector<int> keys(num_keys);
+  for (int i = 0; i < num_keys; ++i) {
+    keys[i] = i;
+  }
+  std::shuffle(keys.begin(), keys.end(), rng);
+
+  // 阶数为4：每个叶子至多3个key，一串重复key跨过上百个叶子
+  Tree tree(4);
+  if (learned) {
+    tree.enableLearnedIndex();
+  }
+  for (int key : keys) {
+    tree.insert(key, static_cast<uint64_t>(key) + 1);
+  }
+  for (size_t i = 0; i < copies; ++i) {
+    tree.insert(dup_key, 10'000 + i);
+  }
+  std::vector<std::pair<int, uint64_t>> batch(batch_copies,
+                                              {batch_key, 20'000});
+  tree.insertBatch(batch.begin(), batch.end(), true);
+  for (size_t i = 0; i < min_copies; ++i) {
+    tree.insert(min_key, 30'000 + i);
+  }
+
+  // 1.每一份都能读到
+  assert(count_copies(tree, dup_key) == copies + 1);
+  assert(count_copies(tree, batch_key) == batch_copies + 1);
+  assert(count_copies(tree, min_key) == min_copies);
+  assert(tree.search(dup_key) != uint64_t{});
+  std::vector<uint64_t> found;
+  tree.multiSearch({dup_key, batch_key, dup_key - 1, dup_key + 1}, found);
+  assert(found[0] != uint64_t{} && found[1] != uint64_t{});
+  assert(found[2] == dup_key && found[3] == dup_key + 2);
+
+  const std::string filename = "./bplustree_duplicate.snap";
+  tree.saveSnapshot(filename);
+  {
+    Tree::Snapshot snapshot(filename);
+    assert(snapshot.search(dup_key) != uint64_t{});
+    assert(snapshot.rangeSearch(dup_key, dup_key).size() == copies + 1);
+  }
+  std::remove(filename.c_str());
+  auto frozen = tree.freeze();
+  assert(frozen.search(dup_key) != uint64_t{});
+  assert(frozen.rangeSearch(dup_key, dup_key).size() == copies + 1);
+
+  // 按需加载：每次扫描前重新打开，扫描沿途的叶子都还没读入
+  const std::string data_file = "./bplustree_duplicate.dat";
+  const size_t total = num_keys + copies + batch_copies + min_copies;
+  tree.serialize(data_file);
+  for (bool reverse : {false, true}) {
+    Tree lazy(4);
+    lazy.deserializeLazy(data_file);
+    auto result = reverse ? lazy.reverseRangeSearch(min_key, num_keys)
+                          : lazy.rangeSearch(min_key, num_keys);
+    assert(result.size() == total);
+  }
+  std::remove(data_file.c_str());
+
+  // 2.逐个删除，每次删除后剩余的份数都能读到
+  size_t removed = 0;
+  for (size_t left = copies + 1; left > 0; --left) {
+    bool ok = tree.remove(dup_key);
+    assert(ok);
+    (void)ok;
+    ++removed;
+    assert(count_copies(tree, dup_key) == left - 1);
+  }
+  assert(!tree.remove(dup_key));
+  assert(tree.search(dup_key) == uint64_t{});
+  for (size_t left = batch_copies + 1; left > 0; --left) {
+    bool ok = tree.remove(batch_key);
+    assert(ok);
+    (void)ok;
+    ++removed;
+  }
+  assert(count_copies(tree, batch_key) == 0);
+  for (size_t left = min_copies; left > 0; --left) {
+    bool ok = tree.remove(min_key);
+    assert(ok);
+    (void)ok;
+    ++removed;
+    assert(count_copies(tree, min_key) == left - 1);
+  }
+
+  // 3.其余key不受影响
+  for (int key = 0; key < num_keys; ++key) {
+    if (key != dup_key && key != batch_key) {
+      assert(tree.search(key) == static_cast<uint64_t>(key) + 1);
+    }
+  }
+
+  std::cout << (learned ? "学习索引" : "逐层下降") << " 删除重复key: "
+            << removed << " 份" << std::endl;
+}
+
+int main() {
+  test_bplus_tree_duplicate_keys(false);
+  test_bplus_tree_duplicate_keys(true);
+  std::cout << "重复key测试通过！" << std::endl;
+  return 0;
+}
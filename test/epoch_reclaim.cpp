@@ -0,0 +1,92 @@
+#include "../include/BplusTree.h" // 假设你的B+树类定义在此头文件中
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+// 延迟回收测试：若干读线程不停随机查询一批固定的key，同时一个写线程反复
+// 插入再删除另一批key(分裂/合并不断释放节点)；记录读线程的查询吞吐、
+// 写线程的耗时，以及退休节点的积压和归还arena的节点数
+
+double elapsed_seconds(std::chrono::high_resolution_clock::time_point start) {
+  auto end_time = std::chrono::high_resolution_clock::now();
+  auto duration_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(end_time - start);
+  return duration_us.count() / 1e6;
+}
+
+void test_bplus_tree_epoch_reclaim() {
+  std::ofstream outFile("./epoch_reclaim_performance.csv");
+  if (!outFile) {
+    std::cerr << "无法创建文件 epoch_reclaim_performance.csv" << std::endl;
+    return;
+  }
+  outFile << "Readers,ReadsPerSecond,WriteTime(s),Releases,MaxRetired\n";
+
+  // 固定的key为偶数，写线程增删的key为奇数
+  const uint64_t key_range = 1'000'000;
+  const size_t rounds = 4;
+  for (size_t readers : {1, 2, 4}) {
+    BplusTree<uint64_t, uint64_t> tree(16);
+    for (uint64_t key = 0; key < key_range; key += 2) {
+      tree.insert(key, key * 3);
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> reads{0}, wrong{0};
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < readers; ++t) {
+      threads.emplace_back([&, t] {
+        std::mt19937_64 rng(t);
+        uint64_t count = 0, bad = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+          uint64_t key = rng() % (key_range / 2) * 2;
+          bad += tree.search(key) != key * 3;
+          ++count;
+        }
+        reads += count;
+        wrong += bad;
+      });
+    }
+
+    size_t max_retired = 0;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (size_t round = 0; round < rounds; ++round) {
+      for (uint64_t key = 1; key < key_range; key += 2) {
+        tree.insert(key, key * 3);
+      }
+      for (uint64_t key = 1; key < key_range; key += 2) {
+        tree.remove(key);
+      }
+      max_retired = std::max(max_retired, tree.allocStats().retiredNodes);
+    }
+    double write_seconds = elapsed_seconds(start_time);
+    stop = true;
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    assert(wrong == 0);
+
+    auto stats = tree.allocStats();
+    double reads_per_second = static_cast<double>(reads) / write_seconds;
+    std::cout << "读线程: " << readers << " 查询吞吐: " << reads_per_second
+              << " 次/秒 | 写: " << write_seconds
+              << " 秒 | 归还节点: " << stats.releases
+              << " | 最大退休积压: " << max_retired << std::endl;
+    outFile << readers << "," << reads_per_second << "," << write_seconds
+            << "," << stats.releases << "," << max_retired << "\n";
+  }
+
+  outFile.close();
+  std::cout << "结果已保存到 epoch_reclaim_performance.csv" << std::endl;
+}
+
+int main() {
+  test_bplus_tree_epoch_reclaim();
+  std::cout << "延迟回收测试通过！" << std::endl;
+  return 0;
+}
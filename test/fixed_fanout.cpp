@@ -0,0 +1,156 @@
+#include "../include/BplusTree.h" // 假设你的B+树类定义在此头文件中
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// 编译期阶数测试：同样的阶数分别在运行时传入(BplusTree<K, V>(m))和
+// 作为模板参数(BplusTree<K, V, m>)，比较乱序插入、随机查询和删除一半key的耗时
+// (中位数)，并输出两者的耗时比
+
+double elapsed_seconds(std::chrono::high_resolution_clock::time_point start) {
+  auto end_time = std::chrono::high_resolution_clock::now();
+  auto duration_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(end_time - start);
+  return duration_us.count() / 1e6;
+}
+
+struct Result {
+  double insert_seconds, search_seconds, remove_seconds;
+};
+
+template <typename Tree>
+Result run_case(Tree &tree, const std::vector<uint64_t> &keys,
+                const std::vector<size_t> &queries) {
+  Result result{};
+  auto start_time = std::chrono::high_resolution_clock::now();
+  for (uint64_t key : keys) {
+    tree.insert(key, key + 1);
+  }
+  result.insert_seconds = elapsed_seconds(start_time);
+
+  uint64_t checksum = 0;
+  start_time = std::chrono::high_resolution_clock::now();
+  for (size_t q : queries) {
+    checksum += tree.search(keys[q]);
+  }
+  result.search_seconds = elapsed_seconds(start_time);
+  uint64_t expected = 0;
+  for (size_t q : queries) {
+    expected += keys[q] + 1;
+  }
+  assert(checksum == expected);
+  (void)expected;
+
+  start_time = std::chrono::high_resolution_clock::now();
+  for (size_t i = 0; i < keys.size(); i += 2) {
+    tree.remove(keys[i]);
+  }
+  result.remove_seconds = elapsed_seconds(start_time);
+  assert(tree.search(keys[1]) == keys[1] + 1);
+  return result;
+}
+
+// 每种方式各建REPEATS棵树，轮流先后运行(先运行的一方不占缓存和
+// 分配器的便宜)，各项耗时取中位数
+constexpr size_t REPEATS = 5;
+
+double median(std::vector<double> samples) {
+  std::sort(samples.begin(), samples.end());
+  return samples[samples.size() / 2];
+}
+
+Result median_result(const std::vector<Result> &results) {
+  std::vector<double> insert, search, remove;
+  for (const Result &r : results) {
+    insert.push_back(r.insert_seconds);
+    search.push_back(r.search_seconds);
+    remove.push_back(r.remove_seconds);
+  }
+  return {median(insert), median(search), median(remove)};
+}
+
+template <size_t order>
+void run_order(const std::vector<uint64_t> &keys,
+               const std::vector<size_t> &queries, std::ofstream &outFile) {
+  std::vector<Result> runtime_results, fixed_results;
+  for (size_t i = 0; i < REPEATS; ++i) {
+    auto run_runtime = [&] {
+      BplusTree<uint64_t, uint64_t> runtime_tree(order);
+      runtime_results.push_back(run_case(runtime_tree, keys, queries));
+    };
+    auto run_fixed = [&] {
+      BplusTree<uint64_t, uint64_t, order> fixed_tree;
+      fixed_results.push_back(run_case(fixed_tree, keys, queries));
+    };
+    if (i % 2 == 0) {
+      run_runtime();
+      run_fixed();
+    } else {
+      run_fixed();
+      run_runtime();
+    }
+  }
+  Result runtime_result = median_result(runtime_results);
+  Result fixed_result = median_result(fixed_results);
+
+  for (const auto &[variant, r] : {std::make_pair("runtime", runtime_result),
+                                   std::make_pair("fixed", fixed_result)}) {
+    std::cout << "阶数: " << order << " 方式: " << variant
+              << " 数据量: " << keys.size() << " 插入: " << r.insert_seconds
+              << " 秒 | 查询: " << r.search_seconds
+              << " 秒 | 删除: " << r.remove_seconds << " 秒" << std::endl;
+    outFile << order << "," << variant << "," << keys.size() << ","
+            << r.insert_seconds << "," << r.search_seconds << ","
+            << r.remove_seconds << "\n";
+  }
+  // 大于1表示编译期阶数更慢
+  std::cout << "阶数: " << order << " 编译期/运行时耗时比 插入: "
+            << fixed_result.insert_seconds / runtime_result.insert_seconds
+            << " | 查询: "
+            << fixed_result.search_seconds / runtime_result.search_seconds
+            << " | 删除: "
+            << fixed_result.remove_seconds / runtime_result.remove_seconds
+            << std::endl;
+}
+
+void test_bplus_tree_fixed_fanout() {
+  std::ofstream outFile("./fixed_fanout_performance.csv");
+  if (!outFile) {
+    std::cerr << "无法创建文件 fixed_fanout_performance.csv" << std::endl;
+    return;
+  }
+  outFile << "Order,Variant,DataSize,InsertTime(s),SearchTime(s),"
+             "RemoveTime(s)\n";
+
+  const size_t num_pairs = 1'000'000;
+  std::mt19937_64 rng(42);
+  std::vector<uint64_t> keys(num_pairs);
+  for (size_t i = 0; i < num_pairs; ++i) {
+    keys[i] = i * 16;
+  }
+  std::shuffle(keys.begin(), keys.end(), rng);
+  std::vector<size_t> queries(num_pairs);
+  std::uniform_int_distribution<size_t> pick(0, num_pairs - 1);
+  for (size_t &q : queries) {
+    q = pick(rng);
+  }
+
+  // 16/64个key正好占2/8条缓存行，256个key的节点约为一页
+  run_order<16>(keys, queries, outFile);
+  run_order<64>(keys, queries, outFile);
+  run_order<256>(keys, queries, outFile);
+
+  outFile.close();
+  std::cout << "结果已保存到 fixed_fanout_performance.csv" << std::endl;
+}
+
+int main() {
+  test_bplus_tree_fixed_fanout();
+  std::cout << "编译期阶数测试通过！" << std::endl;
+  return 0;
+}
@@ -0,0 +1,113 @@
+#include "../include/BplusTree.h" // 假设你的B+树类定义在此头文件中
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// 冻结测试：乱序插入随机的64位key建树后冻结成只读的Frozen，
+// 比较原树与冻结后的随机查询、短范围查询耗时以及占用的内存，并记录冻结耗时
+
+double elapsed_seconds(std::chrono::high_resolution_clock::time_point start) {
+  auto end_time = std::chrono::high_resolution_clock::now();
+  auto duration_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(end_time - start);
+  return duration_us.count() / 1e6;
+}
+
+struct Timing {
+  double search_seconds, range_seconds;
+};
+
+// 随机查询和范围查询(每次约100个key)，返回耗时并检查结果
+template <typename Index>
+Timing run_queries(Index &index, const std::vector<uint64_t> &sorted,
+                   const std::vector<size_t> &queries) {
+  Timing timing{};
+  uint64_t checksum = 0;
+  auto start_time = std::chrono::high_resolution_clock::now();
+  for (size_t q : queries) {
+    checksum += index.search(sorted[q]);
+  }
+  timing.search_seconds = elapsed_seconds(start_time);
+  uint64_t expected = 0;
+  for (size_t q : queries) {
+    expected += sorted[q] >> 32;
+  }
+  assert(checksum == expected);
+  (void)expected;
+
+  size_t scanned = 0;
+  start_time = std::chrono::high_resolution_clock::now();
+  for (size_t i = 0; i < queries.size() / 100; ++i) {
+    size_t q = std::min(queries[i], sorted.size() - 100);
+    scanned += index.rangeSearch(sorted[q], sorted[q + 99]).size();
+  }
+  timing.range_seconds = elapsed_seconds(start_time);
+  assert(scanned == queries.size() / 100 * 100);
+  (void)scanned;
+  return timing;
+}
+
+void test_bplus_tree_freeze() {
+  std::ofstream outFile("./freeze_performance.csv");
+  if (!outFile) {
+    std::cerr << "无法创建文件 freeze_performance.csv" << std::endl;
+    return;
+  }
+  outFile << "DataSize,Structure,SearchTime(s),RangeTime(s),FreezeTime(s),"
+             "MemoryBytes\n";
+
+  std::mt19937_64 rng(42);
+  for (size_t num_pairs : {100'000, 1'000'000, 4'000'000}) {
+    std::vector<uint64_t> keys(num_pairs);
+    for (uint64_t &key : keys) {
+      key = rng();
+    }
+    std::vector<uint64_t> sorted = keys;
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+    // value取key的高32位
+    BplusTree<uint64_t, uint64_t> tree(64);
+    for (uint64_t key : keys) {
+      tree.insert(key, key >> 32);
+    }
+    auto start_time = std::chrono::high_resolution_clock::now();
+    auto frozen = tree.freeze();
+    double freeze_seconds = elapsed_seconds(start_time);
+    assert(frozen.size() == sorted.size());
+
+    std::vector<size_t> queries(num_pairs);
+    std::uniform_int_distribution<size_t> pick(0, sorted.size() - 1);
+    for (size_t &q : queries) {
+      q = pick(rng);
+    }
+
+    Timing tree_timing = run_queries(tree, sorted, queries);
+    Timing frozen_timing = run_queries(frozen, sorted, queries);
+    for (const auto &[name, t, seconds, bytes] :
+         {std::make_tuple("tree", tree_timing, 0.0, tree.memoryUsage()),
+          std::make_tuple("frozen", frozen_timing, freeze_seconds,
+                          frozen.memoryUsage())}) {
+      std::cout << "数据量: " << num_pairs << " 结构: " << name
+                << " 查询: " << t.search_seconds
+                << " 秒 | 范围查询: " << t.range_seconds
+                << " 秒 | 冻结: " << seconds << " 秒 | 内存: " << bytes
+                << " 字节" << std::endl;
+      outFile << num_pairs << "," << name << "," << t.search_seconds << ","
+              << t.range_seconds << "," << seconds << "," << bytes << "\n";
+    }
+  }
+
+  outFile.close();
+  std::cout << "结果已保存到 freeze_performance.csv" << std::endl;
+}
+
+int main() {
+  test_bplus_tree_freeze();
+  std::cout << "冻结测试通过！" << std::endl;
+  return 0;
+}
@@ -0,0 +1,266 @@
+#include "../include/BplusTree.h" // 假设你的B+树类定义在此头文件中
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// 按需加载测试：构建不同规模的树并写入文件，
+// 比较完整反序列化与按需加载从打开文件到第一次查询返回的耗时，
+// 以及后台预热线程把整棵树加载完所需的时间，并检查查询结果正确
+// (包括预热期间并发的反向范围查询)
+
+double elapsed_seconds(std::chrono::high_resolution_clock::time_point start) {
+  auto end_time = std::chrono::high_resolution_clock::now();
+  auto duration_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(end_time - start);
+  return duration_us.count() / 1e6;
+}
+
+void test_bplus_tree_lazy_load() {
+  const std::string data_file = "./bplustree.dat";
+
+  std::ofstream outFile("./lazy_load_performance.csv");
+  if (!outFile) {
+    std::cerr << "无法创建文件 lazy_load_performance.csv" << std::endl;
+    return;
+  }
+  outFile << "DataSize,FullLoadFirstQuery(s),LazyFirstQuery(s),"
+             "WarmUpTime(s)\n";
+
+  std::mt19937 rng(42);
+  for (int num_pairs : {100'000, 1'000'000, 5'000'000}) {
+    {
+      BplusTree<int, uint64_t> tree(128);
+      for (int i = 0; i < num_pairs; ++i) {
+        tree.insert(i, static_cast<uint64_t>(i));
+      }
+      tree.serialize(data_file);
+    }
+    std::uniform_int_distribution<int> pick(0, num_pairs - 1);
+    int key = pick(rng);
+
+    // 完整反序列化：读入所有节点后才能查询
+    auto start_time = std::chrono::high_resolution_clock::now();
+    double full_seconds;
+    {
+      BplusTree<int, uint64_t> full(128);
+      full.deserialize(data_file);
+      uint64_t value = full.search(key);
+      full_seconds = elapsed_seconds(start_time);
+      assert(value == static_cast<uint64_t>(key));
+      (void)value;
+    }
+
+    // 按需加载：只读入根节点，查询路径上的节点在第一次访问时加载
+    start_time = std::chrono::high_resolution_clock::now();
+    double lazy_seconds;
+    {
+      BplusTree<int, uint64_t> lazy(128);
+      lazy.deserializeLazy(data_file);
+      uint64_t value = lazy.search(key);
+      lazy_seconds = elapsed_seconds(start_time);
+      assert(value == static_cast<uint64_t>(key));
+      (void)value;
+      assert(!lazy.fullyLoaded());
+      assert(lazy.rangeSearch(key, key + 1000).size() ==
+             static_cast<size_t>(std::min(1001, num_pairs - key)));
+    }
+
+    // 后台预热：打开后立即可查询，预热线程按key顺序加载其余节点
+    start_time = std::chrono::high_resolution_clock::now();
+    double warm_seconds;
+    {
+      BplusTree<int, uint64_t> warm(128);
+      warm.deserializeLazy(data_file, true);
+      uint64_t value = warm.search(key);
+      assert(value == static_cast<uint64_t>(key));
+      (void)value;
+      while (!warm.fullyLoaded()) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+      warm_seconds = elapsed_seconds(start_time);
+      assert(warm.rangeSearch(0, num_pairs).size() ==
+             static_cast<size_t>(num_pairs));
+    }
+
+    std::cout << "数据量: " << num_pairs
+              << " 完整加载后首次查询: " << full_seconds
+              << " 秒 | 按需加载首次查询: " << lazy_seconds
+              << " 秒 | 后台预热完成: " << warm_seconds << " 秒" << std::endl;
+    outFile << num_pairs << "," << full_seconds << "," << lazy_seconds << ","
+            << warm_seconds << "\n";
+  }
+
+  std::remove(data_file.c_str());
+  outFile.close();
+  std::cout << "结果已保存到 lazy_load_performance.csv" << std::endl;
+}
+
+// 预热期间并发反向范围查询：预热补上反向链接、随后全部读入时，
+// 正在读最左侧已读入叶子的反向扫描不能提前结束
+// 小阶数的树节点多，反复打开以覆盖预热结束的时刻
+void test_bplus_tree_lazy_reverse_scan() {
+  const std::string data_file = "./bplustree_reverse.dat";
+  const int num_pairs = 20'000;
+  {
+    BplusTree<int, uint64_t> tree(8);
+    for (int i = 0; i < num_pairs; ++i) {
+      tree.insert(i, static_cast<uint64_t>(i));
+    }
+    tree.serialize(data_file);
+  }
+
+  size_t short_scans = 0;
+  for (unsigned round = 0; round < 300; ++round) {
+    BplusTree<int, uint64_t> warm(8);
+    warm.deserializeLazy(data_file, true);
+    std::atomic<size_t> round_short{0};
+    std::vector<std::thread> readers;
+    for (unsigned t = 0; t < 4; ++t) {
+      readers.emplace_back([&, t] {
+        std::mt19937 rng(round * 4 + t);
+        std::uniform_int_distribution<int> pick(0, num_pairs - 1);
+        do {
+          int end_key = pick(rng);
+          int start_key = std::max(0, end_key - 200);
+          size_t expected = static_cast<size_t>(end_key - start_key + 1);
+          if (warm.reverseRangeSearch(start_key, end_key).size() != expected) {
+            ++round_short;
+          }
+        } while (!warm.fullyLoaded());
+      });
+    }
+    for (auto &reader : readers) {
+      reader.join();
+    }
+    short_scans += round_short;
+  }
+
+  std::remove(data_file.c_str());
+  std::cout << "预热期间并发反向范围查询提前结束次数: " << short_scans
+            << std::endl;
+  assert(short_scans == 0);
+}
+
+// 重复key：一串相同的key跨过多个叶子，按需加载后正向、反向范围查询
+// 沿链接读入相邻叶子时不能跳过与上次返回的key相等的副本
+void test_bplus_tree_lazy_duplicate_keys() {
+  const std::string data_file = "./bplustree_duplicate.dat";
+  const int dup_key = 500;
+  const size_t copies = 300;
+  const int num_keys = 1000;
+  {
+    BplusTree<int, uint64_t> tree(4);
+    for (size_t i = 0; i < copies; ++i) {
+      tree.insert(dup_key, i);
+    }
+    for (int key = 0; key < num_keys; ++key) {
+      if (key != dup_key) {
+        tree.insert(key, static_cast<uint64_t>(key));
+      }
+    }
+    tree.serialize(data_file);
+  }
+
+  const size_t total = num_keys - 1 + copies;
+  for (int scan = 0; scan < 4; ++scan) {
+    // 每次查询前重新打开，保证扫描沿途的叶子都还没读入
+    BplusTree<int, uint64_t> lazy(4);
+    lazy.deserializeLazy(data_file);
+    switch (scan) {
+    case 0:
+      assert(lazy.rangeSearch(0, num_keys).size() == total);
+      break;
+    case 1:
+      assert(lazy.rangeSearch(dup_key, dup_key).size() == copies);
+      break;
+    case 2:
+      assert(lazy.reverseRangeSearch(0, num_keys).size() == total);
+      break;
+    default:
+      assert(lazy.reverseRangeSearch(dup_key, dup_key).size() == copies);
+      break;
+    }
+  }
+  std::remove(data_file.c_str());
+}
+
+// 文件损坏：完整加载和按需加载都在发布新根之前抛出，原有的树保持不变，
+// 已读入的节点全部归还arena
+// 把num_keys个key写入文件后，用垃圾覆盖从文件长度的keep_fraction处到结尾
+void write_corrupt_file(const std::string &data_file, int num_keys,
+                        double keep_fraction) {
+  {
+    BplusTree<int, uint64_t> tree(8);
+    for (int i = 0; i < num_keys; ++i) {
+      tree.insert(i, static_cast<uint64_t>(i));
+    }
+    tree.serialize(data_file);
+  }
+  std::fstream file(data_file, std::ios::in | std::ios::out | std::ios::binary);
+  file.seekg(0, std::ios::end);
+  std::streamoff size = file.tellg();
+  std::streamoff keep = static_cast<std::streamoff>(size * keep_fraction);
+  std::vector<char> garbage(static_cast<size_t>(size - keep), '\xab');
+  file.seekp(keep);
+  file.write(garbage.data(), static_cast<std::streamsize>(garbage.size()));
+}
+
+void check_corrupt_open(const std::string &data_file, bool lazy) {
+  BplusTree<int, uint64_t> tree(8);
+  for (int i = 0; i < 100; ++i) {
+    tree.insert(i, static_cast<uint64_t>(i) * 3);
+  }
+  size_t nodes = tree.countNode();
+  size_t live = tree.allocStats().liveNodes;
+
+  bool threw = false;
+  try {
+    if (lazy) {
+      tree.deserializeLazy(data_file);
+    } else {
+      tree.deserialize(data_file);
+    }
+  } catch (const std::runtime_error &) {
+    threw = true;
+  }
+  assert(threw);
+  assert(tree.countNode() == nodes);
+  assert(tree.allocStats().liveNodes == live);
+  for (int i = 0; i < 100; ++i) {
+    assert(tree.search(i) == static_cast<uint64_t>(i) * 3);
+  }
+  (void)threw;
+  (void)nodes;
+  (void)live;
+}
+
+void test_bplus_tree_corrupt_file() {
+  const std::string data_file = "./bplustree_corrupt.dat";
+
+  // 完整加载：后半个文件损坏，加载到中途才发现，已加载的子树要释放
+  write_corrupt_file(data_file, 5'000, 0.5);
+  check_corrupt_open(data_file, false);
+
+  // 按需加载只读根节点：单个叶子的树(两个文件头页之后只有根页)，覆盖根页
+  write_corrupt_file(data_file, 5, 2.0 / 3.0);
+  check_corrupt_open(data_file, true);
+  check_corrupt_open(data_file, false);
+  std::remove(data_file.c_str());
+}
+
+int main() {
+  test_bplus_tree_lazy_load();
+  test_bplus_tree_lazy_reverse_scan();
+  test_bplus_tree_lazy_duplicate_keys();
+  test_bplus_tree_corrupt_file();
+  std::cout << "按需加载测试通过！" << std::endl;
+  return 0;
+}
@@ -0,0 +1,179 @@
+#include "../include/BplusTree.h" // 假设你的B+树类定义在此头文件中
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+// 学习索引测试：分别用均匀随机、连续、偏斜(对数正态分布，大量key挤在小值一端)
+// 的64位key建树，比较经由内部节点查找与启用学习索引后直接定位叶子的
+// 随机查询、批量查询耗时，并记录拟合出的段数；之后再乱序插入一批新key，
+// 测试学习索引随分裂维护后的查询耗时
+
+double elapsed_seconds(std::chrono::high_resolution_clock::time_point start) {
+  auto end_time = std::chrono::high_resolution_clock::now();
+  auto duration_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(end_time - start);
+  return duration_us.count() / 1e6;
+}
+
+// 生成num_pairs个互不相同的key
+std::vector<uint64_t> make_keys(const std::string &kind, size_t num_pairs,
+                                std::mt19937_64 &rng) {
+  std::vector<uint64_t> keys;
+  keys.reserve(num_pairs);
+  if (kind == "sequential") {
+    for (size_t i = 0; i < num_pairs; ++i) {
+      keys.push_back(1'000'000'000ULL + i * 8);
+    }
+    return keys;
+  }
+  std::lognormal_distribution<double> skewed(0.0, 2.0);
+  while (keys.size() < num_pairs) {
+    keys.push_back(kind == "uniform"
+                       ? rng() >> 1
+                       : static_cast<uint64_t>(skewed(rng) * 1e9));
+    if (keys.size() == num_pairs) {
+      std::sort(keys.begin(), keys.end());
+      keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    }
+  }
+  return keys;
+}
+
+struct Timing {
+  double search_seconds, multi_search_seconds;
+};
+
+// 随机查询和批量查询，检查结果正确
+Timing run_queries(BplusTree<uint64_t, uint64_t> &tree,
+                   const std::vector<uint64_t> &keys,
+                   const std::vector<size_t> &queries) {
+  Timing timing{};
+  uint64_t checksum = 0;
+  auto start_time = std::chrono::high_resolution_clock::now();
+  for (size_t q : queries) {
+    checksum += tree.search(keys[q]);
+  }
+  timing.search_seconds = elapsed_seconds(start_time);
+
+  std::vector<uint64_t> batch(queries.size()), out;
+  for (size_t i = 0; i < queries.size(); ++i) {
+    batch[i] = keys[queries[i]];
+  }
+  start_time = std::chrono::high_resolution_clock::now();
+  tree.multiSearch(batch, out);
+  timing.multi_search_seconds = elapsed_seconds(start_time);
+
+  // value为key的低32位
+  uint64_t expected = 0;
+  for (size_t q : queries) {
+    expected += keys[q] & 0xffffffffULL;
+  }
+  assert(checksum == expected);
+  for (size_t i = 0; i < out.size(); ++i) {
+    assert(out[i] == (batch[i] & 0xffffffffULL));
+  }
+  (void)expected;
+  return timing;
+}
+
+void test_bplus_tree_learned_index() {
+  std::ofstream outFile("./learned_index_performance.csv");
+  if (!outFile) {
+    std::cerr << "无法创建文件 learned_index_performance.csv" << std::endl;
+    return;
+  }
+  outFile << "KeyKind,Phase,Router,DataSize,SearchTime(s),"
+             "MultiSearchTime(s),Segments\n";
+
+  std::mt19937_64 rng(42);
+  const size_t num_pairs = 1'000'000;
+  const size_t extra_pairs = 200'000;
+  for (const std::string kind : {"uniform", "sequential", "skewed"}) {
+    std::vector<uint64_t> keys = make_keys(kind, num_pairs + extra_pairs, rng);
+    std::shuffle(keys.begin(), keys.end(), rng);
+
+    // 先乱序插入前num_pairs个key
+    BplusTree<uint64_t, uint64_t> tree(64);
+    for (size_t i = 0; i < num_pairs; ++i) {
+      tree.insert(keys[i], keys[i] & 0xffffffffULL);
+    }
+    std::vector<size_t> queries(num_pairs);
+    std::uniform_int_distribution<size_t> pick(0, num_pairs - 1);
+    for (size_t &q : queries) {
+      q = pick(rng);
+    }
+
+    auto report = [&](const std::string &phase, const std::string &router,
+                      size_t size, const Timing &t) {
+      std::cout << "key类型: " << kind << " 阶段: " << phase
+                << " 路由: " << router << " 数据量: " << size
+                << " 查询: " << t.search_seconds
+                << " 秒 | 批量查询: " << t.multi_search_seconds
+                << " 秒 | 段数: " << tree.learnedSegments() << std::endl;
+      outFile << kind << "," << phase << "," << router << "," << size << ","
+              << t.search_seconds << "," << t.multi_search_seconds << ","
+              << tree.learnedSegments() << "\n";
+    };
+
+    report("build", "classic", num_pairs, run_queries(tree, keys, queries));
+    tree.enableLearnedIndex();
+    report("build", "learned", num_pairs, run_queries(tree, keys, queries));
+
+    // 启用后继续插入，学习索引随叶子分裂维护
+    for (size_t i = num_pairs; i < num_pairs + extra_pairs; ++i) {
+      tree.insert(keys[i], keys[i] & 0xffffffffULL);
+    }
+    std::uniform_int_distribution<size_t> pick_all(
+        0, num_pairs + extra_pairs - 1);
+    for (size_t &q : queries) {
+      q = pick_all(rng);
+    }
+    report("grown", "learned", num_pairs + extra_pairs,
+           run_queries(tree, keys, queries));
+    tree.disableLearnedIndex();
+    report("grown", "classic", num_pairs + extra_pairs,
+           run_queries(tree, keys, queries));
+  }
+
+  outFile.close();
+  std::cout << "结果已保存到 learned_index_performance.csv" << std::endl;
+}
+
+// 最小的key：多个叶子的下界都是它，正向查找不能从最后一个这样的叶子开始
+template <typename keyType> void test_learned_index_min_key() {
+  const keyType min_key = std::numeric_limits<keyType>::min();
+  const size_t copies = 20;
+  BplusTree<keyType, uint64_t> tree(4);
+  tree.enableLearnedIndex();
+  for (size_t i = 0; i < copies; ++i) {
+    tree.insert(min_key, i);
+  }
+  for (keyType key = min_key + 1; key < min_key + 10; ++key) {
+    tree.insert(key, static_cast<uint64_t>(key - min_key));
+  }
+
+  assert(tree.rangeSearch(min_key, min_key).size() == copies);
+  assert(tree.reverseRangeSearch(min_key, min_key).size() == copies);
+  assert(tree.rangeSearch(min_key, min_key + 9).size() == copies + 9);
+  for (size_t i = 0; i < copies; ++i) {
+    bool removed = tree.remove(min_key);
+    assert(removed);
+    (void)removed;
+  }
+  assert(tree.rangeSearch(min_key, min_key).empty());
+}
+
+int main() {
+  test_learned_index_min_key<uint64_t>();
+  test_learned_index_min_key<int>();
+  test_bplus_tree_learned_index();
+  std::cout << "学习索引测试通过！" << std::endl;
+  return 0;
+}
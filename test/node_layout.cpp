@@ -0,0 +1,264 @@
+#include "../include/BplusTree.h" // 假设你的B+树类定义在此头文件中
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// 节点布局测试：同样的键值对分别放入Compact和CacheAligned布局的树，
+// 比较随机查询的耗时、每次查询的L1数据缓存缺失和末级缓存缺失次数
+// (Linux下用perf_event_open读硬件计数器，不可用时记为-1)以及每个键值对
+// 占用的内存；另按节点布局模拟访问一个叶子触及的缓存行数(不依赖计数器)
+
+double elapsed_seconds(std::chrono::high_resolution_clock::time_point start) {
+  auto end_time = std::chrono::high_resolution_clock::now();
+  auto duration_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(end_time - start);
+  return duration_us.count() / 1e6;
+}
+
+// 硬件事件计数器(只统计本线程用户态)
+class CacheCounter {
+private:
+  int fd = -1;
+
+public:
+  CacheCounter(uint32_t type, uint64_t config) {
+#if defined(__linux__)
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+    (void)type;
+    (void)config;
+#endif
+  }
+  ~CacheCounter() {
+#if defined(__linux__)
+    if (fd >= 0) {
+      close(fd);
+    }
+#endif
+  }
+  CacheCounter(const CacheCounter &) = delete;
+  CacheCounter &operator=(const CacheCounter &) = delete;
+
+  void start() {
+#if defined(__linux__)
+    if (fd >= 0) {
+      ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  // 停止计数并返回事件次数(不可用时返回-1)
+  long long stop() {
+#if defined(__linux__)
+    if (fd >= 0) {
+      ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+      long long count = 0;
+      if (read(fd, &count, sizeof(count)) == sizeof(count)) {
+        return count;
+      }
+    }
+#endif
+    return -1;
+  }
+};
+
+struct Result {
+  double search_seconds;
+  double l1_misses, llc_misses; // 每次查询
+  double bytes_per_entry;
+  double leaf_lines; // 模拟的每个叶子触及的缓存行数
+};
+
+// 模拟查找一个叶子触及的缓存行：读节点头(版本锁、key个数、上界和value
+// 数组的位置)，按NodeSearch.h的内核读key(key数组从缓存行起点开始时按行二分，
+// 否则无分支二分、收缩到一条缓存行的key后顺序计数)，命中后读value；
+// 槽位起点相对缓存行的偏移随槽位编号变化
+double simulate_leaf_lines(size_t order, NodeLayout layout,
+                           std::mt19937_64 &rng) {
+  using Leaf = LeafNode<uint64_t, uint64_t>;
+  const size_t capacity = order;
+  const size_t slot_bytes = NodeArena(std::max(
+      Leaf::slotSize(capacity, sizeof(uint64_t), layout),
+      InterNode<uint64_t, uint64_t>::slotSize(capacity, sizeof(uint64_t),
+                                              layout)),
+      layout == NodeLayout::CacheAligned ? CACHE_LINE
+                                         : NodeArena::SLOT_ALIGN)
+                                .slotSize();
+  const size_t keys_at = NodeArena::LATCH_BYTES + Leaf::keysOffset(layout);
+  const size_t values_at =
+      NodeArena::LATCH_BYTES +
+      Leaf::valuesOffset(capacity, sizeof(uint64_t), layout);
+  const size_t window = searchWindow<uint64_t>();
+
+  const size_t trials = 100'000;
+  std::uniform_int_distribution<size_t> fill((order + 1) / 2, order - 1);
+  size_t total = 0;
+  std::vector<size_t> lines;
+  for (size_t t = 0; t < trials; ++t) {
+    size_t shift = (t * slot_bytes) % CACHE_LINE;
+    size_t n = fill(rng);
+    size_t target = std::uniform_int_distribution<size_t>(0, n - 1)(rng);
+    lines.clear();
+    auto touch = [&](size_t offset, size_t bytes) {
+      for (size_t line = (shift + offset) / CACHE_LINE;
+           line <= (shift + offset + bytes - 1) / CACHE_LINE; ++line) {
+        lines.push_back(line);
+      }
+    };
+    touch(0, NodeArena::LATCH_BYTES + sizeof(Node<uint64_t, uint64_t>) +
+                 sizeof(FixedVector<uint64_t>));
+    if ((shift + keys_at) % CACHE_LINE == 0) {
+      // 按行二分：比较每行的最后一个key
+      size_t lines = (n + window - 1) / window;
+      auto last = [&](size_t j) { return std::min((j + 1) * window, n) - 1; };
+      size_t base = 0, len = lines;
+      while (len > 1) {
+        size_t half = len / 2;
+        touch(keys_at + last(base + half - 1) * sizeof(uint64_t),
+              sizeof(uint64_t));
+        base = last(base + half - 1) < target ? base + half : base;
+        len -= half;
+      }
+      touch(keys_at + last(base) * sizeof(uint64_t), sizeof(uint64_t));
+      base += last(base) < target;
+      touch(keys_at + base * window * sizeof(uint64_t),
+            (std::min(window, n - base * window)) * sizeof(uint64_t));
+    } else {
+      size_t base = 0, len = n;
+      while (len > window) {
+        size_t half = len / 2;
+        touch(keys_at + (base + half) * sizeof(uint64_t), sizeof(uint64_t));
+        base = base + half < target ? base + half : base;
+        len -= half;
+      }
+      touch(keys_at + base * sizeof(uint64_t), len * sizeof(uint64_t));
+    }
+    touch(values_at + target * sizeof(uint64_t), sizeof(uint64_t));
+    std::sort(lines.begin(), lines.end());
+    total += static_cast<size_t>(
+        std::unique(lines.begin(), lines.end()) - lines.begin());
+  }
+  return static_cast<double>(total) / static_cast<double>(trials);
+}
+
+Result run_case(size_t order, NodeLayout layout,
+                const std::vector<uint64_t> &keys,
+                const std::vector<size_t> &queries) {
+  Result result{};
+  BplusTree<uint64_t, uint64_t> tree(order, true, sizeof(uint64_t), layout);
+  for (uint64_t key : keys) {
+    tree.insert(key, key / 2);
+  }
+  result.bytes_per_entry = static_cast<double>(tree.memoryUsage()) /
+                           static_cast<double>(keys.size());
+
+#if defined(__linux__)
+  CacheCounter l1(PERF_TYPE_HW_CACHE,
+                  PERF_COUNT_HW_CACHE_L1D |
+                      (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+  CacheCounter llc(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+#else
+  CacheCounter l1(0, 0), llc(0, 0);
+#endif
+
+  uint64_t checksum = 0;
+  l1.start();
+  llc.start();
+  auto start_time = std::chrono::high_resolution_clock::now();
+  for (size_t q : queries) {
+    checksum += tree.search(keys[q]);
+  }
+  result.search_seconds = elapsed_seconds(start_time);
+  long long l1_count = l1.stop();
+  long long llc_count = llc.stop();
+
+  uint64_t expected = 0;
+  for (size_t q : queries) {
+    expected += keys[q] / 2;
+  }
+  assert(checksum == expected);
+  (void)expected;
+
+  double lookups = static_cast<double>(queries.size());
+  result.l1_misses =
+      l1_count < 0 ? -1 : static_cast<double>(l1_count) / lookups;
+  result.llc_misses =
+      llc_count < 0 ? -1 : static_cast<double>(llc_count) / lookups;
+
+  std::mt19937_64 rng(order);
+  result.leaf_lines = simulate_leaf_lines(order, layout, rng);
+  return result;
+}
+
+void test_bplus_tree_node_layout() {
+  std::ofstream outFile("./node_layout_performance.csv");
+  if (!outFile) {
+    std::cerr << "无法创建文件 node_layout_performance.csv" << std::endl;
+    return;
+  }
+  outFile << "Order,Layout,DataSize,SearchTime(s),L1MissesPerLookup,"
+             "LLCMissesPerLookup,LinesPerLeaf,BytesPerEntry\n";
+
+  std::mt19937_64 rng(42);
+  const size_t num_pairs = 2'000'000;
+  std::vector<uint64_t> keys(num_pairs);
+  for (uint64_t &key : keys) {
+    key = rng();
+  }
+  std::vector<size_t> queries(num_pairs);
+  std::uniform_int_distribution<size_t> pick(0, num_pairs - 1);
+  for (size_t &q : queries) {
+    q = pick(rng);
+  }
+
+  for (size_t order : {32, 64, 256}) {
+    for (const auto &[name, layout] :
+         {std::make_pair("compact", NodeLayout::Compact),
+          std::make_pair("cache_aligned", NodeLayout::CacheAligned)}) {
+      Result r = run_case(order, layout, keys, queries);
+      std::cout << "阶数: " << order << " 布局: " << name
+                << " 数据量: " << num_pairs << " 查询: " << r.search_seconds
+                << " 秒 | 每次查询L1缺失: " << r.l1_misses
+                << " | 每次查询末级缓存缺失: " << r.llc_misses
+                << " | 每个叶子触及缓存行: " << r.leaf_lines
+                << " | 每个键值对: " << r.bytes_per_entry << " 字节"
+                << std::endl;
+      outFile << order << "," << name << "," << num_pairs << ","
+              << r.search_seconds << "," << r.l1_misses << "," << r.llc_misses
+              << "," << r.leaf_lines << "," << r.bytes_per_entry << "\n";
+    }
+  }
+
+  outFile.close();
+  std::cout << "结果已保存到 node_layout_performance.csv" << std::endl;
+}
+
+int main() {
+  test_bplus_tree_node_layout();
+  std::cout << "节点布局测试通过！" << std::endl;
+  return 0;
+}
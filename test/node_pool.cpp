@@ -0,0 +1,97 @@
+#include "../include/BplusTree.h" // 假设你的B+树类定义在此头文件中
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// 节点复用测试：建树后反复删除大部分key(合并释放节点)再插回(分裂申请节点)，
+// 记录每一轮的删除、插入耗时，节点分配命中空闲链表的比例以及节点存储占用的
+// 内存(槽位被复用时不再增长)
+
+double elapsed_seconds(std::chrono::high_resolution_clock::time_point start) {
+  auto end_time = std::chrono::high_resolution_clock::now();
+  auto duration_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(end_time - start);
+  return duration_us.count() / 1e6;
+}
+
+void test_bplus_tree_node_pool() {
+  std::ofstream outFile("./node_pool_performance.csv");
+  if (!outFile) {
+    std::cerr << "无法创建文件 node_pool_performance.csv" << std::endl;
+    return;
+  }
+  outFile << "Order,Round,RemoveTime(s),InsertTime(s),Hits,Misses,HitRate,"
+             "MemoryBytes\n";
+
+  const size_t num_pairs = 2'000'000;
+  const size_t rounds = 4;
+  std::mt19937_64 rng(42);
+  std::vector<uint64_t> keys(num_pairs);
+  for (size_t i = 0; i < num_pairs; ++i) {
+    keys[i] = i * 8;
+  }
+
+  for (size_t order : {8, 64}) {
+    using Tree = BplusTree<uint64_t, uint64_t>;
+    Tree tree(order);
+    std::shuffle(keys.begin(), keys.end(), rng);
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (uint64_t key : keys) {
+      tree.insert(key, key + 1);
+    }
+    double insert_seconds = elapsed_seconds(start_time);
+    double remove_seconds = 0;
+
+    Tree::NodeAllocStats last{};
+    for (size_t round = 0; round <= rounds; ++round) {
+      // 第0轮为建树，之后每轮删除九成key再乱序插回
+      if (round > 0) {
+        std::shuffle(keys.begin(), keys.end(), rng);
+        const size_t removed = num_pairs / 10 * 9;
+        start_time = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < removed; ++i) {
+          tree.remove(keys[i]);
+        }
+        remove_seconds = elapsed_seconds(start_time);
+        start_time = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < removed; ++i) {
+          tree.insert(keys[i], keys[i] + 1);
+        }
+        insert_seconds = elapsed_seconds(start_time);
+      }
+      assert(tree.search(keys[round]) == keys[round] + 1);
+
+      // 只统计本轮的分配
+      Tree::NodeAllocStats stats = tree.allocStats();
+      Tree::NodeAllocStats delta{stats.hits - last.hits,
+                                 stats.misses - last.misses,
+                                 stats.releases - last.releases,
+                                 stats.liveNodes,
+                                 stats.freeSlots,
+                                 stats.retiredNodes};
+      last = stats;
+      std::cout << "阶数: " << order << " 轮次: " << round
+                << " 删除: " << remove_seconds
+                << " 秒 | 插入: " << insert_seconds
+                << " 秒 | 命中: " << delta.hits << " | 未命中: " << delta.misses
+                << " | 命中率: " << delta.hitRate()
+                << " | 内存: " << tree.memoryUsage() << " 字节" << std::endl;
+      outFile << order << "," << round << "," << remove_seconds << ","
+              << insert_seconds << "," << delta.hits << "," << delta.misses
+              << "," << delta.hitRate() << "," << tree.memoryUsage() << "\n";
+    }
+  }
+
+  outFile.close();
+  std::cout << "结果已保存到 node_pool_performance.csv" << std::endl;
+}
+
+int main() {
+  test_bplus_tree_node_pool();
+  std::cout << "节点复用测试通过！" << std::endl;
+  return 0;
+}
@@ -0,0 +1,122 @@
+#include "../include/BplusTree.h" // 假设你的B+树类定义在此头文件中
+#include <cassert>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+// 范围扫描测试：在2000万键的树上分别测量
+// 1.rangeSearch短范围查询(到endKey即停止)
+// 2.游标nextN按不同批大小流式扫描长范围(不分配内存)
+// 3.反向游标按批大小256从大到小扫描全树
+
+double elapsed_seconds(std::chrono::high_resolution_clock::time_point start) {
+  auto end_time = std::chrono::high_resolution_clock::now();
+  auto duration_ms =
+      std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start);
+  return duration_ms.count() / 1000.0;
+}
+
+void test_bplus_tree_range_scan() {
+  const int num_pairs = 20'000'000;  // 2000万
+  const int num_ranges = 1'000'000;  // 短范围查询次数
+  const int range_width = 20;        // 每次覆盖10个键(键为奇数)
+  const int scan_length = 1'000'000; // 长范围扫描的键数
+
+  std::vector<std::pair<int, int>> pairs(num_pairs);
+  for (int i = 0; i < num_pairs; ++i) {
+    pairs[i] = {2 * i + 1, i + 1};
+  }
+  BplusTree<int, int> tree(64);
+  tree.bulkLoad(pairs.begin(), pairs.end());
+  std::cout << "已构建 " << num_pairs << " 个键值对" << std::endl;
+
+  std::ofstream outFile("./range_scan_performance.csv");
+  if (!outFile) {
+    std::cerr << "无法创建文件 range_scan_performance.csv" << std::endl;
+    return;
+  }
+  outFile << "Method,BatchSize,TotalTime(s),PairsPerSecond\n";
+
+  // 短范围查询
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<> key_dist(1, 2 * num_pairs);
+  long total_pairs = 0;
+  auto start_time = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < num_ranges; ++i) {
+    int start_key = key_dist(gen);
+    auto result = tree.rangeSearch(start_key, start_key + range_width - 1);
+    total_pairs += static_cast<long>(result.size());
+  }
+  double range_seconds = elapsed_seconds(start_time);
+  std::cout << "短范围查询 " << num_ranges << " 次 总耗时: " << range_seconds
+            << " 秒 返回键值对: " << total_pairs << std::endl;
+  outFile << "rangeSearch,-," << range_seconds << ","
+          << static_cast<long>(total_pairs / range_seconds) << "\n";
+
+  // 游标流式扫描
+  for (size_t batch_size : {1, 16, 256}) {
+    std::vector<int> keys(batch_size);
+    std::vector<int> values(batch_size);
+    BplusTree<int, int>::Cursor cursor(tree);
+    long scanned = 0;
+    long checksum = 0;
+    start_time = std::chrono::high_resolution_clock::now();
+    for (int first = 1; first < 2 * num_pairs; first += 2 * scan_length) {
+      cursor.seek(first, first + 2 * scan_length - 1);
+      while (size_t count =
+                 cursor.nextN(keys.data(), values.data(), batch_size)) {
+        for (size_t i = 0; i < count; ++i) {
+          checksum += values[i];
+        }
+        scanned += static_cast<long>(count);
+      }
+    }
+    double scan_seconds = elapsed_seconds(start_time);
+    assert(scanned == num_pairs);
+    assert(checksum == static_cast<long>(num_pairs) * (num_pairs + 1) / 2);
+
+    std::cout << "游标扫描 批大小: " << batch_size
+              << " 总耗时: " << scan_seconds << " 秒 每秒键值对: "
+              << static_cast<long>(scanned / scan_seconds) << std::endl;
+    outFile << "cursor," << batch_size << "," << scan_seconds << ","
+            << static_cast<long>(scanned / scan_seconds) << "\n";
+  }
+
+  // 反向游标扫描
+  {
+    const size_t batch_size = 256;
+    std::vector<int> keys(batch_size);
+    std::vector<int> values(batch_size);
+    BplusTree<int, int>::ReverseCursor cursor(tree);
+    long scanned = 0;
+    int last_key = 2 * num_pairs + 1;
+    start_time = std::chrono::high_resolution_clock::now();
+    cursor.seek(2 * num_pairs, 1);
+    while (size_t count =
+               cursor.nextN(keys.data(), values.data(), batch_size)) {
+      assert(keys[0] < last_key);
+      last_key = keys[count - 1];
+      scanned += static_cast<long>(count);
+    }
+    double scan_seconds = elapsed_seconds(start_time);
+    assert(scanned == num_pairs);
+
+    std::cout << "反向游标扫描 批大小: " << batch_size
+              << " 总耗时: " << scan_seconds << " 秒 每秒键值对: "
+              << static_cast<long>(scanned / scan_seconds) << std::endl;
+    outFile << "reverseCursor," << batch_size << "," << scan_seconds << ","
+            << static_cast<long>(scanned / scan_seconds) << "\n";
+  }
+
+  outFile.close();
+  std::cout << "结果已保存到 range_scan_performance.csv" << std::endl;
+}
+
+int main() {
+  test_bplus_tree_range_scan();
+  std::cout << "范围扫描测试通过！" << std::endl;
+  return 0;
+}
@@ -0,0 +1,111 @@
+#include "../include/NodeSearch.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// 节点内查找内核对比：原有顺序扫描 / std::upper_bound / 无分支二分 / SIMD
+// 每个度数生成一批有序key数组(模拟内部节点)，随机探测并统计每次查找的平均耗时
+
+template <typename K, typename Fn>
+double time_kernel(const std::vector<std::vector<K>> &nodes,
+                   const std::vector<K> &probes, Fn kernel, size_t &checksum) {
+  auto start_time = std::chrono::high_resolution_clock::now();
+  size_t sum = 0;
+  for (size_t i = 0; i < probes.size(); ++i) {
+    const auto &node = nodes[i % nodes.size()];
+    sum += kernel(node.data(), node.size(), probes[i]);
+  }
+  auto end_time = std::chrono::high_resolution_clock::now();
+  checksum += sum;
+  return std::chrono::duration<double, std::nano>(end_time - start_time)
+             .count() /
+         static_cast<double>(probes.size());
+}
+
+template <typename K>
+void bench_key_type(const std::string &typeName, std::ofstream &outFile) {
+  const int num_nodes = 4096;     // 每个度数的节点数
+  const int num_probes = 4'000'000; // 每个内核的查找次数
+  std::mt19937_64 gen(42);
+  std::uniform_int_distribution<uint64_t> key_dist(1, 1'000'000'000);
+
+  for (int degree : {4, 8, 16, 32, 64, 128, 256}) {
+    // 生成节点(degree - 1个有序key)
+    std::vector<std::vector<K>> nodes(num_nodes);
+    for (auto &node : nodes) {
+      node.resize(degree - 1);
+      for (auto &key : node) {
+        key = static_cast<K>(key_dist(gen));
+      }
+      std::sort(node.begin(), node.end());
+    }
+    std::vector<K> probes(num_probes);
+    for (auto &probe : probes) {
+      probe = static_cast<K>(key_dist(gen));
+    }
+
+    size_t checksum = 0;
+    double linear = time_kernel(
+        nodes, probes,
+        [](const K *keys, size_t n, const K &key) {
+          return linearUpperBound(keys, n, key);
+        },
+        checksum);
+    double stdBound = time_kernel(
+        nodes, probes,
+        [](const K *keys, size_t n, const K &key) {
+          return static_cast<size_t>(std::upper_bound(keys, keys + n, key) -
+                                     keys);
+        },
+        checksum);
+    double branchless = time_kernel(
+        nodes, probes,
+        [](const K *keys, size_t n, const K &key) {
+          return branchlessRank<true>(keys, n, key, 1);
+        },
+        checksum);
+    double simd = time_kernel(
+        nodes, probes,
+        [](const K *keys, size_t n, const K &key) {
+          return nodeUpperBound(keys, n, key);
+        },
+        checksum);
+
+    std::cout << typeName << " 度数: " << degree << "  顺序: " << linear
+              << " ns  std::upper_bound: " << stdBound
+              << " ns  无分支二分: " << branchless << " ns  SIMD: " << simd
+              << " ns  (checksum " << checksum << ")" << std::endl;
+    outFile << typeName << "," << degree << "," << linear << "," << stdBound
+            << "," << branchless << "," << simd << "\n";
+  }
+}
+
+int main() {
+  std::ofstream outFile("./search_kernel_performance.csv");
+  if (!outFile) {
+    std::cerr << "无法创建文件 search_kernel_performance.csv" << std::endl;
+    return 1;
+  }
+  outFile << "KeyType,Degree,Linear(ns),StdUpperBound(ns),Branchless(ns),"
+             "Simd(ns)\n";
+
+#if defined(__AVX2__)
+  std::cout << "SIMD: AVX2" << std::endl;
+#elif defined(__SSE4_2__)
+  std::cout << "SIMD: SSE4.2" << std::endl;
+#else
+  std::cout << "SIMD: SSE2/标量" << std::endl;
+#endif
+
+  bench_key_type<int>("int", outFile);
+  bench_key_type<uint64_t>("uint64_t", outFile);
+
+  outFile.close();
+  std::cout << "结果已保存到 search_kernel_performance.csv" << std::endl;
+  return 0;
+}
@@ -0,0 +1,114 @@
+#include "../include/BplusTree.h" // 假设你的B+树类定义在此头文件中
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+// 只读快照测试：在2000万键的树上测量
+// 1.saveSnapshot写出快照的耗时
+// 2.打开快照(mmap)的耗时(与树的大小无关)
+// 3.快照原地查找/范围查找与内存中的树对比
+
+double elapsed_seconds(std::chrono::high_resolution_clock::time_point start) {
+  auto end_time = std::chrono::high_resolution_clock::now();
+  auto duration_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(end_time - start);
+  return duration_us.count() / 1e6;
+}
+
+void test_bplus_tree_snapshot() {
+  const int num_pairs = 20'000'000; // 2000万
+  const int num_queries = 1'000'000;
+  const int num_ranges = 100'000;
+  const std::string filename = "./bplustree.snap";
+
+  std::vector<std::pair<int, uint64_t>> pairs(num_pairs);
+  for (int i = 0; i < num_pairs; ++i) {
+    pairs[i] = {2 * i + 1, static_cast<uint64_t>(i) + 1};
+  }
+  BplusTree<int, uint64_t> tree(64);
+  tree.bulkLoad(pairs.begin(), pairs.end());
+  std::cout << "已构建 " << num_pairs << " 个键值对" << std::endl;
+
+  std::ofstream outFile("./snapshot_performance.csv");
+  if (!outFile) {
+    std::cerr << "无法创建文件 snapshot_performance.csv" << std::endl;
+    return;
+  }
+  outFile << "Operation,TotalTime(s),OpsPerSecond\n";
+
+  auto start_time = std::chrono::high_resolution_clock::now();
+  tree.saveSnapshot(filename);
+  double save_seconds = elapsed_seconds(start_time);
+  std::cout << "写出快照 总耗时: " << save_seconds << " 秒" << std::endl;
+  outFile << "saveSnapshot," << save_seconds << ",-\n";
+
+  start_time = std::chrono::high_resolution_clock::now();
+  BplusTree<int, uint64_t>::Snapshot snapshot(filename);
+  double open_seconds = elapsed_seconds(start_time);
+  assert(snapshot.size() == static_cast<size_t>(num_pairs));
+  std::cout << "打开快照 总耗时: " << open_seconds * 1000 << " 毫秒"
+            << std::endl;
+  outFile << "openSnapshot," << open_seconds << ",-\n";
+
+  // 随机查找(一半命中)
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<> key_dist(1, 2 * num_pairs);
+  std::vector<int> queries(num_queries);
+  for (auto &key : queries) {
+    key = key_dist(gen);
+  }
+
+  uint64_t tree_sum = 0;
+  start_time = std::chrono::high_resolution_clock::now();
+  for (int key : queries) {
+    tree_sum += tree.search(key);
+  }
+  double tree_seconds = elapsed_seconds(start_time);
+
+  uint64_t snapshot_sum = 0;
+  start_time = std::chrono::high_resolution_clock::now();
+  for (int key : queries) {
+    snapshot_sum += snapshot.search(key);
+  }
+  double snapshot_seconds = elapsed_seconds(start_time);
+  assert(tree_sum == snapshot_sum);
+
+  std::cout << "随机查找 " << num_queries << " 次 树: " << tree_seconds
+            << " 秒 快照: " << snapshot_seconds << " 秒" << std::endl;
+  outFile << "treeSearch," << tree_seconds << ","
+          << static_cast<long>(num_queries / tree_seconds) << "\n";
+  outFile << "snapshotSearch," << snapshot_seconds << ","
+          << static_cast<long>(num_queries / snapshot_seconds) << "\n";
+
+  // 短范围查询
+  size_t total_pairs = 0;
+  start_time = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < num_ranges; ++i) {
+    int start_key = queries[i];
+    int end_key = start_key + 199;
+    auto result = snapshot.rangeSearch(start_key, end_key);
+    assert(result == tree.rangeSearch(start_key, end_key));
+    total_pairs += result.size();
+  }
+  double range_seconds = elapsed_seconds(start_time);
+  std::cout << "快照范围查询 " << num_ranges << " 次(含树上核对) 总耗时: "
+            << range_seconds << " 秒 返回键值对: " << total_pairs
+            << std::endl;
+  outFile << "snapshotRange(checked)," << range_seconds << ","
+          << static_cast<long>(num_ranges / range_seconds) << "\n";
+
+  outFile.close();
+  std::remove(filename.c_str());
+  std::cout << "结果已保存到 snapshot_performance.csv" << std::endl;
+}
+
+int main() {
+  test_bplus_tree_snapshot();
+  std::cout << "快照测试通过！" << std::endl;
+  return 0;
+}
@@ -0,0 +1,123 @@
+#include "../include/BplusTree.h" // 假设你的B+树类定义在此头文件中
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 变长字符串key测试：key为长度不一的字符串(带公共前缀的用户名和随机后缀，
+// 以及少数几个站点下的URL，节点内公共前缀长、分隔key可以截得很短)，
+// 测试乱序插入、随机查询以及写入文件后重新加载的耗时，并检查结果正确
+
+double elapsed_seconds(std::chrono::high_resolution_clock::time_point start) {
+  auto end_time = std::chrono::high_resolution_clock::now();
+  auto duration_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(end_time - start);
+  return duration_us.count() / 1e6;
+}
+
+// 第i个key：user:<i>:<0~15个随机字母>
+// 或 https://<4个站点之一>/<i>/<0~15个随机字母>
+std::string make_key(const std::string &kind, int i, std::mt19937 &rng) {
+  static const char *sites[] = {"www.example.com/", "static.example.com/",
+                                "api.example.org/v2/", "blog.example.net/"};
+  std::string key = kind == "user" ? "user:" + std::to_string(i) + ":"
+                                   : std::string("https://") +
+                                         sites[rng() % 4] +
+                                         std::to_string(i) + "/";
+  size_t extra = rng() % 16;
+  for (size_t j = 0; j < extra; ++j) {
+    key.push_back(static_cast<char>('a' + rng() % 26));
+  }
+  return key;
+}
+
+void test_bplus_tree_string_keys() {
+  const std::string data_file = "./bplustree.dat";
+
+  std::ofstream outFile("./string_keys_performance.csv");
+  if (!outFile) {
+    std::cerr << "无法创建文件 string_keys_performance.csv" << std::endl;
+    return;
+  }
+  outFile << "KeyKind,DataSize,InsertTime(s),SearchTime(s),SerializeTime(s),"
+             "DeserializeTime(s)\n";
+
+  std::mt19937 rng(42);
+  const std::pair<std::string, int> cases[] = {{"user", 100'000},
+                                               {"user", 1'000'000},
+                                               {"url", 100'000},
+                                               {"url", 1'000'000}};
+  for (const auto &[kind, num_pairs] : cases) {
+    std::vector<std::string> keys;
+    keys.reserve(num_pairs);
+    for (int i = 0; i < num_pairs; ++i) {
+      keys.push_back(make_key(kind, i, rng));
+    }
+    std::shuffle(keys.begin(), keys.end(), rng);
+
+    // 乱序插入，value为key在数组中的下标
+    BplusTree<std::string, uint64_t> tree(128, true, 64);
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < num_pairs; ++i) {
+      tree.insert(keys[i], static_cast<uint64_t>(i));
+    }
+    double insert_seconds = elapsed_seconds(start_time);
+
+    // 随机查询
+    std::uniform_int_distribution<int> pick(0, num_pairs - 1);
+    std::vector<int> queries(num_pairs);
+    for (int &q : queries) {
+      q = pick(rng);
+    }
+    uint64_t checksum = 0;
+    start_time = std::chrono::high_resolution_clock::now();
+    for (int q : queries) {
+      checksum += tree.search(keys[q]);
+    }
+    double search_seconds = elapsed_seconds(start_time);
+    uint64_t expected = 0;
+    for (int q : queries) {
+      expected += static_cast<uint64_t>(q);
+    }
+    assert(checksum == expected);
+    (void)expected;
+
+    // 写入文件后重新加载，检查顺序扫描结果一致
+    start_time = std::chrono::high_resolution_clock::now();
+    tree.serialize(data_file);
+    double serialize_seconds = elapsed_seconds(start_time);
+
+    BplusTree<std::string, uint64_t> loaded(128, true, 64);
+    start_time = std::chrono::high_resolution_clock::now();
+    loaded.deserialize(data_file);
+    double deserialize_seconds = elapsed_seconds(start_time);
+    auto all = loaded.rangeSearch("", "~");
+    assert(all.size() == static_cast<size_t>(num_pairs));
+    assert(std::is_sorted(all.begin(), all.end()));
+    assert(loaded.search(keys[0]) == 0);
+
+    std::cout << "key类型: " << kind << " 数据量: " << num_pairs
+              << " 插入: " << insert_seconds << " 秒 | 查询: " << search_seconds
+              << " 秒 | 写入文件: " << serialize_seconds
+              << " 秒 | 加载: " << deserialize_seconds << " 秒" << std::endl;
+    outFile << kind << "," << num_pairs << "," << insert_seconds << ","
+            << search_seconds << "," << serialize_seconds << ","
+            << deserialize_seconds << "\n";
+  }
+
+  std::remove(data_file.c_str());
+  outFile.close();
+  std::cout << "结果已保存到 string_keys_performance.csv" << std::endl;
+}
+
+int main() {
+  test_bplus_tree_string_keys();
+  std::cout << "字符串key测试通过！" << std::endl;
+  return 0;
+}
@@ -1,95 +1,200 @@
 #include "../include/BplusTree.h" // 假设你的B+树类定义在此头文件中
+#include <atomic>
 #include <cassert>
 #include <chrono>
+#include <cstdint>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <random>
+#include <string>
 #include <thread>
 #include <vector>
 
-void concurrent_insert(BplusTree<int, int> &tree, int thread_id,
-                       int num_inserts, std::random_device &rd,
-                       std::mt19937 &gen,
-                       std::uniform_int_distribution<> &key_dist,
-                       int &progress) {
-  (void)gen;
-  std::mt19937 local_gen(rd());     // 每个线程有独立的随机数生成器
-  local_gen.seed(rd() + thread_id); // 避免种子冲突
-  for (int i = 0; i < num_inserts; ++i) {
+// 并发扩展性测试：固定总操作数，线程数从1递增，
+// 分别测量纯插入、纯查询、读多写少(90%查询 + 10%插入)三种负载的吞吐和加速比
+
+const int total_ops = 3'000'000;     // 每种负载的总操作数
+const int preload_keys = 1'000'000;  // 查询类负载预先插入的键数
+const int key_range = 1'000'000'000; // 随机键1到10亿
+
+// 值取key*10，用64位避免溢出
+using Tree = BplusTree<int, int64_t>;
+
+// 每个线程有独立的随机数生成器，避免种子冲突
+std::mt19937 make_gen(int thread_id, int round) {
+  return std::mt19937(
+      static_cast<unsigned>(thread_id * 7919 + round * 31 + 1));
+}
+
+void concurrent_insert(Tree &tree, int thread_id, int num_ops,
+                       std::atomic<int> &progress) {
+  std::mt19937 local_gen = make_gen(thread_id, 0);
+  std::uniform_int_distribution<> key_dist(1, key_range);
+  for (int i = 0; i < num_ops; ++i) {
     int key = key_dist(local_gen);
-    int value = key * 10;
-    tree.insert(key, value);                 // 依赖内部锁
+    int64_t value = int64_t{key} * 10;
+    tree.insert(key, value); // 依赖内部锁
     if (thread_id == 0 && i % 30'000 == 0) { // 只由主线程更新进度
-      progress += 30'000;
-      if (progress % 3'00'000 == 0) {
-        std::cout << "已插入 " << progress << " 个键值对" << std::endl;
+      int done = progress.fetch_add(30'000) + 30'000;
+      if (done % 3'00'000 == 0) {
+        std::cout << "已插入 " << done << " 个键值对" << std::endl;
       }
     }
   }
 }
 
-void test_bplus_tree_concurrent_insert() {
-  const int total_inserts = 3'000'000; // 总插入数量
-  std::random_device rd;
-  std::mt19937 gen(rd());
-  std::uniform_int_distribution<> key_dist(1, 1'000'000'000); // 随机键1到10亿
+void concurrent_search(Tree &tree, int thread_id, int num_ops,
+                       const std::vector<int> &keys,
+                       std::atomic<long> &found) {
+  std::mt19937 local_gen = make_gen(thread_id, 1);
+  std::uniform_int_distribution<size_t> index_dist(0, keys.size() - 1);
+  std::uniform_int_distribution<> key_dist(1, key_range);
+  long hits = 0;
+  for (int i = 0; i < num_ops; ++i) {
+    // 一半查已存在的键，一半查随机键
+    int key = i % 2 == 0 ? keys[index_dist(local_gen)] : key_dist(local_gen);
+    hits += tree.search(key) != 0;
+  }
+  found += hits;
+}
 
-  // 打开文件以写入结果
-  std::ofstream outFile("./concurrent_insert_performance.csv");
-  if (!outFile) {
-    std::cerr << "无法创建文件 concurrent_insert_performance.csv" << std::endl;
-    return;
+void concurrent_mixed(Tree &tree, int thread_id, int num_ops,
+                      std::atomic<long> &found) {
+  std::mt19937 local_gen = make_gen(thread_id, 2);
+  std::uniform_int_distribution<> key_dist(1, key_range);
+  long hits = 0;
+  for (int i = 0; i < num_ops; ++i) {
+    int key = key_dist(local_gen);
+    if (i % 10 == 0) {
+      tree.insert(key, int64_t{key} * 10);
+    } else {
+      hits += tree.search(key) != 0;
+    }
   }
-  outFile << "Degree,MaxKeys,Threads,TotalTime(s),InsertionsPerSecond\n";
+  found += hits;
+}
 
-  const int degree = 4; // 固定度数为4
-  std::cout << "\n测试度数: " << degree << " (maxKeys=" << degree - 1 << ")"
-            << std::endl;
+// 预加载，返回插入的键供查询线程抽样
+std::vector<int> preload(Tree &tree) {
+  std::mt19937 key_gen(12345);
+  std::uniform_int_distribution<> key_dist(1, key_range);
+  std::vector<int> keys(preload_keys);
+  for (int &key : keys) {
+    key = key_dist(key_gen);
+    tree.insert(key, int64_t{key} * 10);
+  }
+  return keys;
+}
 
-  // 测试 1 到 24 线程
-  for (int num_threads = 1; num_threads <= 16; ++num_threads) {
-    BplusTree<int, int> tree(degree); // 创建新树实例
-    std::vector<std::thread> threads;
-    int inserts_per_thread = total_inserts / num_threads;
-    int progress = 0;
-
-    auto start_time = std::chrono::high_resolution_clock::now();
-
-    // 启动线程，使用 lambda 封装
-    for (int i = 0; i < num_threads; ++i) {
-      threads.emplace_back([=, &tree, &rd, &gen, &key_dist, &progress]() {
-        concurrent_insert(tree, i, inserts_per_thread, rd, gen, key_dist,
-                          progress);
-      });
-    }
+// 启动num_threads个线程平分total_ops，返回耗时(秒)
+double run_threads(int num_threads,
+                   const std::function<void(int, int)> &thread_body) {
+  std::vector<std::thread> threads;
+  int ops_per_thread = total_ops / num_threads;
 
-    // 等待所有线程完成
-    for (auto &t : threads) {
-      t.join();
-    }
+  auto start_time = std::chrono::high_resolution_clock::now();
 
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        end_time - start_time);
-    double duration_seconds = duration_ms.count() / 1000.0;
-    int insertions_per_second =
-        static_cast<int>(total_inserts / duration_seconds);
+  // 启动线程，使用 lambda 封装
+  for (int i = 0; i < num_threads; ++i) {
+    threads.emplace_back(
+        [=, &thread_body]() { thread_body(i, ops_per_thread); });
+  }
 
-    std::cout << "线程数: " << num_threads << " 插入完成！" << std::endl;
-    std::cout << "总耗时: " << duration_seconds << " 秒" << std::endl;
-    std::cout << "平均每秒插入: " << insertions_per_second << " 次"
+  // 等待所有线程完成
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  auto end_time = std::chrono::high_resolution_clock::now();
+  auto duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+      end_time - start_time);
+  return duration_ms.count() / 1000.0;
+}
+
+void test_bplus_tree_concurrent_scaling() {
+  // 插入结果沿用原有文件格式
+  std::ofstream insertFile("./concurrent_insert_performance.csv");
+  std::ofstream outFile("./concurrent_scaling_performance.csv");
+  if (!insertFile || !outFile) {
+    std::cerr << "无法创建结果文件" << std::endl;
+    return;
+  }
+  insertFile << "Degree,MaxKeys,Threads,TotalTime(s),InsertionsPerSecond\n";
+  outFile << "Workload,Degree,Threads,TotalTime(s),OpsPerSecond,Speedup\n";
+
+  unsigned hw_threads = std::thread::hardware_concurrency();
+  std::cout << "硬件线程数: " << hw_threads << std::endl;
+
+  // 线程数按2的幂递增到16
+  std::vector<int> thread_counts = {1, 2, 4, 8, 16};
+
+  for (int degree : {4, 64}) {
+    std::cout << "\n测试度数: " << degree << " (maxKeys=" << degree - 1 << ")"
               << std::endl;
 
-    outFile << degree << "," << (degree - 1) << "," << num_threads << ","
-            << duration_seconds << "," << insertions_per_second << "\n";
+    const char *workloads[] = {"insert", "search", "mixed"};
+    for (const char *workload : workloads) {
+      std::string name = workload;
+      double base_ops = 0;
+
+      for (int num_threads : thread_counts) {
+        Tree tree(degree); // 创建新树实例
+        std::atomic<int> progress{0};
+        std::atomic<long> found{0};
+
+        double duration_seconds = 0;
+        if (name == "insert") {
+          duration_seconds = run_threads(num_threads, [&](int id, int ops) {
+            concurrent_insert(tree, id, ops, progress);
+          });
+        } else {
+          std::vector<int> keys = preload(tree);
+          duration_seconds = run_threads(num_threads, [&](int id, int ops) {
+            if (name == "search") {
+              concurrent_search(tree, id, ops, keys, found);
+            } else {
+              concurrent_mixed(tree, id, ops, found);
+            }
+          });
+        }
+
+        double ops_per_second = total_ops / duration_seconds;
+        if (num_threads == 1) {
+          base_ops = ops_per_second;
+        }
+        double speedup = ops_per_second / base_ops;
+
+        std::cout << name << " 线程数: " << num_threads
+                  << " 总耗时: " << duration_seconds << " 秒"
+                  << " 每秒操作: " << static_cast<long>(ops_per_second)
+                  << " 次 加速比: " << speedup;
+        if (name != "insert") {
+          std::cout << " 命中: " << found.load();
+        }
+        std::cout << std::endl;
+
+        outFile << name << "," << degree << "," << num_threads << ","
+                << duration_seconds << "," << static_cast<long>(ops_per_second)
+                << "," << speedup << "\n";
+        if (name == "insert") {
+          insertFile << degree << "," << (degree - 1) << "," << num_threads
+                     << "," << duration_seconds << ","
+                     << static_cast<int>(ops_per_second) << "\n";
+        }
+      }
+    }
   }
 
+  insertFile.close();
   outFile.close();
-  std::cout << "结果已保存到 concurrent_insert_performance.csv" << std::endl;
+  std::cout << "结果已保存到 concurrent_insert_performance.csv 和 "
+               "concurrent_scaling_performance.csv"
+            << std::endl;
 }
 
 int main() {
-  test_bplus_tree_concurrent_insert();
-  std::cout << "并发插入测试通过！" << std::endl;
+  test_bplus_tree_concurrent_scaling();
+  std::cout << "并发扩展性测试通过！" << std::endl;
   return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,83 @@
+#include "../include/BplusTree.h" // 假设你的B+树类定义在此头文件中
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// 预写日志测试：不同写线程数下开启日志逐个插入，
+// 统计吞吐和fsync次数(组提交使多个写者共享一次fsync)，
+// 最后用新树重放日志，检查恢复出的键值对与原树一致
+
+double elapsed_seconds(std::chrono::high_resolution_clock::time_point start) {
+  auto end_time = std::chrono::high_resolution_clock::now();
+  auto duration_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(end_time - start);
+  return duration_us.count() / 1e6;
+}
+
+void test_bplus_tree_wal() {
+  const int num_pairs = 40'000; // 每轮插入的键值对总数
+  const std::string log_file = "./bplustree.wal";
+
+  std::ofstream outFile("./wal_performance.csv");
+  if (!outFile) {
+    std::cerr << "无法创建文件 wal_performance.csv" << std::endl;
+    return;
+  }
+  outFile << "Threads,TotalTime(s),InsertsPerSecond,Syncs,InsertsPerSync\n";
+
+  for (int num_threads : {1, 2, 4, 8, 16}) {
+    std::remove(log_file.c_str());
+    BplusTree<int, uint64_t> tree(64);
+    tree.openWal(log_file);
+
+    const int per_thread = num_pairs / num_threads;
+    std::vector<std::thread> threads;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (int t = 0; t < num_threads; ++t) {
+      threads.emplace_back([&tree, t, per_thread] {
+        for (int i = 0; i < per_thread; ++i) {
+          int key = t * per_thread + i;
+          tree.insert(key, static_cast<uint64_t>(key) * 3);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    double seconds = elapsed_seconds(start_time);
+    uint64_t syncs = tree.walSyncs();
+    int inserted = per_thread * num_threads;
+
+    std::cout << "线程数: " << num_threads << " 总耗时: " << seconds
+              << " 秒 每秒插入: " << static_cast<long>(inserted / seconds)
+              << " 次 fsync: " << syncs << " 次" << std::endl;
+    outFile << num_threads << "," << seconds << ","
+            << static_cast<long>(inserted / seconds) << "," << syncs << ","
+            << static_cast<double>(inserted) / syncs << "\n";
+
+    // 恢复：新树重放整个日志
+    BplusTree<int, uint64_t> recovered(64);
+    start_time = std::chrono::high_resolution_clock::now();
+    size_t replayed = recovered.openWal(log_file);
+    double replay_seconds = elapsed_seconds(start_time);
+    assert(replayed == static_cast<size_t>(inserted));
+    assert(recovered.rangeSearch(0, num_pairs) ==
+           tree.rangeSearch(0, num_pairs));
+    std::cout << "  重放 " << replayed << " 条记录 耗时: " << replay_seconds
+              << " 秒" << std::endl;
+  }
+
+  std::remove(log_file.c_str());
+  outFile.close();
+  std::cout << "结果已保存到 wal_performance.csv" << std::endl;
+}
+
+int main() {
+  test_bplus_tree_wal();
+  std::cout << "预写日志测试通过！" << std::endl;
+  return 0;
+}